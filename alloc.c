@@ -1,21 +1,175 @@
 #include "header.h"
+#include "compilerContext.h"
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-extern int linenumber;
 
-AST_NODE *Allocate (AST_TYPE type) {
+// arena
+//
+// the AST, its constants and the symbol table live until code generation is
+// done, so they are carved out of big chunks and released all at once by
+// arenaRelease() instead of being malloc'ed and never freed one by one
+//
+// every thread has an arena of its own, so the lexer thread doesn't need a
+// lock; it hands its chunks over with arenaDetach() and arenaAttach()
+
+#define ARENA_CHUNK_SIZE (64 * 1024)
+
+typedef struct ArenaChunk {
+    struct ArenaChunk *next;
+    size_t used;
+    size_t size;
+    max_align_t data[];
+} ArenaChunk;
+
+static _Thread_local ArenaChunk *arena = NULL;
+// emptied chunks arenaReset() kept for the next compilation
+static _Thread_local ArenaChunk *spareChunks = NULL;
+static _Thread_local int spareCount = 0;
+
+// what arenaReset() keeps, 4MB
+#define ARENA_SPARE_CHUNKS 64
+
+
+static ArenaChunk *newArenaChunk (size_t size) {
+    ArenaChunk *chunk = (ArenaChunk *)malloc(sizeof(ArenaChunk) + size);
+    if (!chunk) {
+        printf("out of memory\n");
+        exit(1);
+    }
+    chunk->used = 0;
+    chunk->size = size;
+    return chunk;
+}
+
+
+// `align` is a power of two
+static void *arenaAllocAligned (size_t size, size_t align) {
+    ArenaChunk *chunk = arena;
+    size_t start = chunk ? (chunk->used + align - 1) & ~(align - 1) : 0;
+
+    if (chunk == NULL || start > chunk->size || chunk->size - start < size) {
+        if (size > ARENA_CHUNK_SIZE / 4) {
+            // a chunk of its own, behind the current one so that the rest
+            // of the current chunk still gets used
+            chunk = newArenaChunk(size);
+            if (arena) {
+                chunk->next = arena->next;
+                arena->next = chunk;
+            }
+            else {
+                chunk->next = NULL;
+                arena = chunk;
+            }
+        }
+        else {
+            if (spareChunks) {
+                chunk = spareChunks;
+                spareChunks = chunk->next;
+                spareCount--;
+            }
+            else
+                chunk = newArenaChunk(ARENA_CHUNK_SIZE);
+            chunk->next = arena;
+            arena = chunk;
+        }
+        start = 0;
+    }
+
+    chunk->used = start + size;
+    return (char *)chunk->data + start;
+}
+
+
+void *arenaAlloc (size_t size) {
+    return arenaAllocAligned(size, _Alignof(max_align_t));
+}
+
+
+// strings need no alignment
+char *arenaStrdup (const char *str) {
+    size_t length = strlen(str) + 1;
+    return (char *)memcpy(arenaAllocAligned(length, 1), str, length);
+}
+
+
+void *arenaDetach (void) {
+    ArenaChunk *chunks = arena;
+    arena = NULL;
+    return chunks;
+}
+
+
+// behind the current chunk, whose free space is still used
+void arenaAttach (void *chunks) {
+    ArenaChunk *last = (ArenaChunk *)chunks;
+
+    if (last == NULL) {
+        return;
+    }
+    if (arena == NULL) {
+        arena = last;
+        return;
+    }
+    while (last->next) {
+        last = last->next;
+    }
+    last->next = arena->next;
+    arena->next = (ArenaChunk *)chunks;
+}
+
+
+void arenaRelease (void) {
+    arenaReset();
+    while (spareChunks) {
+        ArenaChunk *next = spareChunks->next;
+        free(spareChunks);
+        spareChunks = next;
+    }
+    spareCount = 0;
+}
+
+
+// the chunks of the usual size are emptied and kept, up to
+// ARENA_SPARE_CHUNKS, so that a thread that compiles one program after
+// another doesn't go back to malloc() for every one
+void arenaReset (void) {
+    while (arena) {
+        ArenaChunk *next = arena->next;
+        if (arena->size == ARENA_CHUNK_SIZE && spareCount < ARENA_SPARE_CHUNKS) {
+            arena->used = 0;
+            arena->next = spareChunks;
+            spareChunks = arena;
+            spareCount++;
+        }
+        else
+            free(arena);
+        arena = next;
+    }
+}
+
+
+AST_NODE *Allocate (CompilerContext *ctx, AST_TYPE type) {
     AST_NODE *temp;
-    temp = (AST_NODE *)malloc(sizeof(struct AST_NODE));
+    temp = (AST_NODE *)arenaAlloc(sizeof(struct AST_NODE));
 
+    // the passes read the semantic value of nodes that never got one, which
+    // must be zero rather than what an earlier compilation left in the chunk
+    memset(temp, 0, sizeof(struct AST_NODE));
     temp->nodeType = type;
     temp->dataType = NONE_TYPE;
 
-    temp->child = NULL;
-    temp->rightSibling = NULL;
-    temp->parent = NULL;
-
     // Notice that leftmostSibling is not initialized as NULL
     temp->leftmostSibling = temp;
-    temp->linenumber = linenumber;
+    temp->linenumber = ctx->linenumber;
     return temp;
 }
+
+
+void compileFailed (CompilerContext *ctx, const char *message) {
+    fprintf(ctx->diagnostics, "%s\n", message);
+    if (ctx->failed == NULL)
+        exit(1);
+    longjmp(*ctx->failed, 1);
+}
@@ -0,0 +1,128 @@
+#ifndef __AST_BUILDER_H__
+#define __AST_BUILDER_H__
+
+#include <stdio.h>
+#include <stdarg.h>
+
+#include "header.h"
+
+
+// the AST node constructors shared by the bison grammar in parser.y and the
+// recursive descent parser in descentParser.c, so both build the same tree
+
+// lists are built left to right and passed around by their last node. while
+// a list grows only its last node's leftmostSibling points at the head; the
+// leftmostSibling and parent of every node are fixed up once, when the list
+// is hung under its parent, so appending to a list is O(1)
+
+static inline void adoptSiblings (AST_NODE *first, AST_NODE *parent, AST_NODE *head) {
+    while (first) {
+        first->parent = parent;
+        first->leftmostSibling = head;
+        first = first->rightSibling;
+    }
+}
+
+
+static inline AST_NODE *makeSibling (AST_NODE *a, AST_NODE *b) {
+    AST_NODE *head;
+    AST_NODE *first;
+
+    // both are already the last nodes of their lists in the grammar's uses
+    while (a->rightSibling) {
+        a = a->rightSibling;
+    }
+    if (b == NULL) {
+        return a;
+    }
+    while (b->rightSibling) {
+        b = b->rightSibling;
+    }
+
+    head = a->leftmostSibling;
+    first = b->leftmostSibling;
+    a->rightSibling = first;
+    b->leftmostSibling = head;
+
+    // `a` already has a parent, `b` is joining its children
+    if (a->parent) {
+        adoptSiblings(first, a->parent, head);
+    }
+    return b;
+}
+
+
+static inline AST_NODE *makeChild (AST_NODE *parent, AST_NODE *child) {
+    if (child == NULL) {
+        return parent;
+    }
+    if (parent->child) {
+        makeSibling(parent->child, child);
+    }
+    else {
+        while (child->rightSibling) {
+            child = child->rightSibling;
+        }
+        parent->child = child->leftmostSibling;
+        adoptSiblings(parent->child, parent, parent->child);
+    }
+    return parent;
+}
+
+
+static inline AST_NODE *makeFamily(AST_NODE *parent, int childrenCount, ...) {
+    va_list childrenList;
+    va_start(childrenList, childrenCount);
+    AST_NODE *child = va_arg(childrenList, AST_NODE *);
+    makeChild(parent, child);
+    AST_NODE *tmp = child;
+    int index = 1;
+    for (index = 1; index < childrenCount; ++index) {
+        child = va_arg(childrenList, AST_NODE *);
+        tmp = makeSibling(tmp, child);
+    }
+    va_end(childrenList);
+    return parent;
+}
+
+
+static inline AST_NODE *makeIDNode(CompilerContext *ctx, char *lexeme, IDENTIFIER_KIND idKind) {
+    AST_NODE *identifier = Allocate(ctx, IDENTIFIER_NODE);
+    identifier->semantic_value.identifierSemanticValue.identifierName = lexeme;
+    identifier->semantic_value.identifierSemanticValue.kind = idKind;
+    identifier->semantic_value.identifierSemanticValue.symbolTableEntry = NULL;
+    return identifier;
+}
+
+
+static inline AST_NODE *makeStmtNode(CompilerContext *ctx, STMT_KIND stmtKind) {
+    AST_NODE *stmtNode = Allocate(ctx, STMT_NODE);
+    stmtNode->semantic_value.stmtSemanticValue.kind = stmtKind;
+    return stmtNode;
+}
+
+
+static inline AST_NODE *makeDeclNode(CompilerContext *ctx, DECL_KIND declKind) {
+    AST_NODE *declNode = Allocate(ctx, DECLARATION_NODE);
+    declNode->semantic_value.declSemanticValue.kind = declKind;
+    return declNode;
+}
+
+static inline AST_NODE *makeExprNode(CompilerContext *ctx, EXPR_KIND exprKind, int operationEnumValue) {
+    AST_NODE *exprNode = Allocate(ctx, EXPR_NODE);
+    exprNode->semantic_value.exprSemanticValue.isConstEval = 0;
+    exprNode->semantic_value.exprSemanticValue.kind = exprKind;
+    if (exprKind == BINARY_OPERATION) {
+        exprNode->semantic_value.exprSemanticValue.op.binaryOp = operationEnumValue;
+    }
+    else if (exprKind == UNARY_OPERATION) {
+        exprNode->semantic_value.exprSemanticValue.op.unaryOp = operationEnumValue;
+    }
+    else {
+        printf("Error in makeExprNode(EXPR_KIND exprKind, int operationEnumValue)\n");
+    }
+    return exprNode;
+}
+
+
+#endif // __AST_BUILDER_H__
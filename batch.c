@@ -0,0 +1,285 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "header.h"
+#include "batch.h"
+#include "passTimer.h"
+#include "compilerContext.h"
+
+
+// the files are sorted largest first and dealt out round robin to one queue
+// per worker, so every queue is largest first too. a worker compiles the
+// front of its own queue, and once that is empty steals the largest file
+// left in any other queue; the big files start early and the small ones
+// fill up the gaps at the end. a queue is only locked to take one file, and
+// a compilation takes far longer than that, so a lock per queue is enough
+//
+// a file's messages are collected in memory and printed when all of them
+// are done, in the order of the command line, so they don't interleave.
+// passTimer.c keeps one table for the process, so the workers don't time
+// passes; --time-passes prints a table of the files instead
+
+
+typedef struct BatchJob {
+    const char *source;
+    char *outputPath;
+    long long size;
+    char *messages;           // open_memstream()
+    size_t messagesLength;
+    int failed;
+    int errorCount;
+    double seconds;
+} BatchJob;
+
+
+typedef struct BatchQueue {
+    pthread_mutex_t lock;
+    BatchJob **jobs;
+    int front;
+    int count;
+} BatchQueue;
+
+
+typedef struct Batch {
+    const CompilerContext *options;
+    BatchQueue *queues;
+    int queueCount;
+} Batch;
+
+
+typedef struct Worker {
+    Batch *batch;
+    int self;
+    pthread_t thread;
+} Worker;
+
+
+static double wallClock (void) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+
+static void *allocateOrDie (size_t size) {
+    void *p = malloc(size);
+    if (!p) {
+        printf("out of memory\n");
+        exit(1);
+    }
+    return p;
+}
+
+
+// a.c into a.s, anything else gets .s appended
+static char *outputPathOf (const char *source) {
+    size_t length = strlen(source);
+    char *path = (char *)allocateOrDie(length + 3);
+
+    memcpy(path, source, length + 1);
+    if (length > 2 && strcmp(source + length - 2, ".c") == 0)
+        length -= 2;
+    strcpy(path + length, ".s");
+    return path;
+}
+
+
+// largest first, in command line order among equals
+static int largerFirst (const void *a, const void *b) {
+    const BatchJob *x = *(BatchJob *const *)a;
+    const BatchJob *y = *(BatchJob *const *)b;
+
+    if (x->size != y->size)
+        return x->size > y->size ? -1 : 1;
+    return x < y ? -1 : x > y;
+}
+
+
+// the front of `queue` if it is larger than `best`, which it then becomes
+static BatchJob *takeLarger (BatchQueue *queue, long long *best) {
+    BatchJob *job = NULL;
+
+    pthread_mutex_lock(&queue->lock);
+    if (queue->front < queue->count && queue->jobs[queue->front]->size > *best) {
+        job = queue->jobs[queue->front];
+        *best = job->size;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return job;
+}
+
+
+static BatchJob *takeFront (BatchQueue *queue, BatchJob *expected) {
+    BatchJob *job = NULL;
+
+    pthread_mutex_lock(&queue->lock);
+    if (queue->front < queue->count &&
+        (expected == NULL || queue->jobs[queue->front] == expected)) {
+        job = queue->jobs[queue->front++];
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return job;
+}
+
+
+// the worker's own next file, or the largest one another worker hasn't
+// started yet, NULL when everything is taken
+static BatchJob *nextJob (Worker *worker) {
+    Batch *batch = worker->batch;
+    BatchJob *job = takeFront(&batch->queues[worker->self], NULL);
+
+    while (job == NULL) {
+        BatchJob *largest = NULL;
+        int victim = -1;
+        long long best = -2;
+        int i;
+
+        for (i = 0; i < batch->queueCount; ++i) {
+            BatchJob *front = takeLarger(&batch->queues[i], &best);
+            if (front) {
+                largest = front;
+                victim = i;
+            }
+        }
+        if (largest == NULL)
+            return NULL;
+        // somebody else may have taken it meanwhile, then look again
+        job = takeFront(&batch->queues[victim], largest);
+    }
+    return job;
+}
+
+
+static void compileJob (const CompilerContext *options, BatchJob *job) {
+    CompilerContext context = *options;
+    double start = wallClock();
+
+    context.outputPath = job->outputPath;
+    context.reuseArena = 1;
+    context.diagnostics = open_memstream(&job->messages, &job->messagesLength);
+    if (context.diagnostics == NULL) {
+        printf("out of memory\n");
+        exit(1);
+    }
+    job->failed = compileFile(&context, job->source) != 0 || context.anyErrorOccur;
+    job->errorCount = context.errorCount;
+    fclose(context.diagnostics);
+    job->seconds = wallClock() - start;
+}
+
+
+static void *runWorker (void *arg) {
+    Worker *worker = (Worker *)arg;
+    BatchJob *job;
+
+    while ((job = nextJob(worker)) != NULL)
+        compileJob(worker->batch->options, job);
+    arenaRelease();
+    return NULL;
+}
+
+
+static void reportFiles (FILE *out, BatchJob **bySize, int fileCount, double wall) {
+    double total = 0;
+    int i;
+
+    fprintf(out, "%-32s %10s %10s %7s\n", "file", "size KB", "wall ms", "errors");
+    for (i = 0; i < fileCount; ++i) {
+        BatchJob *job = bySize[i];
+        fprintf(out, "%-32s %10.1f %10.3f %7d\n", job->source,
+                job->size < 0 ? 0.0 : job->size / 1024.0, job->seconds * 1e3, job->errorCount);
+        total += job->seconds;
+    }
+    fprintf(out, "%-32s %10s %10.3f\n", "total", "", total * 1e3);
+    fprintf(out, "%-32s %10s %10.3f %6.2fx\n", "wall", "", wall * 1e3, wall > 0 ? total / wall : 0.0);
+}
+
+
+int compileBatch (const CompilerContext *options, char **files, int fileCount, int threads) {
+    BatchJob *jobs = (BatchJob *)allocateOrDie(fileCount * sizeof(BatchJob));
+    BatchJob **bySize = (BatchJob **)allocateOrDie(fileCount * sizeof(BatchJob *));
+    Worker *workers;
+    Batch batch;
+    int timeFiles = timePasses;
+    int failed = 0;
+    int errors = 0;
+    double start;
+    int i;
+
+    if (threads > fileCount)
+        threads = fileCount;
+    timePasses = 0;
+    start = wallClock();
+
+    for (i = 0; i < fileCount; ++i) {
+        struct stat status;
+        jobs[i].source = files[i];
+        jobs[i].outputPath = outputPathOf(files[i]);
+        jobs[i].size = stat(files[i], &status) == 0 ? (long long)status.st_size : -1;
+        jobs[i].messages = NULL;
+        jobs[i].messagesLength = 0;
+        bySize[i] = &jobs[i];
+    }
+    qsort(bySize, fileCount, sizeof(BatchJob *), largerFirst);
+
+    // file i goes to queue i % threads, which keeps every queue sorted
+    batch.options = options;
+    batch.queueCount = threads;
+    batch.queues = (BatchQueue *)allocateOrDie(threads * sizeof(BatchQueue));
+    for (i = 0; i < threads; ++i) {
+        pthread_mutex_init(&batch.queues[i].lock, NULL);
+        batch.queues[i].jobs = (BatchJob **)allocateOrDie((fileCount / threads + 1) * sizeof(BatchJob *));
+        batch.queues[i].front = 0;
+        batch.queues[i].count = 0;
+    }
+    for (i = 0; i < fileCount; ++i) {
+        BatchQueue *queue = &batch.queues[i % threads];
+        queue->jobs[queue->count++] = bySize[i];
+    }
+
+    workers = (Worker *)allocateOrDie(threads * sizeof(Worker));
+    for (i = 0; i < threads; ++i) {
+        workers[i].batch = &batch;
+        workers[i].self = i;
+        if (pthread_create(&workers[i].thread, NULL, runWorker, &workers[i]) != 0) {
+            printf("cannot start worker thread %d\n", i);
+            exit(1);
+        }
+    }
+    for (i = 0; i < threads; ++i)
+        pthread_join(workers[i].thread, NULL);
+
+    for (i = 0; i < fileCount; ++i) {
+        if (jobs[i].messagesLength > 0)
+            printf("%s:\n%s", jobs[i].source, jobs[i].messages);
+        failed += jobs[i].failed;
+        errors += jobs[i].errorCount;
+    }
+    printf("%d files on %d threads: %d compiled, %d failed, %d errors\n",
+           fileCount, threads, fileCount - failed, failed, errors);
+    if (timeFiles) {
+        fflush(stdout);
+        reportFiles(stderr, bySize, fileCount, wallClock() - start);
+    }
+    timePasses = timeFiles;
+
+    for (i = 0; i < threads; ++i) {
+        pthread_mutex_destroy(&batch.queues[i].lock);
+        free(batch.queues[i].jobs);
+    }
+    for (i = 0; i < fileCount; ++i) {
+        free(jobs[i].outputPath);
+        free(jobs[i].messages);
+    }
+    free(batch.queues);
+    free(workers);
+    free(bySize);
+    free(jobs);
+    return failed;
+}
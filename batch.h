@@ -0,0 +1,14 @@
+#ifndef __BATCH_H__
+#define __BATCH_H__
+#include "header.h"
+
+
+// -j: compile `files` on up to `threads` threads, each file into the .s next
+// to it (a.c into a.s), every one starting from a copy of `options`, a
+// context with nothing compiled yet. prints the messages of every file and
+// a summary, with --time-passes also a table of the files. returns the
+// number of files that failed
+int compileBatch (const CompilerContext *options, char **files, int fileCount, int threads);
+
+
+#endif // __BATCH_H__
@@ -0,0 +1,64 @@
+#!/bin/sh
+# check that -j gives every file the same assembly as compiling it on its
+# own, with two copies of each file in one process so that every compilation
+# after the first runs on memory an earlier one used; a file with errors
+# must get no .s and the batch must get to its summary
+#
+# usage: bench/batchcheck.sh [file.c ...]
+
+PARSER=${PARSER:-./parser}
+CMMGEN=${CMMGEN:-./cmmgen}
+
+work=$(mktemp -d "${TMPDIR:-/tmp}/cmm-batchcheck.XXXXXX") || exit 1
+trap 'rm -rf "$work"' EXIT
+PARSER=$(cd "$(dirname "$PARSER")" && pwd)/$(basename "$PARSER")
+
+if [ $# -eq 0 ]; then
+    for seed in 1 2 3; do
+        "$CMMGEN" --functions 20 --statements 2000 --seed $seed > "$work/gen$seed.c" || exit 1
+    done
+    set -- pattern/*.c bench/*.c "$work"/gen*.c
+fi
+
+status=0
+mkdir "$work/solo" "$work/batch"
+i=0
+for src in "$@"; do
+    i=$((i + 1))
+    cp "$src" "$work/batch/$i-a.c"
+    cp "$src" "$work/batch/$i-b.c"
+    rm -f "$work/solo/output.s"
+    if (cd "$work/solo" && "$PARSER" "$work/batch/$i-a.c" > messages) 2>/dev/null &&
+       grep -q "No errors found" "$work/solo/messages"; then
+        mv "$work/solo/output.s" "$work/solo/$i.s"
+    fi
+done
+
+for threads in 1 4; do
+    rm -f "$work"/batch/*.s
+    (cd "$work/batch" && "$PARSER" -j $threads $(ls *-a.c | sort -n) $(ls *-b.c | sort -n)) > "$work/batch.out" 2>&1
+    if ! grep -q "^$((i * 2)) files on $threads threads" "$work/batch.out"; then
+        echo "batchcheck: -j $threads didn't finish" >&2
+        tail -5 "$work/batch.out" >&2
+        status=1
+        continue
+    fi
+    k=0
+    for src in "$@"; do
+        k=$((k + 1))
+        for copy in a b; do
+            if [ -f "$work/solo/$k.s" ]; then
+                if ! cmp -s "$work/solo/$k.s" "$work/batch/$k-$copy.s"; then
+                    echo "batchcheck: $src: -j $threads gives other code (copy $copy)" >&2
+                    status=1
+                fi
+            elif [ -f "$work/batch/$k-$copy.s" ]; then
+                echo "batchcheck: $src: -j $threads writes code for a file with errors" >&2
+                status=1
+            fi
+        done
+    done
+done
+
+[ $status -eq 0 ] && echo "batchcheck: $i files, twice each, same code"
+exit $status
@@ -0,0 +1,34 @@
+#!/bin/sh
+# compare two result files from bench/run.sh, e.g. the checked in baseline
+# with a new run, and print the change of every count
+#
+# usage: bench/compare.sh bench/baseline.tsv bench/results.tsv
+
+if [ $# -ne 2 ]; then
+    echo "usage: $0 baseline.tsv results.tsv" >&2
+    exit 2
+fi
+
+awk -F'\t' '
+    FNR == 1 {
+        for (i = 2; i <= NF; ++i)
+            metric[i] = $i
+        columns = NF
+        next
+    }
+    NR == FNR {
+        for (i = 2; i <= NF; ++i)
+            base[$1, i] = $i
+        next
+    }
+    {
+        for (i = 2; i <= columns; ++i) {
+            if (($1, i) in base && base[$1, i] > 0)
+                change = sprintf("%+.2f%%", 100.0 * ($i - base[$1, i]) / base[$1, i])
+            else if (($1, i) in base)
+                change = $i == base[$1, i] ? "+0.00%" : "n/a"
+            else
+                change = "new"
+            printf "%-12s %-13s %12s -> %12s  %s\n", $1, metric[i], (($1, i) in base) ? base[$1, i] : "-", $i, change
+        }
+    }' "$1" "$2"
@@ -0,0 +1,45 @@
+float x, y, s, h, guess;
+int i, n;
+
+int main() {
+    /* integrate 4 / (1 + x * x) over [0, 1] */
+    n = 4000;
+    h = 1.0 / n;
+    s = 0.0;
+    i = 0;
+    while (i < n) {
+        x = (i + 0.5) * h;
+        s = s + 4.0 / (1.0 + x * x);
+        i = i + 1;
+    }
+    write(s * h);
+    write("\n");
+
+    /* Newton's method for square roots */
+    i = 1;
+    s = 0.0;
+    while (i <= 500) {
+        y = i * 1.0;
+        guess = y / 2.0 + 1.0;
+        n = 0;
+        while (n < 12) {
+            guess = (guess + y / guess) * 0.5;
+            n = n + 1;
+        }
+        s = s + guess;
+        i = i + 1;
+    }
+    write(s);
+    write("\n");
+
+    /* a polynomial with many constant terms */
+    x = 0.0;
+    s = 0.0;
+    while (x < 10.0) {
+        s = s + ((((0.5 * x - 1.25) * x + 2.5) * x - 0.75) * x + 1.0) / (1.0 + x * x * 0.25);
+        x = x + 0.01;
+    }
+    write(s);
+    write("\n");
+    return 0;
+}
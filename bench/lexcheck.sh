@@ -0,0 +1,69 @@
+#!/bin/sh
+# check that the hand written scanner (parser-hand) gives the same tokens,
+# values and line numbers as the flex one (parser), and that both give the
+# same with --threaded-lexer, on the given files or on pattern/*.c, bench/*.c,
+# a few cmmgen programs and inputs made to trip it
+#
+# usage: bench/lexcheck.sh [file.c ...]
+
+PARSER=${PARSER:-./parser}
+HAND=${HAND:-./parser-hand}
+CMMGEN=${CMMGEN:-./cmmgen}
+
+work=$(mktemp -d "${TMPDIR:-/tmp}/cmm-lexcheck.XXXXXX") || exit 1
+trap 'rm -rf "$work"' EXIT
+
+if [ $# -eq 0 ]; then
+    for seed in 1 2 3; do
+        "$CMMGEN" --functions 20 --statements 200 --seed $seed > "$work/gen$seed.c" || exit 1
+    done
+
+    # blank runs and comments longer than a vector, terminators and
+    # newlines on either side of a vector boundary, numbers, lone
+    # characters and unterminated comments and strings
+    printf 'int a;%64s/*%40s*/\n' "" "" > "$work/tricky1.c"
+    printf '/*\n\n*\n**\n***/ x /* ***** / */y/**/z/***/w\n' > "$work/tricky2.c"
+    printf '1 12 1. .5 1.5 1e5 1E+5 1e-5 1.e5 .5e5 1e 1e+ 1.2.3 . .. 1x x1 _x x_1\n' > "$work/tricky3.c"
+    printf 'a&&b||c&d|e!=f==g<=h>=i<j>k=l!m+-*/()[]{},;.\r\n@#$%%^~`?:\\ \t\t\n' > "$work/tricky4.c"
+    printf '"s" "" "a b /* c */" "x\n"y" "\n' > "$work/tricky5.c"
+    printf 'int ifx if iff whilew while typedef0 return float voi void for\n' > "$work/tricky6.c"
+    printf 'x = 1; /* unterminated\n\n comment */ *' > "$work/tricky7.c"
+    printf 'x = 1; /* never closed\n\n' > "$work/tricky8.c"
+    printf 'abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789abcdefghij;\n' > "$work/tricky9.c"
+    printf 'a\200b\377c\n/* \001 */ d' > "$work/tricky10.c"
+    i=0
+    while [ $i -lt 70 ]; do
+        # a comment and a string ending at every offset within two vectors
+        printf '%*s/*%*s*/"%*s"\n' $i "" $i "" $i "" >> "$work/tricky11.c"
+        i=$((i + 1))
+    done
+    printf 'x' > "$work/tricky12.c"
+    : > "$work/tricky13.c"
+
+    set -- pattern/*.c bench/*.c "$work"/gen*.c "$work"/tricky*.c
+fi
+
+status=0
+count=0
+for src in "$@"; do
+    "$PARSER" --dump-tokens "$src" > "$work/flex.out" 2>&1
+    "$HAND" --dump-tokens "$src" > "$work/hand.out" 2>&1
+    if ! cmp -s "$work/flex.out" "$work/hand.out"; then
+        echo "lexcheck: $src: the scanners disagree" >&2
+        diff "$work/flex.out" "$work/hand.out" | head -10 >&2
+        status=1
+    fi
+    for scanner in "$PARSER" "$HAND"; do
+        "$scanner" --dump-tokens "$src" > "$work/plain.out" 2>&1
+        "$scanner" --threaded-lexer --dump-tokens "$src" > "$work/threaded.out" 2>&1
+        if ! cmp -s "$work/plain.out" "$work/threaded.out"; then
+            echo "lexcheck: $src: $scanner --threaded-lexer disagrees" >&2
+            diff "$work/plain.out" "$work/threaded.out" | head -10 >&2
+            status=1
+        fi
+    done
+    count=$((count + 1))
+done
+
+[ $status -eq 0 ] && echo "lexcheck: $count files, same tokens"
+exit $status
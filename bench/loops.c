@@ -0,0 +1,22 @@
+int main() {
+    int i, j, sum, r;
+    i = 0;
+    sum = 0;
+    while (i < 200) {
+        j = 0;
+        while (j < 200) {
+            r = i * j + i - j;
+            r = r - (r / 7) * 7;
+            if (r > 3) {
+                sum = sum + r;
+            } else {
+                sum = sum - 1;
+            }
+            j = j + 1;
+        }
+        i = i + 1;
+    }
+    write(sum);
+    write("\n");
+    return 0;
+}
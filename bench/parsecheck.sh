@@ -0,0 +1,60 @@
+#!/bin/sh
+# check that the recursive descent parser (--descent-parser) builds the
+# same AST as the bison one, line numbers and sibling links included, and
+# stops at the same token with the same message on syntax errors
+#
+# every file is also tried with each token on a line of its own, which shows
+# a parser reading a token earlier or later than the other, and with each
+# of its first tokens left out in turn, which gives one syntax error after
+# another (only every STRIDE-th token for files of more than 400 tokens)
+#
+# usage: bench/parsecheck.sh [file.c ...]
+
+PARSER=${PARSER:-./parser}
+CMMGEN=${CMMGEN:-./cmmgen}
+STRIDE=${STRIDE:-7}
+
+work=$(mktemp -d "${TMPDIR:-/tmp}/cmm-parsecheck.XXXXXX") || exit 1
+trap 'rm -rf "$work"' EXIT
+
+if [ $# -eq 0 ]; then
+    for seed in 1 2 3; do
+        "$CMMGEN" --functions 10 --statements 200 --depth 4 --seed $seed > "$work/gen$seed.c" || exit 1
+    done
+    set -- pattern/*.c bench/*.c "$work"/gen*.c
+fi
+
+status=0
+count=0
+
+# compare the two parsers on one file
+check () {
+    "$PARSER" --dump-ast "$1" > "$work/bison.out" 2>&1
+    "$PARSER" --descent-parser --dump-ast "$1" > "$work/descent.out" 2>&1
+    count=$((count + 1))
+    if ! cmp -s "$work/bison.out" "$work/descent.out"; then
+        echo "parsecheck: $2: the parsers disagree" >&2
+        diff "$work/bison.out" "$work/descent.out" | head -10 >&2
+        status=1
+    fi
+}
+
+for src in "$@"; do
+    check "$src" "$src"
+
+    "$PARSER" --dump-tokens "$src" | awk -F'\t' '$2 != "eof" { print $3 }' > "$work/tokens.c"
+    check "$work/tokens.c" "$src, a token per line"
+
+    tokens=$(wc -l < "$work/tokens.c")
+    stride=1
+    [ "$tokens" -gt 400 ] && stride=$STRIDE
+    k=1
+    while [ $k -le "$tokens" ] && [ $k -le 2000 ]; do
+        awk -v k=$k 'NR != k' "$work/tokens.c" > "$work/broken.c"
+        check "$work/broken.c" "$src without token $k"
+        k=$((k + stride))
+    done
+done
+
+[ $status -eq 0 ] && echo "parsecheck: $count inputs, same trees"
+exit $status
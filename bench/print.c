@@ -0,0 +1,18 @@
+int main() {
+    int i, j;
+    i = 1;
+    while (i <= 120) {
+        j = 1;
+        while (j <= 12) {
+            write(i * j);
+            write("\t");
+            j = j + 1;
+        }
+        write("\n");
+        i = i + 1;
+    }
+    write("rows: ");
+    write(i - 1);
+    write("\n");
+    return 0;
+}
@@ -0,0 +1,21 @@
+int i, n, sum;
+float total, x;
+
+int main() {
+    /* a count, then lines of an int and two floats each */
+    n = read();
+    i = 0;
+    sum = 0;
+    total = 0.0;
+    while (i < n) {
+        sum = sum + read();
+        x = fread();
+        total = total + x * fread();
+        i = i + 1;
+    }
+    write(sum);
+    write("\n");
+    write(total);
+    write("\n");
+    return 0;
+}
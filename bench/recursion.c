@@ -0,0 +1,44 @@
+int depth, leaves, calls;
+
+void walk() {
+    calls = calls + 1;
+    if (depth < 14) {
+        depth = depth + 1;
+        walk();
+        walk();
+        depth = depth - 1;
+    } else {
+        leaves = leaves + 1;
+    }
+}
+
+int fibn, fiba, fibb, fibt;
+
+void fib() {
+    if (fibn > 0) {
+        fibt = fiba + fibb;
+        fiba = fibb;
+        fibb = fibt;
+        fibn = fibn - 1;
+        fib();
+    }
+}
+
+int main() {
+    depth = 0;
+    leaves = 0;
+    calls = 0;
+    walk();
+    write(leaves);
+    write(" leaves, ");
+    write(calls);
+    write(" calls\n");
+
+    fibn = 40;
+    fiba = 0;
+    fibb = 1;
+    fib();
+    write(fiba);
+    write("\n");
+    return 0;
+}
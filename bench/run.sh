@@ -0,0 +1,46 @@
+#!/bin/sh
+# compile every bench/*.c, run it in mipsim and check its output against
+# bench/<name>.output. prints one tab separated line of dynamic counts per
+# benchmark; bench/<name>.in is used as stdin when it exists.
+#
+# usage: bench/run.sh [parser flags ...] > results.tsv
+
+PARSER=${PARSER:-./parser}
+MIPSIM=${MIPSIM:-./mipsim}
+
+case $PARSER in /*) ;; *) PARSER=$(pwd)/$PARSER ;; esac
+case $MIPSIM in /*) ;; *) MIPSIM=$(pwd)/$MIPSIM ;; esac
+
+# the parser always writes output.s to the current directory
+work=$(mktemp -d "${TMPDIR:-/tmp}/cmm-bench.XXXXXX") || exit 1
+trap 'rm -rf "$work"' EXIT
+
+status=0
+printf 'benchmark\tinstructions\tloads\tstores\tbranches\tcalls\tsyscalls\n'
+
+for src in bench/*.c; do
+    name=$(basename "$src" .c)
+    input=bench/$name.in
+    [ -f "$input" ] || input=/dev/null
+
+    if ! (cd "$work" && "$PARSER" "$@" "$OLDPWD/$src" > compile.log); then
+        echo "bench: $name: compile failed" >&2
+        status=1
+        continue
+    fi
+
+    "$MIPSIM" --stats "$work/output.s" < "$input" > "$work/run.out" 2> "$work/run.stats"
+    if ! cmp -s "$work/run.out" "bench/$name.output"; then
+        echo "bench: $name: wrong output" >&2
+        status=1
+    fi
+
+    awk -v name="$name" '
+        { count[$1] = $2 }
+        END {
+            printf "%s\t%s\t%s\t%s\t%s\t%s\t%s\n", name, count["instructions"], count["loads"],
+                   count["stores"], count["branches"], count["calls"], count["syscalls"]
+        }' "$work/run.stats"
+done
+
+exit $status
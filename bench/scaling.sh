@@ -0,0 +1,66 @@
+#!/bin/sh
+# compile cmmgen programs from 1K to 1M statements with --time-passes, then
+# fit time = c * statements^k for every pass. k close to 1 is linear, a pass
+# with k well above 1 has super-linear behavior somewhere.
+#
+# usage: bench/scaling.sh [statements ...]
+#        GENFLAGS are passed to cmmgen (default: --functions 10), the
+#        statements are split evenly over the functions
+
+PARSER=${PARSER:-./parser}
+CMMGEN=${CMMGEN:-./cmmgen}
+GENFLAGS=${GENFLAGS:---functions 10}
+
+[ $# -gt 0 ] || set -- 1000 3000 10000 30000 100000 300000 1000000
+
+case $PARSER in /*) ;; *) PARSER=$(pwd)/$PARSER ;; esac
+case $CMMGEN in /*) ;; *) CMMGEN=$(pwd)/$CMMGEN ;; esac
+
+work=$(mktemp -d "${TMPDIR:-/tmp}/cmm-scaling.XXXXXX") || exit 1
+trap 'rm -rf "$work"' EXIT
+
+functions=$(echo "$GENFLAGS" | awk '{ for (i = 1; i < NF; ++i) if ($i == "--functions") n = $(i + 1) } END { print (n > 0 ? n : 1) }')
+
+for n in "$@"; do
+    # shellcheck disable=SC2086
+    "$CMMGEN" $GENFLAGS --statements $((n / functions)) > "$work/gen.c" || exit 1
+    if ! (cd "$work" && "$PARSER" --time-passes gen.c > /dev/null 2> passes.txt); then
+        echo "scaling: $n statements: compile failed" >&2
+        exit 1
+    fi
+    # "pass name ... ms % heap rss" lines between the header and the total
+    awk -v n="$n" -v lines="$(wc -l < "$work/gen.c")" '
+        NR > 1 && $1 != "total" {
+            name = $1
+            for (i = 2; i <= NF - 4; ++i)
+                name = name " " $i
+            printf "%s\t%s\t%s\t%s\n", n, lines, name, $(NF - 3)
+        }
+        $1 == "total" { printf "%s\t%s\ttotal\t%s\n", n, lines, $2 }' "$work/passes.txt"
+done > "$work/times.tsv"
+
+printf 'statements\tlines\tpass\tms\n'
+cat "$work/times.tsv"
+echo
+
+# least squares fit of log(ms) = log(c) + k * log(statements)
+awk -F'\t' '
+    $4 > 0 {
+        if (!($3 in count))
+            order[passes++] = $3
+        x = log($1); y = log($4)
+        count[$3]++; sx[$3] += x; sy[$3] += y; sxx[$3] += x * x; sxy[$3] += x * y
+    }
+    END {
+        printf "%-20s %8s  %s\n", "pass", "k", ""
+        for (i = 0; i < passes; ++i) {
+            p = order[i]
+            d = count[p] * sxx[p] - sx[p] * sx[p]
+            if (count[p] < 2 || d == 0) {
+                printf "%-20s %8s\n", p, "-"
+                continue
+            }
+            k = (count[p] * sxy[p] - sx[p] * sy[p]) / d
+            printf "%-20s %8.3f  %s\n", p, k, (k > 1.2 ? "super-linear" : "")
+        }
+    }' "$work/times.tsv"
@@ -0,0 +1,60 @@
+#!/bin/sh
+# compile a corpus of C-- files over and over and report how many source
+# lines the parser gets through per second. the whole process is timed, as
+# a build farm would see it; use --time-passes for where the time goes.
+#
+# usage: bench/throughput.sh [-n runs] [file.c ...]
+#        the corpus defaults to pattern/*.c bench/*.c, PARSERFLAGS are passed
+#        to the parser
+
+PARSER=${PARSER:-./parser}
+runs=20
+
+while [ $# -gt 0 ]; do
+    case $1 in
+        -n) runs=$2; shift 2 ;;
+        *)  break ;;
+    esac
+done
+[ $# -gt 0 ] || set -- pattern/*.c bench/*.c
+
+case $PARSER in /*) ;; *) PARSER=$(pwd)/$PARSER ;; esac
+
+# the parser always writes output.s to the current directory
+work=$(mktemp -d "${TMPDIR:-/tmp}/cmm-throughput.XXXXXX") || exit 1
+trap 'rm -rf "$work"' EXIT
+
+files=""
+for src in "$@"; do
+    case $src in /*) ;; *) src=$(pwd)/$src ;; esac
+    if ! (cd "$work" && "$PARSER" $PARSERFLAGS "$src" > /dev/null); then
+        echo "throughput: $src: compile failed" >&2
+        exit 1
+    fi
+    files="$files $src"
+done
+
+lines=$(cat $files | wc -l)
+count=$(echo $files | wc -w)
+
+cd "$work" || exit 1
+start=$(date +%s%N)
+i=0
+while [ $i -lt "$runs" ]; do
+    for src in $files; do
+        "$PARSER" $PARSERFLAGS "$src" > /dev/null
+    done
+    i=$((i + 1))
+done
+end=$(date +%s%N)
+
+awk -v files="$count" -v lines="$lines" -v runs="$runs" -v ns=$((end - start)) '
+    BEGIN {
+        seconds = ns / 1e9
+        printf "files\t%d\n", files
+        printf "lines\t%d\n", lines
+        printf "runs\t%d\n", runs
+        printf "seconds\t%.3f\n", seconds
+        printf "compiles_per_sec\t%.1f\n", (seconds > 0 ? files * runs / seconds : 0)
+        printf "lines_per_sec\t%.0f\n", (seconds > 0 ? lines * runs / seconds : 0)
+    }'
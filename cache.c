@@ -0,0 +1,374 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "cache.h"
+#include "libcmm.h"
+#include "compilerContext.h"
+
+
+// an entry is the file <directory>/<key>: a line
+//
+//     cmm-cache 1 <failed> <error count> <has assembly> <assembly length> <diagnostics length>
+//
+// then the assembly and the diagnostics. a hit sets the entry's mtime, and
+// eviction removes the oldest mtimes first. it also removes the tmp-XXXXXX
+// files of stores that were killed before they renamed theirs into place
+//
+// the size of the directory is only counted when a process stores its
+// first entry or its count goes over the limit, in between it adds what it
+// stores itself. so the limit is checked late when several processes share
+// the directory, never missed
+
+
+#define CACHE_MAGIC "cmm-cache 1"
+// eviction goes down to this much of the limit, so it doesn't run again on
+// the next store
+#define EVICT_TO(limit) ((limit) / 10 * 9)
+// a temporary file this many seconds old belongs to no running store
+#define STALE_TEMPORARY 3600
+
+// the Makefile passes a hash of the compiler's sources, so that a build
+// with any change to them doesn't read the entries of another
+#ifndef CMM_BUILD_ID
+#define CMM_BUILD_ID "unknown"
+#endif
+
+
+// SHA-256, FIPS 180-4
+
+typedef struct Sha256 {
+    uint32_t state[8];
+    uint64_t length;
+    unsigned char block[64];
+    size_t used;
+} Sha256;
+
+
+static const uint32_t sha256K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+
+static void sha256Block (Sha256 *sha, const unsigned char *block) {
+    uint32_t w[64];
+    uint32_t a, b, c, d, e, f, g, h;
+    int i;
+
+    for (i = 0; i < 16; ++i)
+        w[i] = (uint32_t)block[4 * i] << 24 | (uint32_t)block[4 * i + 1] << 16 |
+               (uint32_t)block[4 * i + 2] << 8 | block[4 * i + 3];
+    for (i = 16; i < 64; ++i) {
+        uint32_t s0 = ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    a = sha->state[0]; b = sha->state[1]; c = sha->state[2]; d = sha->state[3];
+    e = sha->state[4]; f = sha->state[5]; g = sha->state[6]; h = sha->state[7];
+    for (i = 0; i < 64; ++i) {
+        uint32_t t1 = h + (ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25)) + ((e & f) ^ (~e & g)) + sha256K[i] + w[i];
+        uint32_t t2 = (ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    sha->state[0] += a; sha->state[1] += b; sha->state[2] += c; sha->state[3] += d;
+    sha->state[4] += e; sha->state[5] += f; sha->state[6] += g; sha->state[7] += h;
+}
+
+
+static void sha256Start (Sha256 *sha) {
+    static const uint32_t initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    memcpy(sha->state, initial, sizeof(initial));
+    sha->length = 0;
+    sha->used = 0;
+}
+
+
+static void sha256Add (Sha256 *sha, const void *data, size_t length) {
+    const unsigned char *bytes = (const unsigned char *)data;
+
+    sha->length += length;
+    if (sha->used > 0) {
+        size_t take = 64 - sha->used < length ? 64 - sha->used : length;
+        memcpy(sha->block + sha->used, bytes, take);
+        sha->used += take;
+        bytes += take;
+        length -= take;
+        if (sha->used < 64)
+            return;
+        sha256Block(sha, sha->block);
+        sha->used = 0;
+    }
+    for (; length >= 64; bytes += 64, length -= 64)
+        sha256Block(sha, bytes);
+    memcpy(sha->block, bytes, length);
+    sha->used = length;
+}
+
+
+static void sha256End (Sha256 *sha, char hex[CACHE_KEY_LENGTH + 1]) {
+    uint64_t bits = sha->length * 8;
+    unsigned char tail[8];
+    int i;
+
+    sha256Add(sha, "\x80", 1);
+    while (sha->used != 56)
+        sha256Add(sha, "", 1);
+    for (i = 0; i < 8; ++i)
+        tail[i] = (unsigned char)(bits >> (56 - 8 * i));
+    sha256Add(sha, tail, 8);
+    for (i = 0; i < 32; ++i)
+        sprintf(hex + 2 * i, "%02x", (unsigned)(sha->state[i / 4] >> (24 - 8 * (i % 4))) & 0xff);
+}
+
+
+// the scanners and the threaded lexer give the same tokens (make lexcheck),
+// so only the options that can change the output are hashed. the descent
+// parser is, as it nests deeper than bison before a syntax error
+void cacheKey (const CompilerContext *ctx, const char *source, size_t length, char key[CACHE_KEY_LENGTH + 1]) {
+    char options[192];
+    Sha256 sha;
+
+    snprintf(options, sizeof(options), "%s %s %d %d %d %d\n", CMM_VERSION, CMM_BUILD_ID,
+             ctx->bufferedIO, ctx->batchedInput, ctx->descentParser, ctx->skipCodeOnError);
+    sha256Start(&sha);
+    sha256Add(&sha, options, strlen(options));
+    sha256Add(&sha, source, length);
+    sha256End(&sha, key);
+}
+
+
+// NULL without memory, which the cache takes as a miss
+static char *entryPath (const char *directory, const char *name) {
+    char *path = (char *)malloc(strlen(directory) + strlen(name) + 2);
+    if (path)
+        sprintf(path, "%s/%s", directory, name);
+    return path;
+}
+
+
+int cacheLookup (const char *directory, const char *key, CacheEntry *entry) {
+    char *path = entryPath(directory, key);
+    FILE *file = path ? fopen(path, "rb") : NULL;
+    struct stat status;
+    long header;
+    int hit = 0;
+
+    memset(entry, 0, sizeof(*entry));
+    if (file == NULL) {
+        free(path);
+        return 0;
+    }
+    if (fscanf(file, CACHE_MAGIC " %d %d %d %zu %zu", &entry->failed, &entry->errorCount,
+               &entry->hasAssembly, &entry->assemblyLength, &entry->diagnosticsLength) == 5 &&
+        fgetc(file) == '\n' && (header = ftell(file)) > 0 && fstat(fileno(file), &status) == 0 &&
+        (size_t)status.st_size == header + entry->assemblyLength + entry->diagnosticsLength) {
+        entry->assembly = (char *)malloc(entry->assemblyLength + 1);
+        entry->diagnostics = (char *)malloc(entry->diagnosticsLength + 1);
+        hit = entry->assembly && entry->diagnostics &&
+              fread(entry->assembly, 1, entry->assemblyLength, file) == entry->assemblyLength &&
+              fread(entry->diagnostics, 1, entry->diagnosticsLength, file) == entry->diagnosticsLength;
+    }
+    fclose(file);
+
+    if (hit)
+        utimensat(AT_FDCWD, path, NULL, 0);
+    else
+        cacheEntryEnd(entry);
+    free(path);
+    return hit;
+}
+
+
+typedef struct CacheFile {
+    char *path;
+    long long size;
+    struct timespec used;
+} CacheFile;
+
+
+static int olderFirst (const void *a, const void *b) {
+    const CacheFile *x = (const CacheFile *)a;
+    const CacheFile *y = (const CacheFile *)b;
+
+    if (x->used.tv_sec != y->used.tv_sec)
+        return x->used.tv_sec < y->used.tv_sec ? -1 : 1;
+    return (x->used.tv_nsec > y->used.tv_nsec) - (x->used.tv_nsec < y->used.tv_nsec);
+}
+
+
+static int isKey (const char *name) {
+    return strlen(name) == CACHE_KEY_LENGTH && strspn(name, "0123456789abcdef") == CACHE_KEY_LENGTH;
+}
+
+
+// a cacheStore() temporary that was left behind
+static int isStaleTemporary (const char *name, const struct stat *status, time_t now) {
+    return strncmp(name, "tmp-", 4) == 0 && strlen(name) == 10 && S_ISREG(status->st_mode) &&
+           now - status->st_mtime > STALE_TEMPORARY;
+}
+
+
+// the size of the entries in `directory`, after removing stale temporaries
+// and the least recently used entries if there are more than `limit` bytes
+static long long evict (const char *directory, long long limit) {
+    DIR *dir = opendir(directory);
+    CacheFile *files = NULL;
+    int count = 0;
+    int capacity = 0;
+    long long total = 0;
+    time_t now = time(NULL);
+    struct dirent *item;
+    int i;
+
+    if (dir == NULL)
+        return 0;
+    while ((item = readdir(dir)) != NULL) {
+        struct stat status;
+        char *path;
+        int key = isKey(item->d_name);
+
+        if (!key && strncmp(item->d_name, "tmp-", 4) != 0)
+            continue;
+        path = entryPath(directory, item->d_name);
+        if (path == NULL || stat(path, &status) != 0) {
+            free(path);
+            continue;
+        }
+        if (!key) {
+            if (isStaleTemporary(item->d_name, &status, now))
+                unlink(path);
+            free(path);
+            continue;
+        }
+        if (count == capacity) {
+            // without memory only the entries found so far are counted
+            CacheFile *more = (CacheFile *)realloc(files, (capacity ? capacity * 2 : 256) * sizeof(CacheFile));
+            if (!more) {
+                free(path);
+                break;
+            }
+            files = more;
+            capacity = capacity ? capacity * 2 : 256;
+        }
+        files[count].path = path;
+        files[count].size = status.st_size;
+        files[count].used = status.st_mtim;
+        total += status.st_size;
+        count++;
+    }
+    closedir(dir);
+
+    if (total > limit) {
+        qsort(files, count, sizeof(CacheFile), olderFirst);
+        for (i = 0; i < count && total > EVICT_TO(limit); ++i) {
+            if (unlink(files[i].path) == 0)
+                total -= files[i].size;
+        }
+    }
+    for (i = 0; i < count; ++i)
+        free(files[i].path);
+    free(files);
+    return total;
+}
+
+
+static pthread_mutex_t sizeLock = PTHREAD_MUTEX_INITIALIZER;
+// of knownDirectory, the last one stored into, -1 before the first store
+static char *knownDirectory = NULL;
+static long long knownSize = -1;
+
+
+void cacheStore (const char *directory, long long limit, const char *key, const CacheEntry *entry) {
+    char *path = entryPath(directory, key);
+    char *temporary = entryPath(directory, "tmp-XXXXXX");
+    int fd;
+    FILE *file;
+    long long size;
+    long long replaced;
+    struct stat status;
+    int written;
+
+    // it would only push everything else out and then go itself
+    if (path == NULL || temporary == NULL ||
+        (long long)(entry->assemblyLength + entry->diagnosticsLength) > EVICT_TO(limit)) {
+        free(temporary);
+        free(path);
+        return;
+    }
+    // the first store makes the directory
+    mkdir(directory, 0777);
+    fd = mkstemp(temporary);
+    file = fd >= 0 ? fdopen(fd, "wb") : NULL;
+    if (file == NULL) {
+        if (fd >= 0) {
+            close(fd);
+            unlink(temporary);
+        }
+        free(temporary);
+        free(path);
+        return;
+    }
+    fprintf(file, CACHE_MAGIC " %d %d %d %zu %zu\n", entry->failed, entry->errorCount,
+            entry->hasAssembly, entry->assemblyLength, entry->diagnosticsLength);
+    fwrite(entry->assembly, 1, entry->assemblyLength, file);
+    fwrite(entry->diagnostics, 1, entry->diagnosticsLength, file);
+    size = ftell(file);
+    written = !ferror(file);
+    // mkstemp() makes it private, the entries are for everyone who can read
+    // the directory
+    fchmod(fd, 0644);
+    written = fclose(file) == 0 && written;
+    // an entry under the same key (another thread's, or a corrupt one) is
+    // replaced, so only the difference is new to the directory
+    replaced = stat(path, &status) == 0 ? status.st_size : 0;
+    if (!written || rename(temporary, path) != 0) {
+        unlink(temporary);
+        size = replaced = 0;
+    }
+    size -= replaced;
+    free(temporary);
+    free(path);
+
+    pthread_mutex_lock(&sizeLock);
+    if (knownDirectory == NULL || strcmp(knownDirectory, directory) != 0) {
+        free(knownDirectory);
+        knownDirectory = strdup(directory);
+        knownSize = -1;
+    }
+    if (knownSize < 0 || knownSize + size > limit)
+        knownSize = evict(directory, limit);
+    else
+        knownSize += size;
+    pthread_mutex_unlock(&sizeLock);
+}
+
+
+void cacheEntryEnd (CacheEntry *entry) {
+    free(entry->assembly);
+    free(entry->diagnostics);
+    entry->assembly = entry->diagnostics = NULL;
+    entry->assemblyLength = entry->diagnosticsLength = 0;
+}
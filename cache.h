@@ -0,0 +1,48 @@
+#ifndef __CACHE_H__
+#define __CACHE_H__
+
+#include <stddef.h>
+
+#include "header.h"
+
+
+// --cache dir: finished compilations on disk, under the SHA-256 of the
+// compiler's version, the options that change the output and the source.
+// entries are written to a temporary file and renamed into place, so
+// processes and threads can share a directory; once it holds more than
+// its limit the least recently used entries are removed
+
+
+// 64 hex digits
+#define CACHE_KEY_LENGTH 64
+
+// --cache-size, in MB
+#define CACHE_DEFAULT_LIMIT (256LL << 20)
+
+
+// what a compilation printed and wrote
+typedef struct CacheEntry {
+    int failed;              // stopped before code generation
+    int errorCount;
+    int hasAssembly;         // there is an output file to write
+    char *assembly;
+    size_t assemblyLength;
+    char *diagnostics;
+    size_t diagnosticsLength;
+} CacheEntry;
+
+
+void cacheKey (const CompilerContext *ctx, const char *source, size_t length, char key[CACHE_KEY_LENGTH + 1]);
+
+// 1 and `entry` filled in on a hit, which also makes the entry the most
+// recently used one; release it with cacheEntryEnd()
+int cacheLookup (const char *directory, const char *key, CacheEntry *entry);
+
+// failures to write are ignored, the next compilation just misses again;
+// so is an entry too big for the limit
+void cacheStore (const char *directory, long long limit, const char *key, const CacheEntry *entry);
+
+void cacheEntryEnd (CacheEntry *entry);
+
+
+#endif // __CACHE_H__
@@ -0,0 +1,388 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "symbolTable.h"
+
+
+// cmmgen writes a random but valid C-- program of a given size and shape to
+// stdout, for finding out how the compiler scales on large generated
+// sources. the same options and seed always give the same program.
+//
+// every function gets --statements statements (nested ones included) and
+// main calls all of them. loops count a reserved variable up to a small
+// bound and only divide by nonzero constants, so the programs also run.
+
+
+#define INT_LOCALS 8
+#define FLOAT_LOCALS 4
+#define MAX_NAME 32
+#define LOOP_BOUND 3
+
+
+typedef struct GenOptions {
+    int functions;
+    int statements;
+    int depth;
+    int exprDepth;
+    int globals;
+    int collisions;
+    unsigned long long seed;
+} GenOptions;
+
+
+static GenOptions options = {1, 100, 2, 3, 16, 0, 1};
+
+static unsigned long long randomState;
+
+// names of the globals and of the current function's locals
+static char (*intGlobals)[MAX_NAME];
+static char (*floatGlobals)[MAX_NAME];
+static int intGlobalCount = 0;
+static int floatGlobalCount = 0;
+static char intLocals[INT_LOCALS][MAX_NAME];
+static char floatLocals[FLOAT_LOCALS][MAX_NAME];
+static char (*counters)[MAX_NAME];
+static char (*functionNames)[MAX_NAME];
+
+
+static unsigned int nextRandom (void) {
+    randomState = randomState * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (unsigned int)(randomState >> 33);
+}
+
+
+// 0 <= result < n
+static int randomBelow (int n) {
+    return n > 0 ? (int)(nextRandom() % (unsigned int)n) : 0;
+}
+
+
+// identifiers
+//
+// every name is `prefix` and a number that keeps going up, so names never
+// repeat. with --collisions N the numbers are skipped until N names in a row
+// have the same low COLLISION_BITS bits of the symbol table's HASH(), i.e.
+// share a bucket for as long as the table has at most 2^COLLISION_BITS.
+
+#define COLLISION_BITS 16
+
+static long long nameCounter = 0;
+static long long bucket = -1;
+static int namesInBucket = 0;
+
+
+static void newName (char *name, const char *prefix) {
+    const unsigned int mask = (1u << COLLISION_BITS) - 1;
+    long long tries = 0;
+
+    for (;;) {
+        snprintf(name, MAX_NAME, "%s%lld", prefix, nameCounter++);
+        if (options.collisions <= 1)
+            return;
+        if (bucket < 0 || tries++ > (1LL << 24))
+            bucket = HASH(name) & mask;
+        if ((HASH(name) & mask) == bucket)
+            break;
+    }
+
+    if (++namesInBucket == options.collisions) {
+        bucket = -1;
+        namesInBucket = 0;
+    }
+}
+
+
+// expressions
+
+static void intLeaf (FILE *out) {
+    int pick = randomBelow(4);
+    if (pick == 0)
+        fprintf(out, "%d", randomBelow(100));
+    else if (pick == 1 && intGlobalCount > 0)
+        fprintf(out, "%s", intGlobals[randomBelow(intGlobalCount)]);
+    else
+        fprintf(out, "%s", intLocals[randomBelow(INT_LOCALS)]);
+}
+
+
+static void floatLeaf (FILE *out) {
+    int pick = randomBelow(4);
+    if (pick == 0)
+        fprintf(out, "%d.%d", randomBelow(100), randomBelow(100));
+    else if (pick == 1 && floatGlobalCount > 0)
+        fprintf(out, "%s", floatGlobals[randomBelow(floatGlobalCount)]);
+    else
+        fprintf(out, "%s", floatLocals[randomBelow(FLOAT_LOCALS)]);
+}
+
+
+// `depth` nested binary operations, one side of each is a leaf
+static void genExpr (FILE *out, int depth, int isFloat) {
+    int op;
+
+    if (depth == 0) {
+        if (isFloat)
+            floatLeaf(out);
+        else
+            intLeaf(out);
+        return;
+    }
+
+    op = randomBelow(4);
+    fprintf(out, "(");
+    if (op == 3) {
+        // only ever divide by a nonzero constant
+        genExpr(out, depth - 1, isFloat);
+        if (isFloat)
+            fprintf(out, " / %d.5", 1 + randomBelow(9));
+        else
+            fprintf(out, " / %d", 1 + randomBelow(9));
+    }
+    else if (randomBelow(2)) {
+        genExpr(out, depth - 1, isFloat);
+        fprintf(out, " %c ", "+-*"[op]);
+        genExpr(out, 0, isFloat);
+    }
+    else {
+        genExpr(out, 0, isFloat);
+        fprintf(out, " %c ", "+-*"[op]);
+        genExpr(out, depth - 1, isFloat);
+    }
+    fprintf(out, ")");
+}
+
+
+static void genCondition (FILE *out) {
+    static const char *relops[] = {"<", ">", "<=", ">=", "==", "!="};
+
+    genExpr(out, options.exprDepth / 2, 0);
+    fprintf(out, " %s ", relops[randomBelow(6)]);
+    genExpr(out, options.exprDepth / 2, 0);
+    if (randomBelow(4) == 0) {
+        fprintf(out, " %s ", randomBelow(2) ? "&&" : "||");
+        intLeaf(out);
+    }
+}
+
+
+// statements
+
+static void indent (FILE *out, int level) {
+    fprintf(out, "%*s", 4 * level, "");
+}
+
+
+static void genSimpleStatement (FILE *out, int level) {
+    int pick = randomBelow(10);
+
+    indent(out, level);
+    if (pick < 6) {
+        fprintf(out, "%s = ", intLocals[randomBelow(INT_LOCALS)]);
+        genExpr(out, options.exprDepth, 0);
+    }
+    else if (pick < 8) {
+        fprintf(out, "%s = ", floatLocals[randomBelow(FLOAT_LOCALS)]);
+        genExpr(out, options.exprDepth, 1);
+    }
+    else if (pick < 9 && intGlobalCount > 0) {
+        fprintf(out, "%s = ", intGlobals[randomBelow(intGlobalCount)]);
+        genExpr(out, options.exprDepth, 0);
+    }
+    else {
+        fprintf(out, "write(%s)", intLocals[randomBelow(INT_LOCALS)]);
+    }
+    fprintf(out, ";\n");
+}
+
+
+// exactly `count` statements, a compound statement counts as one plus the
+// statements inside it
+static void genStatements (FILE *out, int count, int level) {
+    while (count > 0) {
+        int nested = level - 1;
+        int kind = randomBelow(4);
+
+        // a loop needs its counter reset, its test and its increment
+        if (nested < options.depth && count >= 3 && kind == 0) {
+            int body = 1 + randomBelow(count - 2 < 8 ? count - 2 : 8);
+
+            indent(out, level);
+            fprintf(out, "%s = 0;\n", counters[nested]);
+            indent(out, level);
+            fprintf(out, "while (%s < %d) {\n", counters[nested], LOOP_BOUND);
+            genStatements(out, body - 1, level + 1);
+            indent(out, level + 1);
+            fprintf(out, "%s = %s + 1;\n", counters[nested], counters[nested]);
+            indent(out, level);
+            fprintf(out, "}\n");
+            count -= body + 2;
+        }
+        else if (nested < options.depth && count >= 3 && kind == 1) {
+            int thenCount = 1 + randomBelow(count - 2 < 8 ? count - 2 : 8);
+            int elseCount = randomBelow(count - 1 - thenCount < 8 ? count - 1 - thenCount : 8);
+
+            indent(out, level);
+            fprintf(out, "if (");
+            genCondition(out);
+            fprintf(out, ") {\n");
+            genStatements(out, thenCount, level + 1);
+            indent(out, level);
+            if (elseCount > 0) {
+                fprintf(out, "} else {\n");
+                genStatements(out, elseCount, level + 1);
+                indent(out, level);
+            }
+            fprintf(out, "}\n");
+            count -= 1 + thenCount + elseCount;
+        }
+        else {
+            genSimpleStatement(out, level);
+            --count;
+        }
+    }
+}
+
+
+static void genLocals (FILE *out) {
+    int i;
+
+    indent(out, 1);
+    fprintf(out, "int ");
+    for (i = 0; i < INT_LOCALS; ++i) {
+        newName(intLocals[i], "v");
+        fprintf(out, "%s%s = %d", i ? ", " : "", intLocals[i], i + 1);
+    }
+    fprintf(out, ";\n");
+
+    indent(out, 1);
+    fprintf(out, "float ");
+    for (i = 0; i < FLOAT_LOCALS; ++i) {
+        newName(floatLocals[i], "w");
+        fprintf(out, "%s%s = %d.5", i ? ", " : "", floatLocals[i], i);
+    }
+    fprintf(out, ";\n");
+
+    if (options.depth > 0) {
+        indent(out, 1);
+        fprintf(out, "int ");
+        for (i = 0; i < options.depth; ++i) {
+            newName(counters[i], "i");
+            fprintf(out, "%s%s", i ? ", " : "", counters[i]);
+        }
+        fprintf(out, ";\n");
+    }
+}
+
+
+static void genGlobals (FILE *out) {
+    int i;
+
+    intGlobals = malloc((options.globals + 1) * sizeof(*intGlobals));
+    floatGlobals = malloc((options.globals + 1) * sizeof(*floatGlobals));
+    if (!intGlobals || !floatGlobals) {
+        fprintf(stderr, "cmmgen: out of memory\n");
+        exit(2);
+    }
+
+    // one in four globals is a float
+    for (i = 0; i < options.globals; ++i) {
+        if (i % 4 == 3) {
+            newName(floatGlobals[floatGlobalCount], "h");
+            fprintf(out, "float %s = %d.25;\n", floatGlobals[floatGlobalCount++], i);
+        }
+        else {
+            newName(intGlobals[intGlobalCount], "g");
+            fprintf(out, "int %s = %d;\n", intGlobals[intGlobalCount++], i);
+        }
+    }
+    if (options.globals > 0)
+        fprintf(out, "\n");
+}
+
+
+static void genFunction (FILE *out, const char *name) {
+    fprintf(out, "int %s() {\n", name);
+    genLocals(out);
+    genStatements(out, options.statements, 1);
+    indent(out, 1);
+    fprintf(out, "return %s;\n", intLocals[0]);
+    fprintf(out, "}\n\n");
+}
+
+
+static void genMain (FILE *out) {
+    int i;
+
+    fprintf(out, "int main() {\n");
+    genLocals(out);
+    for (i = 0; i < options.functions; ++i) {
+        indent(out, 1);
+        fprintf(out, "%s = %s();\n", intLocals[i % INT_LOCALS], functionNames[i]);
+    }
+    indent(out, 1);
+    fprintf(out, "return 0;\n");
+    fprintf(out, "}\n");
+}
+
+
+static int parseCount (const char *option, const char *value) {
+    char *end;
+    long n = strtol(value, &end, 10);
+    if (*value == '\0' || *end != '\0' || n < 0 || n > 100000000) {
+        fprintf(stderr, "cmmgen: bad value '%s' for %s\n", value, option);
+        exit(2);
+    }
+    return (int)n;
+}
+
+
+static void usage (void) {
+    fprintf(stderr,
+            "usage: cmmgen [--functions N] [--statements N] [--depth N] [--expr-depth N]\n"
+            "              [--globals N] [--collisions N] [--seed N] > program.c\n");
+    exit(2);
+}
+
+
+int main (int argc, char *argv[]) {
+    int i;
+
+    for (i = 1; i < argc; ++i) {
+        if (i + 1 >= argc)
+            usage();
+        if (strcmp(argv[i], "--functions") == 0)
+            options.functions = parseCount(argv[i], argv[i + 1]);
+        else if (strcmp(argv[i], "--statements") == 0)
+            options.statements = parseCount(argv[i], argv[i + 1]);
+        else if (strcmp(argv[i], "--depth") == 0)
+            options.depth = parseCount(argv[i], argv[i + 1]);
+        else if (strcmp(argv[i], "--expr-depth") == 0)
+            options.exprDepth = parseCount(argv[i], argv[i + 1]);
+        else if (strcmp(argv[i], "--globals") == 0)
+            options.globals = parseCount(argv[i], argv[i + 1]);
+        else if (strcmp(argv[i], "--collisions") == 0)
+            options.collisions = parseCount(argv[i], argv[i + 1]);
+        else if (strcmp(argv[i], "--seed") == 0)
+            options.seed = parseCount(argv[i], argv[i + 1]);
+        else
+            usage();
+        ++i;
+    }
+    randomState = options.seed;
+
+    counters = malloc((options.depth + 1) * sizeof(*counters));
+    functionNames = malloc((options.functions + 1) * sizeof(*functionNames));
+    if (!counters || !functionNames) {
+        fprintf(stderr, "cmmgen: out of memory\n");
+        exit(2);
+    }
+
+    genGlobals(stdout);
+    for (i = 0; i < options.functions; ++i) {
+        newName(functionNames[i], "f");
+        genFunction(stdout, functionNames[i]);
+    }
+    genMain(stdout);
+    return 0;
+}
@@ -2,16 +2,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
-#include <time.h>
 
 #include "symbolTable.h"
+#include "compilerContext.h"
 #include "codegen.h"
 
 
-extern SymbolTable symbolTable;
-extern int ARoffset;
-void walkTree (FILE *F, AST_NODE *node);
-void emitArithmeticStmt (FILE *F, AST_NODE *exprNode);
+void walkTree (CompilerContext *ctx, FILE *F, AST_NODE *node);
+void emitArithmeticStmt (CompilerContext *ctx, FILE *F, AST_NODE *exprNode);
 
 // xatier: in order to print better asswembly codes, the length of mnemonic + space should be 8
 // for instance:
@@ -27,6 +25,693 @@ void _DBG (FILE *F, const AST_NODE *node, const char *msg) {
 }
 
 
+// RA pool: floating point temporaries
+//
+// float results are kept in $f2 ~ $f11 instead of going through the memory
+// stack. expressions are evaluated in post order, so the pool is used as a
+// stack too: an operation pops its right and left operands and pushes the
+// result into the register of its left operand. when an expression is deeper
+// than the pool, the extra values are spilled to the memory stack just like
+// the integer ones.
+//
+// $f0 and $f1 are scratch registers for left and right operands, $f12 is the
+// argument of the print float syscall
+#define FREG_POOL_SIZE 10
+
+static const char *fregPool[FREG_POOL_SIZE] = {
+    "$f2", "$f3", "$f4", "$f5", "$f6", "$f7", "$f8", "$f9", "$f10", "$f11",
+};
+
+// get the register for a new float temporary, call fregCommit(ctx) after
+// computing into it
+static const char *fregPush (CompilerContext *ctx) {
+    ++ctx->fregTop;
+    if (ctx->fregTop > FREG_POOL_SIZE)
+        return "$f0";
+    return fregPool[ctx->fregTop - 1];
+}
+
+static void fregCommit (CompilerContext *ctx, FILE *F) {
+    if (ctx->fregTop > FREG_POOL_SIZE) {
+        fprintf(F, "s.s     $f0, ($sp)\n");
+        fprintf(F, "sub     $sp, $sp, 4\n");
+    }
+}
+
+// release the float temporary on top, returns the register holding it
+// (`scratch` if it has been spilled)
+static const char *fregPop (CompilerContext *ctx, FILE *F, const char *scratch) {
+    --ctx->fregTop;
+    if (ctx->fregTop < FREG_POOL_SIZE)
+        return fregPool[ctx->fregTop];
+
+    fprintf(F, "l.s     %s, 4($sp)\n", scratch);
+    fprintf(F, "add     $sp, $sp, 4\n");
+    return scratch;
+}
+
+// the callee uses the same pool, save live temporaries around a call
+static int fregSave (CompilerContext *ctx, FILE *F) {
+    int live = ctx->fregTop < FREG_POOL_SIZE ? ctx->fregTop : FREG_POOL_SIZE;
+    int i;
+    for (i = 0; i < live; ++i) {
+        fprintf(F, "s.s     %s, ($sp)\n", fregPool[i]);
+        fprintf(F, "sub     $sp, $sp, 4\n");
+    }
+    return live;
+}
+
+static void fregRestore (FILE *F, int live) {
+    int i;
+    for (i = live - 1; i >= 0; --i) {
+        fprintf(F, "l.s     %s, 4($sp)\n", fregPool[i]);
+        fprintf(F, "add     $sp, $sp, 4\n");
+    }
+}
+
+
+// float constant pool
+//
+// li.s expands to several instructions and prints the value with %f, which
+// loses precision. every distinct constant (keyed on its bit pattern) is
+// placed in .data once by emitAppendix(ctx) and loaded with a single l.s
+
+static unsigned int floatBits (float value) {
+    unsigned int bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// both pools are searched through an open addressing table of index + 1
+// (0 is a free slot) of twice the pool's capacity, rebuilt when it grows
+
+static unsigned int floatConstHash (unsigned int bits) {
+    bits ^= bits >> 16;
+    bits *= 0x85ebca6bu;
+    bits ^= bits >> 13;
+    bits *= 0xc2b2ae35u;
+    bits ^= bits >> 16;
+    return bits;
+}
+
+// the label index of a float constant, added to the pool if it's new
+static int getFloatConst (CompilerContext *ctx, float value) {
+    unsigned int bits = floatBits(value);
+    unsigned int mask;
+    unsigned int slot;
+    int i;
+
+    if (ctx->fconstCount == ctx->fconstCapacity) {
+        int capacity = ctx->fconstCapacity ? ctx->fconstCapacity * 2 : 16;
+        unsigned int *pool = realloc(ctx->fconstPool, capacity * sizeof(unsigned int));
+        int *index = calloc(capacity * 2, sizeof(int));
+        if (!pool || !index) {
+            free(index);
+            if (pool)
+                ctx->fconstPool = pool;
+            compileFailed(ctx, "[-] out of memory");
+        }
+        mask = capacity * 2 - 1;
+        for (i = 0; i < ctx->fconstCount; ++i) {
+            for (slot = floatConstHash(pool[i]) & mask; index[slot]; slot = (slot + 1) & mask)
+                ;
+            index[slot] = i + 1;
+        }
+        free(ctx->fconstIndex);
+        ctx->fconstPool = pool;
+        ctx->fconstIndex = index;
+        ctx->fconstCapacity = capacity;
+    }
+
+    mask = ctx->fconstCapacity * 2 - 1;
+    for (slot = floatConstHash(bits) & mask; ctx->fconstIndex[slot]; slot = (slot + 1) & mask) {
+        if (ctx->fconstPool[ctx->fconstIndex[slot] - 1] == bits)
+            return ctx->fconstIndex[slot] - 1;
+    }
+    ctx->fconstIndex[slot] = ctx->fconstCount + 1;
+    ctx->fconstPool[ctx->fconstCount] = bits;
+    return ctx->fconstCount++;
+}
+
+static void emitFloatConstPool (CompilerContext *ctx, FILE *F) {
+    int i;
+
+    if (ctx->fconstCount == 0)
+        return;
+
+    fprintf(F, ".align  2\n");
+    for (i = 0; i < ctx->fconstCount; ++i) {
+        float value;
+        memcpy(&value, &ctx->fconstPool[i], sizeof(value));
+        fprintf(F, "fconst_%d: .word 0x%08x    # %.9g\n", i, ctx->fconstPool[i], value);
+    }
+}
+
+
+// string literal pool
+//
+// write("...") used to switch to .data and back for every literal. literals
+// are interned here instead, identical ones share a label, and the whole
+// table is emitted as one .data block by emitAppendix(ctx)
+
+// the label index of a string literal (with its quotes), added to the pool
+// if it's new. `literal` must be interned, identical literals are the same
+// pointer and the pool keeps it, the arena outlives code generation
+static int getStringConst (CompilerContext *ctx, const char *literal) {
+    unsigned int mask;
+    unsigned int slot;
+    int i;
+
+    if (ctx->strconstCount == ctx->strconstCapacity) {
+        int capacity = ctx->strconstCapacity ? ctx->strconstCapacity * 2 : 16;
+        const char **pool = realloc(ctx->strconstPool, capacity * sizeof(char *));
+        int *index = calloc(capacity * 2, sizeof(int));
+        if (!pool || !index) {
+            free(index);
+            if (pool)
+                ctx->strconstPool = pool;
+            compileFailed(ctx, "[-] out of memory");
+        }
+        mask = capacity * 2 - 1;
+        for (i = 0; i < ctx->strconstCount; ++i) {
+            for (slot = internedHash(pool[i]) & mask; index[slot]; slot = (slot + 1) & mask)
+                ;
+            index[slot] = i + 1;
+        }
+        free(ctx->strconstIndex);
+        ctx->strconstPool = pool;
+        ctx->strconstIndex = index;
+        ctx->strconstCapacity = capacity;
+    }
+
+    mask = ctx->strconstCapacity * 2 - 1;
+    for (slot = internedHash(literal) & mask; ctx->strconstIndex[slot]; slot = (slot + 1) & mask) {
+        if (ctx->strconstPool[ctx->strconstIndex[slot] - 1] == literal)
+            return ctx->strconstIndex[slot] - 1;
+    }
+    ctx->strconstIndex[slot] = ctx->strconstCount + 1;
+    ctx->strconstPool[ctx->strconstCount] = literal;
+    return ctx->strconstCount++;
+}
+
+static void emitStringConstPool (CompilerContext *ctx, FILE *F) {
+    int i;
+
+    for (i = 0; i < ctx->strconstCount; ++i)
+        fprintf(F, "str_%d: .asciiz %s\n", i, ctx->strconstPool[i]);
+}
+
+
+// write() coalescing
+//
+// consecutive write("...") statements are merged into one literal and one
+// syscall, and write(int) followed by write("...") becomes a single call to
+// __write_int_str, which formats the int in front of the string and prints
+// both with one syscall. runtime labels start with "__", C-- identifiers
+// can't, so they never clash with "_name" globals
+
+// the string argument of a write("...") statement, NULL for anything else
+static AST_NODE *getWriteString (CompilerContext *ctx, AST_NODE *stmt) {
+    if (stmt == NULL || stmt->nodeType != STMT_NODE || stmt->semantic_value.stmtSemanticValue.kind != FUNCTION_CALL_STMT)
+        return NULL;
+    if (stmt->child->semantic_value.identifierSemanticValue.identifierName != ctx->internedWrite)
+        return NULL;
+
+    AST_NODE *param = stmt->child->rightSibling->child;
+    if (param == NULL || param->nodeType != CONST_VALUE_NODE || param->semantic_value.const1->const_type != STRINGC)
+        return NULL;
+    return param;
+}
+
+// merge the literal of `first` with the write("...") statements right after
+// it in the same statement list, *last is set to the last one merged.
+// returns the label index of the merged literal
+static int mergeWriteStrings (CompilerContext *ctx, AST_NODE *first, AST_NODE **last) {
+    const char *literal = getWriteString(ctx, first)->semantic_value.const1->const_u.sc;
+    AST_NODE *next = first->rightSibling;
+
+    *last = first;
+    if (first->parent == NULL || first->parent->nodeType != STMT_LIST_NODE || getWriteString(ctx, next) == NULL)
+        return getStringConst(ctx, literal);
+
+    // "abc" + "\n" -> "abc\n"
+    int length = strlen(literal) - 1;
+    char *merged = malloc(length + 1);
+    if (!merged) {
+        compileFailed(ctx, "[-] out of memory");
+    }
+    memcpy(merged, literal, length);
+
+    while (getWriteString(ctx, next) != NULL) {
+        const char *more = getWriteString(ctx, next)->semantic_value.const1->const_u.sc;
+        int moreLength = strlen(more) - 2;
+
+        merged = realloc(merged, length + moreLength + 2);
+        if (!merged) {
+            compileFailed(ctx, "[-] out of memory");
+        }
+        memcpy(merged + length, more + 1, moreLength);
+        length += moreLength;
+
+        *last = next;
+        next = next->rightSibling;
+    }
+    merged[length] = '"';
+    merged[length + 1] = '\0';
+
+    // interned like the literals, so that the same merged text gets one label
+    const char *interned = internSlice(ctx, merged, length + 1);
+    free(merged);
+    return getStringConst(ctx, interned);
+}
+
+// format the int in $a0 backwards in front of the address in $t0, $t0 is
+// left at its first character. uses $t1 ~ $t3
+static void emitFormatInt (FILE *F, const char *prefix) {
+    fprintf(F, "move    $t1, $a0\n");
+    fprintf(F, "li      $t3, 10\n");
+    fprintf(F, "bgez    $a0, %s_digit\n", prefix);
+    fprintf(F, "subu    $t1, $zero, $a0\n");
+    fprintf(F, "%s_digit:\n", prefix);
+    fprintf(F, "divu    $t1, $t3\n");
+    fprintf(F, "mfhi    $t2\n");
+    fprintf(F, "mflo    $t1\n");
+    fprintf(F, "addiu   $t2, $t2, 48\n");
+    fprintf(F, "addiu   $t0, $t0, -1\n");
+    fprintf(F, "sb      $t2, ($t0)\n");
+    fprintf(F, "bnez    $t1, %s_digit\n", prefix);
+    fprintf(F, "bgez    $a0, %s_sign\n", prefix);
+    fprintf(F, "li      $t2, 45\n");
+    fprintf(F, "addiu   $t0, $t0, -1\n");
+    fprintf(F, "sb      $t2, ($t0)\n");
+    fprintf(F, "%s_sign:\n", prefix);
+}
+
+static void emitWriteRuntime (CompilerContext *ctx, FILE *F) {
+    if (!ctx->useWriteIntStr)
+        return;
+
+    // __write_int_str: print the int in $a0 and then the string at $a1
+    // digits are put in front of __write_buf+11, the string is copied after
+    // them
+    fprintf(F, ".text\n");
+    fprintf(F, "__write_int_str:\n");
+    fprintf(F, "la      $t0, __write_buf+11\n");
+    emitFormatInt(F, "__write_int_str");
+    fprintf(F, "la      $t1, __write_buf+11\n");
+    fprintf(F, "__write_int_str_char:\n");
+    fprintf(F, "lb      $t2, ($a1)\n");
+    fprintf(F, "sb      $t2, ($t1)\n");
+    fprintf(F, "addiu   $a1, $a1, 1\n");
+    fprintf(F, "addiu   $t1, $t1, 1\n");
+    fprintf(F, "bnez    $t2, __write_int_str_char\n");
+    fprintf(F, "move    $a0, $t0\n");
+    fprintf(F, "li      $v0, 4\n");
+    fprintf(F, "syscall\n");
+    fprintf(F, "jr      $ra\n");
+}
+
+
+// buffered output (--buffered-io)
+//
+// write() appends to __buf instead of making a syscall per value, the
+// buffer is printed with one syscall 4 when it fills up, before reading
+// input and when main returns. floats are still printed by syscall 2 after
+// a flush, formatting them the way spim does isn't worth it in MIPS code
+#define OUTPUT_BUFFER_SIZE 4096
+
+static void emitBufferRuntime (CompilerContext *ctx, FILE *F) {
+    if (!ctx->bufferedIO)
+        return;
+
+    fprintf(F, ".text\n");
+
+    // __buf_flush: print and empty the buffer, uses $a0, $v0, $t0 and $t1
+    fprintf(F, "__buf_flush:\n");
+    fprintf(F, "lw      $t0, __buf_len\n");
+    fprintf(F, "beqz    $t0, __buf_flush_done\n");
+    fprintf(F, "la      $t1, __buf\n");
+    fprintf(F, "add     $t1, $t1, $t0\n");
+    fprintf(F, "sb      $zero, ($t1)\n");
+    fprintf(F, "la      $a0, __buf\n");
+    fprintf(F, "li      $v0, 4\n");
+    fprintf(F, "syscall\n");
+    fprintf(F, "sw      $zero, __buf_len\n");
+    fprintf(F, "__buf_flush_done:\n");
+    fprintf(F, "jr      $ra\n");
+
+    // __buf_put_int: append the int in $a0
+    fprintf(F, "__buf_put_int:\n");
+    fprintf(F, "la      $t0, __buf_digits+11\n");
+    fprintf(F, "sb      $zero, ($t0)\n");
+    emitFormatInt(F, "__buf_put_int");
+    fprintf(F, "move    $a1, $t0\n");
+
+    // __buf_put_str: append the string at $a1, $t9 keeps $ra across flushes
+    fprintf(F, "__buf_put_str:\n");
+    fprintf(F, "move    $t9, $ra\n");
+    fprintf(F, "lw      $t0, __buf_len\n");
+    fprintf(F, "li      $t3, %d\n", OUTPUT_BUFFER_SIZE);
+    fprintf(F, "__buf_put_str_char:\n");
+    fprintf(F, "lb      $t2, ($a1)\n");
+    fprintf(F, "beqz    $t2, __buf_put_str_done\n");
+    fprintf(F, "bne     $t0, $t3, __buf_put_str_store\n");
+    fprintf(F, "sw      $t0, __buf_len\n");
+    fprintf(F, "jal     __buf_flush\n");
+    fprintf(F, "li      $t0, 0\n");
+    fprintf(F, "__buf_put_str_store:\n");
+    fprintf(F, "la      $t1, __buf\n");
+    fprintf(F, "add     $t1, $t1, $t0\n");
+    fprintf(F, "sb      $t2, ($t1)\n");
+    fprintf(F, "addiu   $t0, $t0, 1\n");
+    fprintf(F, "addiu   $a1, $a1, 1\n");
+    fprintf(F, "j       __buf_put_str_char\n");
+    fprintf(F, "__buf_put_str_done:\n");
+    fprintf(F, "sw      $t0, __buf_len\n");
+    fprintf(F, "move    $ra, $t9\n");
+    fprintf(F, "jr      $ra\n");
+
+    fprintf(F, ".data\n");
+    fprintf(F, ".align  2\n");
+    fprintf(F, "__buf_len: .word 0\n");
+    fprintf(F, "__buf_digits: .space 12\n");
+    fprintf(F, "__buf: .space %d\n", OUTPUT_BUFFER_SIZE + 1);
+}
+
+
+// batched input (--batched-input)
+//
+// read() and fread() call __read_int / __read_float, which parse numbers out
+// of __in_buf. the buffer is refilled with syscall 8, which reads up to a
+// newline, so a refill is a line of input at most (and the output buffer is
+// flushed first, so prompts still show up). numbers may cross a chunk
+// boundary, an empty chunk is the end of input and reads as 0, like syscall
+// 5 and 6 do.
+//
+// registers: __in_pos is kept in $t0 and the current character in $t2,
+// __in_char and __in_refill may use $t1, $a0, $a1 and $v0, so the parsers
+// keep their state in $t3 ~ $t5, $t7 and $f0, $f16, $f17, which are not in
+// the RA pool. $ra is saved in $t9 by the parsers, $t6 by __in_char and $t8 by
+// __in_refill
+
+#define INPUT_BUFFER_SIZE 4096
+
+// skip blanks from $t0, $t2 is the first other character (0 at the end)
+static void emitSkipBlanks (FILE *F, const char *prefix) {
+    fprintf(F, "lw      $t0, __in_pos\n");
+    fprintf(F, "bnez    $t0, %s_blank\n", prefix);
+    fprintf(F, "la      $t0, __in_buf\n");
+    fprintf(F, "%s_blank:\n", prefix);
+    fprintf(F, "jal     __in_char\n");
+    fprintf(F, "beqz    $t2, %s_sign\n", prefix);
+    fprintf(F, "li      $t1, 32\n");
+    fprintf(F, "bgt     $t2, $t1, %s_sign\n", prefix);
+    fprintf(F, "addiu   $t0, $t0, 1\n");
+    fprintf(F, "j       %s_blank\n", prefix);
+
+    // $t3 = 1 for a minus sign
+    fprintf(F, "%s_sign:\n", prefix);
+    fprintf(F, "li      $t3, 0\n");
+    fprintf(F, "li      $t1, 43\n");
+    fprintf(F, "beq     $t2, $t1, %s_signed\n", prefix);
+    fprintf(F, "li      $t1, 45\n");
+    fprintf(F, "bne     $t2, $t1, %s_unsigned\n", prefix);
+    fprintf(F, "li      $t3, 1\n");
+    fprintf(F, "%s_signed:\n", prefix);
+    fprintf(F, "addiu   $t0, $t0, 1\n");
+    fprintf(F, "%s_unsigned:\n", prefix);
+}
+
+// loop over the digits from $t0, `label` gets the digit's value in $t2 and
+// jumps back to `prefix`_digits, the loop leaves to `prefix`_end
+static void emitDigitLoop (FILE *F, const char *prefix, const char *label) {
+    fprintf(F, "%s_digits:\n", prefix);
+    fprintf(F, "jal     __in_char\n");
+    fprintf(F, "addiu   $t2, $t2, -48\n");
+    fprintf(F, "sltiu   $t1, $t2, 10\n");
+    fprintf(F, "beqz    $t1, %s_end\n", prefix);
+    fprintf(F, "addiu   $t0, $t0, 1\n");
+    fprintf(F, "j       %s\n", label);
+}
+
+static void emitInputRuntime (CompilerContext *ctx, FILE *F) {
+    if (!ctx->batchedInput)
+        return;
+
+    fprintf(F, ".text\n");
+
+    // __in_refill: read the next chunk, $t0 is set to its start
+    fprintf(F, "__in_refill:\n");
+    if (ctx->bufferedIO) {
+        fprintf(F, "move    $t8, $ra\n");
+        fprintf(F, "jal     __buf_flush\n");
+        fprintf(F, "move    $ra, $t8\n");
+    }
+    fprintf(F, "la      $a0, __in_buf\n");
+    fprintf(F, "sb      $zero, ($a0)\n");
+    fprintf(F, "li      $a1, %d\n", INPUT_BUFFER_SIZE);
+    fprintf(F, "li      $v0, 8\n");
+    fprintf(F, "syscall\n");
+    fprintf(F, "la      $t0, __in_buf\n");
+    fprintf(F, "jr      $ra\n");
+
+    // __in_char: $t2 = the character at $t0, refill at the end of the chunk
+    fprintf(F, "__in_char:\n");
+    fprintf(F, "lb      $t2, ($t0)\n");
+    fprintf(F, "bnez    $t2, __in_char_done\n");
+    fprintf(F, "move    $t6, $ra\n");
+    fprintf(F, "jal     __in_refill\n");
+    fprintf(F, "move    $ra, $t6\n");
+    fprintf(F, "lb      $t2, ($t0)\n");
+    fprintf(F, "__in_char_done:\n");
+    fprintf(F, "jr      $ra\n");
+
+    // __read_int: $v0 = the next int, accumulated in $t4
+    fprintf(F, "__read_int:\n");
+    fprintf(F, "move    $t9, $ra\n");
+    emitSkipBlanks(F, "__read_int");
+    fprintf(F, "li      $t4, 0\n");
+    fprintf(F, "j       __read_int_digits\n");
+    fprintf(F, "__read_int_add:\n");
+    fprintf(F, "sll     $t1, $t4, 3\n");
+    fprintf(F, "sll     $t4, $t4, 1\n");
+    fprintf(F, "addu    $t4, $t4, $t1\n");
+    fprintf(F, "addu    $t4, $t4, $t2\n");
+    emitDigitLoop(F, "__read_int", "__read_int_add");
+    fprintf(F, "__read_int_end:\n");
+    fprintf(F, "sw      $t0, __in_pos\n");
+    fprintf(F, "move    $v0, $t4\n");
+    fprintf(F, "beqz    $t3, __read_int_return\n");
+    fprintf(F, "subu    $v0, $zero, $t4\n");
+    fprintf(F, "__read_int_return:\n");
+    fprintf(F, "move    $ra, $t9\n");
+    fprintf(F, "jr      $ra\n");
+
+    // __read_float: $f0 = the next float, [-]digits[.digits][e[+-]digits]
+    // the digits are accumulated in $t4 as an integer, $t5 is the power of
+    // ten it is scaled by. the mantissa is converted once and multiplied or
+    // divided by 10^|$t5| once. digits after the ninth don't fit in $t4 and
+    // are dropped, a float only keeps about seven anyway
+    fprintf(F, "__read_float:\n");
+    fprintf(F, "move    $t9, $ra\n");
+    emitSkipBlanks(F, "__read_float");
+    fprintf(F, "li      $t4, 0\n");
+    fprintf(F, "li      $t5, 0\n");
+    fprintf(F, "j       __read_float_int_digits\n");
+    fprintf(F, "__read_float_int_drop:\n");
+    fprintf(F, "addiu   $t5, $t5, 1\n");
+    fprintf(F, "j       __read_float_int_digits\n");
+    fprintf(F, "__read_float_int_add:\n");
+    fprintf(F, "li      $t1, 100000000\n");
+    fprintf(F, "slt     $t1, $t4, $t1\n");
+    fprintf(F, "beqz    $t1, __read_float_int_drop\n");
+    fprintf(F, "sll     $t1, $t4, 3\n");
+    fprintf(F, "sll     $t4, $t4, 1\n");
+    fprintf(F, "addu    $t4, $t4, $t1\n");
+    fprintf(F, "addu    $t4, $t4, $t2\n");
+    emitDigitLoop(F, "__read_float_int", "__read_float_int_add");
+
+    // '.' - '0' == -2
+    fprintf(F, "__read_float_int_end:\n");
+    fprintf(F, "li      $t1, -2\n");
+    fprintf(F, "bne     $t2, $t1, __read_float_frac_end\n");
+    fprintf(F, "addiu   $t0, $t0, 1\n");
+    fprintf(F, "j       __read_float_frac_digits\n");
+    fprintf(F, "__read_float_frac_add:\n");
+    fprintf(F, "li      $t1, 100000000\n");
+    fprintf(F, "slt     $t1, $t4, $t1\n");
+    fprintf(F, "beqz    $t1, __read_float_frac_digits\n");
+    fprintf(F, "sll     $t1, $t4, 3\n");
+    fprintf(F, "sll     $t4, $t4, 1\n");
+    fprintf(F, "addu    $t4, $t4, $t1\n");
+    fprintf(F, "addu    $t4, $t4, $t2\n");
+    fprintf(F, "addiu   $t5, $t5, -1\n");
+    emitDigitLoop(F, "__read_float_frac", "__read_float_frac_add");
+
+    // the mantissa is complete, $t4 is reused for the exponent sign and the
+    // exponent is accumulated in $t7. 'e' - '0' == 53, 'E' - '0' == 21
+    fprintf(F, "__read_float_frac_end:\n");
+    fprintf(F, "mtc1    $t4, $f0\n");
+    fprintf(F, "cvt.s.w $f0, $f0\n");
+    fprintf(F, "li      $t1, 53\n");
+    fprintf(F, "beq     $t2, $t1, __read_float_exp\n");
+    fprintf(F, "li      $t1, 21\n");
+    fprintf(F, "bne     $t2, $t1, __read_float_scale\n");
+    fprintf(F, "__read_float_exp:\n");
+    fprintf(F, "addiu   $t0, $t0, 1\n");
+    fprintf(F, "li      $t4, 0\n");
+    fprintf(F, "li      $t7, 0\n");
+    fprintf(F, "jal     __in_char\n");
+    fprintf(F, "li      $t1, 43\n");
+    fprintf(F, "beq     $t2, $t1, __read_float_exp_signed\n");
+    fprintf(F, "li      $t1, 45\n");
+    fprintf(F, "bne     $t2, $t1, __read_float_exp_digits\n");
+    fprintf(F, "li      $t4, 1\n");
+    fprintf(F, "__read_float_exp_signed:\n");
+    fprintf(F, "addiu   $t0, $t0, 1\n");
+    fprintf(F, "j       __read_float_exp_digits\n");
+    fprintf(F, "__read_float_exp_add:\n");
+    fprintf(F, "sll     $t1, $t7, 3\n");
+    fprintf(F, "sll     $t7, $t7, 1\n");
+    fprintf(F, "addu    $t7, $t7, $t1\n");
+    fprintf(F, "addu    $t7, $t7, $t2\n");
+    emitDigitLoop(F, "__read_float_exp", "__read_float_exp_add");
+    fprintf(F, "__read_float_exp_end:\n");
+    fprintf(F, "beqz    $t4, __read_float_exp_add_scale\n");
+    fprintf(F, "subu    $t7, $zero, $t7\n");
+    fprintf(F, "__read_float_exp_add_scale:\n");
+    fprintf(F, "addu    $t5, $t5, $t7\n");
+
+    // $f17 = 10^|$t5|, counted down in $t7, $f16 is 10.0
+    fprintf(F, "__read_float_scale:\n");
+    fprintf(F, "sw      $t0, __in_pos\n");
+    fprintf(F, "li      $t1, 10\n");
+    fprintf(F, "mtc1    $t1, $f16\n");
+    fprintf(F, "cvt.s.w $f16, $f16\n");
+    fprintf(F, "li      $t1, 1\n");
+    fprintf(F, "mtc1    $t1, $f17\n");
+    fprintf(F, "cvt.s.w $f17, $f17\n");
+    fprintf(F, "move    $t7, $t5\n");
+    fprintf(F, "bgez    $t5, __read_float_pow\n");
+    fprintf(F, "subu    $t7, $zero, $t5\n");
+    fprintf(F, "__read_float_pow:\n");
+    fprintf(F, "beqz    $t7, __read_float_pow_end\n");
+    fprintf(F, "mul.s   $f17, $f17, $f16\n");
+    fprintf(F, "addiu   $t7, $t7, -1\n");
+    fprintf(F, "j       __read_float_pow\n");
+    fprintf(F, "__read_float_pow_end:\n");
+    fprintf(F, "bltz    $t5, __read_float_div\n");
+    fprintf(F, "mul.s   $f0, $f0, $f17\n");
+    fprintf(F, "j       __read_float_end\n");
+    fprintf(F, "__read_float_div:\n");
+    fprintf(F, "div.s   $f0, $f0, $f17\n");
+
+    fprintf(F, "__read_float_end:\n");
+    fprintf(F, "beqz    $t3, __read_float_return\n");
+    fprintf(F, "neg.s   $f0, $f0\n");
+    fprintf(F, "__read_float_return:\n");
+    fprintf(F, "move    $ra, $t9\n");
+    fprintf(F, "jr      $ra\n");
+
+    fprintf(F, ".data\n");
+    fprintf(F, ".align  2\n");
+    fprintf(F, "__in_pos: .word 0\n");
+    fprintf(F, "__in_buf: .space %d\n", INPUT_BUFFER_SIZE + 1);
+}
+
+
+// the value of a constant initializer, converted to the declared type
+static float getInitFloat (AST_NODE *init) {
+    if (init->nodeType == CONST_VALUE_NODE) {
+        if (init->semantic_value.const1->const_type == FLOATC)
+            return init->semantic_value.const1->const_u.fval;
+        return init->semantic_value.const1->const_u.intval;
+    }
+    if (init->dataType == FLOAT_TYPE)
+        return init->semantic_value.exprSemanticValue.constEvalValue.fValue;
+    return init->semantic_value.exprSemanticValue.constEvalValue.iValue;
+}
+
+static int getInitInt (AST_NODE *init) {
+    if (init->nodeType == CONST_VALUE_NODE) {
+        if (init->semantic_value.const1->const_type == FLOATC)
+            return init->semantic_value.const1->const_u.fval;
+        return init->semantic_value.const1->const_u.intval;
+    }
+    if (init->dataType == FLOAT_TYPE)
+        return init->semantic_value.exprSemanticValue.constEvalValue.fValue;
+    return init->semantic_value.exprSemanticValue.constEvalValue.iValue;
+}
+
+
+// put an int operand (a variable, a constant or the top of the memory stack)
+// into a float register, converting it with cvt.s.w
+static void emitIntToFloat (FILE *F, AST_NODE *operand, const char *reg) {
+    if (operand->nodeType == IDENTIFIER_NODE) {
+        if (operand->semantic_value.identifierSemanticValue.symbolTableEntry->nestingLevel == 0)
+            fprintf(F, "lw      $t0, _%s\n", operand->semantic_value.identifierSemanticValue.identifierName);
+        else
+            fprintf(F, "lw      $t0, %d($fp)\n", operand->semantic_value.identifierSemanticValue.symbolTableEntry->offset);
+    }
+    else if (operand->nodeType == CONST_VALUE_NODE) {
+        fprintf(F, "li      $t0, %d\n", operand->semantic_value.const1->const_u.intval);
+    }
+    else {
+        fprintf(F, "lw      $t0, 4($sp)\n");
+        fprintf(F, "add     $sp, $sp, 4\n");
+    }
+
+    fprintf(F, "mtc1    $t0, %s\n", reg);
+    fprintf(F, "cvt.s.w %s, %s\n", reg, reg);
+}
+
+
+// load a float variable or constant into a register
+static void emitLoadFloat (CompilerContext *ctx, FILE *F, AST_NODE *leaf, const char *reg) {
+    if (leaf->nodeType == CONST_VALUE_NODE) {
+        fprintf(F, "l.s     %s, fconst_%d\n", reg, getFloatConst(ctx, leaf->semantic_value.const1->const_u.fval));
+    }
+    else if (leaf->semantic_value.identifierSemanticValue.symbolTableEntry->nestingLevel == 0) {
+        fprintf(F, "l.s     %s, _%s\n", reg, leaf->semantic_value.identifierSemanticValue.identifierName);
+    }
+    else {
+        fprintf(F, "l.s     %s, %d($fp)\n", reg, leaf->semantic_value.identifierSemanticValue.symbolTableEntry->offset);
+    }
+}
+
+
+// get an operand of a float operation into a register: leaves are loaded
+// into `scratch`, evaluated subexpressions are popped from the RA pool
+static const char *emitFloatOperand (CompilerContext *ctx, FILE *F, AST_NODE *operand, const char *scratch) {
+    if (operand->dataType == INT_TYPE) {
+        emitIntToFloat(F, operand, scratch);
+        return scratch;
+    }
+    if (operand->nodeType == IDENTIFIER_NODE || operand->nodeType == CONST_VALUE_NODE) {
+        emitLoadFloat(ctx, F, operand, scratch);
+        return scratch;
+    }
+    return fregPop(ctx, F, scratch);
+}
+
+
+// if/while on a float: pop it and push its truth value to the memory stack
+static void emitFloatCondition (CompilerContext *ctx, FILE *F) {
+    char condLabel[20];
+    sprintf(condLabel, "fcondl_%d", ctx->labelCount++);
+
+    const char *cond = fregPop(ctx, F, "$f0");
+    fprintf(F, "mtc1    $zero, $f1\n");
+    fprintf(F, "c.eq.s  %s, $f1\n", cond);
+    fprintf(F, "li      $t0, 0\n");
+    fprintf(F, "bc1t    %s\n", condLabel);
+    fprintf(F, "li      $t0, 1\n");
+    fprintf(F, "%s:\n", condLabel);
+    fprintf(F, "sw      $t0, ($sp)\n");
+    fprintf(F, "sub     $sp, $sp, 4\n");
+}
+
+
 // xatier: nothing here, preserve for the future
 void emitPreface (FILE *F, AST_NODE *prog) {
     _DBG(F, prog, "start");
@@ -70,15 +755,12 @@ void emitPreface (FILE *F, AST_NODE *prog) {
                         break;
 
                     // xatier: id with initialization
+                    // the declared type is on the type node, id nodes don't carry it
                     case WITH_INIT_ID:
-                        if (id->dataType == FLOAT_TYPE && id->child->nodeType == CONST_VALUE_NODE)
-                            fprintf(F, "_%s: .float %f\n", id->semantic_value.identifierSemanticValue.identifierName, id->child->semantic_value.const1->const_u.fval);
-                        else if (id->dataType == FLOAT_TYPE && id->child->nodeType == EXPR_NODE)
-                            fprintf(F, "_%s: .float %f\n", id->semantic_value.identifierSemanticValue.identifierName, id->child->semantic_value.exprSemanticValue.constEvalValue.fValue);
-                        else if (id->child->nodeType == CONST_VALUE_NODE)
-                            fprintf(F, "_%s: .word %d\n", id->semantic_value.identifierSemanticValue.identifierName, id->child->semantic_value.const1->const_u.intval);
+                        if (decl->child->dataType == FLOAT_TYPE)
+                            fprintf(F, "_%s: .word 0x%08x\n", id->semantic_value.identifierSemanticValue.identifierName, floatBits(getInitFloat(id->child)));
                         else
-                            fprintf(F, "_%s: .word %d\n", id->semantic_value.identifierSemanticValue.identifierName, id->child->semantic_value.exprSemanticValue.constEvalValue.iValue);
+                            fprintf(F, "_%s: .word %d\n", id->semantic_value.identifierSemanticValue.identifierName, getInitInt(id->child));
                         break;
 
                     default:
@@ -228,9 +910,20 @@ void emitPreface (FILE *F, AST_NODE *prog) {
 
 
 
-// xatier: nothing here, preserve for the future
-void emitAppendix (FILE *F, AST_NODE *prog) {
+void emitAppendix (CompilerContext *ctx, FILE *F, AST_NODE *prog) {
     _DBG(F, prog, "end");
+    emitWriteRuntime(ctx, F);
+    emitBufferRuntime(ctx, F);
+    emitInputRuntime(ctx, F);
+
+    // constant pools, words first so they stay aligned
+    if (ctx->fconstCount > 0 || ctx->strconstCount > 0) {
+        fprintf(F, ".data\n");
+        emitFloatConstPool(ctx, F);
+        if (ctx->useWriteIntStr)
+            fprintf(F, "__write_buf: .space %d\n", ctx->writeBufSize);
+        emitStringConstPool(ctx, F);
+    }
     return;
 }
 
@@ -241,7 +934,7 @@ void emitBeforeBlock (FILE *F, AST_NODE *blockNode) {
 }
 
 
-void emitAfterBlock (FILE *F, AST_NODE *blockNode) {
+void emitAfterBlock (CompilerContext *ctx, FILE *F, AST_NODE *blockNode) {
     _DBG(F, blockNode, "block }");
 
     if (blockNode->child->nodeType != VARIABLE_DECL_LIST_NODE)
@@ -285,82 +978,90 @@ void emitAfterBlock (FILE *F, AST_NODE *blockNode) {
         decl = decl->rightSibling;
     }
 
-    ARoffset += total;
+    ctx->ARoffset += total;
     return;
 }
 
 
-void emitAssignStmt (FILE *F, AST_NODE *assignmentNode) {
+void emitAssignStmt (CompilerContext *ctx, FILE *F, AST_NODE *assignmentNode) {
     _DBG(F, assignmentNode, "assign =");
     SymbolTableEntry *entry = assignmentNode->child->semantic_value.identifierSemanticValue.symbolTableEntry;
 
     if (assignmentNode->child->rightSibling->nodeType == EXPR_NODE || assignmentNode->child->rightSibling->nodeType == STMT_NODE)
-        walkTree(F, assignmentNode->child->rightSibling);
+        walkTree(ctx, F, assignmentNode->child->rightSibling);
     else
-        emitArithmeticStmt(F, assignmentNode->child->rightSibling);
-
-    fprintf(F, "sw      $t0, ($sp)\n");
-    fprintf(F, "sub     $sp, $sp, 4\n");
+        emitArithmeticStmt(ctx, F, assignmentNode->child->rightSibling);
 
-    if (assignmentNode->child->dataType == INT_TYPE) {
+    if (assignmentNode->child->dataType == INT_TYPE && assignmentNode->child->rightSibling->dataType == INT_TYPE) {
+        fprintf(F, "sw      $t0, ($sp)\n");
+        fprintf(F, "sub     $sp, $sp, 4\n");
         fprintf(F, "lw      $t0, 8($sp)\n");
         if (entry->nestingLevel == 0)
             fprintf(F, "sw      $t0, _%s\n", assignmentNode->child->semantic_value.identifierSemanticValue.identifierName);
         else
             fprintf(F, "sw      $t0, %d($fp)\n", entry->offset);
+        fprintf(F, "lw      $t0, 4($sp)\n");
+        fprintf(F, "addiu   $sp, $sp, 8\n");
+    }
+    else if (assignmentNode->child->dataType == INT_TYPE && assignmentNode->child->rightSibling->dataType == FLOAT_TYPE) {
+        // assign int <- float, truncate like C does
+        const char *src = fregPop(ctx, F, "$f0");
+        fprintf(F, "trunc.w.s $f0, %s\n", src);
+        fprintf(F, "mfc1    $t0, $f0\n");
+        if (entry->nestingLevel == 0)
+            fprintf(F, "sw      $t0, _%s\n", assignmentNode->child->semantic_value.identifierSemanticValue.identifierName);
+        else
+            fprintf(F, "sw      $t0, %d($fp)\n", entry->offset);
     }
     else if (assignmentNode->child->dataType == FLOAT_TYPE) {
+        const char *src = NULL;
         if (assignmentNode->child->rightSibling->dataType == INT_TYPE) {
             // assign float <- int
-            fprintf(F, "lw      $t0, 8($sp)\n");
+            src = "$f0";
+            fprintf(F, "lw      $t0, 4($sp)\n");
+            fprintf(F, "add     $sp, $sp, 4\n");
             fprintf(F, "mtc1    $t0, $f0\n");
-            fprintf(F, "nop");
-            if (entry->nestingLevel == 0)
-                fprintf(F, "swc1    $f0, _%s\n", assignmentNode->child->semantic_value.identifierSemanticValue.identifierName);
-            else
-                fprintf(F, "swc1    $f0, %d($fp)\n", entry->offset);
+            fprintf(F, "cvt.s.w $f0, $f0\n");
         }
         else if (assignmentNode->child->rightSibling->dataType == FLOAT_TYPE) {
             // assign float <- float
-            fprintf(F, "lwc1    $f0, 8($sp)\n");
-            if (entry->nestingLevel == 0)
-                fprintf(F, "swc1    $f0, _%s\n", assignmentNode->child->semantic_value.identifierSemanticValue.identifierName);
-            else
-                fprintf(F, "swc1    $f0, %d($fp)\n", entry->offset);
-
+            src = fregPop(ctx, F, "$f0");
         }
         else {
-            printf("invalid assignment! [float <- ?]\n");
-            exit(1);
+            compileFailed(ctx, "invalid assignment! [float <- ?]");
         }
+
+        if (entry->nestingLevel == 0)
+            fprintf(F, "s.s     %s, _%s\n", src, assignmentNode->child->semantic_value.identifierSemanticValue.identifierName);
+        else
+            fprintf(F, "s.s     %s, %d($fp)\n", src, entry->offset);
     }
     else {
-        printf("invalid assignment! [? <- ?]\n");
-        exit(1);
+        compileFailed(ctx, "invalid assignment! [? <- ?]");
     }
 
-    fprintf(F, "lw      $t0, 4($sp)\n");
-    fprintf(F, "addiu   $sp, $sp, 8\n");
-
     return;
 }
 
 
-void emitIfStmt (FILE *F, AST_NODE *ifNode) {
+void emitIfStmt (CompilerContext *ctx, FILE *F, AST_NODE *ifNode) {
     _DBG(F, ifNode, "if ( ... )");
     AST_NODE *ifBlock = ifNode->child->rightSibling;
 
     char ifLabel[20];
-    sprintf(ifLabel, "ifl_%d", rand() % 10000);
+    sprintf(ifLabel, "ifl_%d", ctx->labelCount++);
 
     if (ifNode->child->nodeType == EXPR_NODE) {
         AST_NODE *temp = ifNode->child->rightSibling;
         ifNode->child->rightSibling = NULL;
-        walkTree(F, ifNode->child);
+        walkTree(ctx, F, ifNode->child);
         ifNode->child->rightSibling = temp;
     }
     else
-        emitArithmeticStmt(F, ifNode->child);
+        emitArithmeticStmt(ctx, F, ifNode->child);
+
+    if (ifNode->child->dataType == FLOAT_TYPE)
+        emitFloatCondition(ctx, F);
 
     fprintf(F, "sw      $t0, ($sp)\n");
     fprintf(F, "sub     $sp, $sp, 4\n");
@@ -374,7 +1075,7 @@ void emitIfStmt (FILE *F, AST_NODE *ifNode) {
     fprintf(F, "addiu   $sp, $sp, 8\n");
 
     _DBG(F, ifBlock, "block {");
-    walkTree(F, ifBlock->child);
+    walkTree(ctx, F, ifBlock->child);
     _DBG(F, ifBlock, "block }");
 
     fprintf(F, "j       %s_exit\n", ifLabel);
@@ -382,21 +1083,22 @@ void emitIfStmt (FILE *F, AST_NODE *ifNode) {
     fprintf(F, "%s_else:\n", ifLabel);
     if (ifBlock->rightSibling->nodeType != NUL_NODE) {
         // else-if
-        if (ifBlock->rightSibling->semantic_value.stmtSemanticValue.kind == IF_STMT) {
-            emitIfStmt(F, ifBlock->rightSibling);
+        if (ifBlock->rightSibling->nodeType == STMT_NODE &&
+            ifBlock->rightSibling->semantic_value.stmtSemanticValue.kind == IF_STMT) {
+            emitIfStmt(ctx, F, ifBlock->rightSibling);
         }
         // only else
         else {
-            walkTree(F, ifBlock->rightSibling);
+            walkTree(ctx, F, ifBlock->rightSibling);
         }
     }
     fprintf(F, "%s_exit:\n", ifLabel);
 }
 
 
-void emitWhileStmt (FILE *F, AST_NODE *whileNode) {
+void emitWhileStmt (CompilerContext *ctx, FILE *F, AST_NODE *whileNode) {
     char whileLabel[20];
-    sprintf(whileLabel, "whilel_%d", rand() % 10000);
+    sprintf(whileLabel, "whilel_%d", ctx->labelCount++);
     _DBG(F, whileNode, "while ( ... )");
 
     fprintf(F, "%s:\n", whileLabel);
@@ -404,16 +1106,19 @@ void emitWhileStmt (FILE *F, AST_NODE *whileNode) {
     if (whileNode->child->nodeType == EXPR_NODE) {
         AST_NODE *temp = whileNode->child->rightSibling;
         whileNode->child->rightSibling = NULL;
-        walkTree(F, whileNode->child);
+        walkTree(ctx, F, whileNode->child);
         whileNode->child->rightSibling = temp;
     }
     else
-        emitArithmeticStmt(F, whileNode->child);
+        emitArithmeticStmt(ctx, F, whileNode->child);
+
+    if (whileNode->child->dataType == FLOAT_TYPE)
+        emitFloatCondition(ctx, F);
 
     fprintf(F, "lw      $t0, 4($sp)\n");
     fprintf(F, "add     $sp, $sp, 4\n");
     fprintf(F, "beqz    $t0, %s_exit\n", whileLabel);
-    walkTree(F, whileNode->child->rightSibling);
+    walkTree(ctx, F, whileNode->child->rightSibling);
     fprintf(F, "j       %s\n", whileLabel);
     fprintf(F, "%s_exit:\n", whileLabel);
     return;
@@ -427,7 +1132,7 @@ void emitForStmt (FILE *F, AST_NODE *forNode) {
 }
 
 
-char *genReturnJumpLabel (AST_NODE *retNode) {
+AST_NODE *getEnclosingFunc (AST_NODE *retNode) {
     AST_NODE *parent = retNode->parent;
 
     while (parent != NULL) {
@@ -436,27 +1141,50 @@ char *genReturnJumpLabel (AST_NODE *retNode) {
                 break;
         parent = parent->parent;
     }
-    return parent->child->rightSibling->semantic_value.identifierSemanticValue.identifierName;
+    return parent;
+}
+
+
+char *genReturnJumpLabel (AST_NODE *retNode) {
+    return getEnclosingFunc(retNode)->child->rightSibling->semantic_value.identifierSemanticValue.identifierName;
 }
 
 
-void emitRetStmt (FILE *F, AST_NODE *retNode) {
+// return values are passed in $v0, floats as raw bits
+void emitRetStmt (CompilerContext *ctx, FILE *F, AST_NODE *retNode) {
     _DBG(F, retNode, "return ... ;");
     if (retNode->child != NULL) {
-        if (retNode->child->nodeType == EXPR_NODE)
-            walkTree(F, retNode->child);
+        DATA_TYPE returnType = getEnclosingFunc(retNode)->child->dataType;
+
+        if (retNode->child->nodeType == EXPR_NODE || retNode->child->nodeType == STMT_NODE)
+            walkTree(ctx, F, retNode->child);
         else
-            emitArithmeticStmt(F, retNode->child);
+            emitArithmeticStmt(ctx, F, retNode->child);
 
-        fprintf(F, "lw      $v0, 4($sp)\n");
-        fprintf(F, "add     $sp, $sp, 4\n");
+        if (retNode->child->dataType == FLOAT_TYPE) {
+            const char *src = fregPop(ctx, F, "$f0");
+            if (returnType == INT_TYPE) {
+                fprintf(F, "trunc.w.s $f0, %s\n", src);
+                src = "$f0";
+            }
+            fprintf(F, "mfc1    $v0, %s\n", src);
+        }
+        else {
+            fprintf(F, "lw      $v0, 4($sp)\n");
+            fprintf(F, "add     $sp, $sp, 4\n");
+            if (returnType == FLOAT_TYPE) {
+                fprintf(F, "mtc1    $v0, $f0\n");
+                fprintf(F, "cvt.s.w $f0, $f0\n");
+                fprintf(F, "mfc1    $v0, $f0\n");
+            }
+        }
         fprintf(F, "j       _end_%s\n", genReturnJumpLabel(retNode));
     }
     return;
 }
 
 
-void emitVarDecl (FILE *F, AST_NODE *declarationNode) {
+void emitVarDecl (CompilerContext *ctx, FILE *F, AST_NODE *declarationNode) {
     _DBG(F, declarationNode, "declare Var ...");
     AST_NODE *id = declarationNode->child->rightSibling;
 
@@ -482,20 +1210,12 @@ void emitVarDecl (FILE *F, AST_NODE *declarationNode) {
                 break;
 
             case WITH_INIT_ID:
-                if (id->dataType == FLOAT_TYPE && id->child->nodeType == CONST_VALUE_NODE) {
-                    fprintf(F, "li.s    $f0, %f\n", id->child->semantic_value.const1->const_u.fval);
-                    fprintf(F, "s.s     $f0, ($sp)\n");
-                }
-                else if (id->dataType == FLOAT_TYPE && id->child->nodeType == EXPR_NODE) {
-                    fprintf(F, "li.s    $f0, %f\n", id->child->semantic_value.exprSemanticValue.constEvalValue.fValue);
+                if (declarationNode->child->dataType == FLOAT_TYPE) {
+                    fprintf(F, "l.s     $f0, fconst_%d\n", getFloatConst(ctx, getInitFloat(id->child)));
                     fprintf(F, "s.s     $f0, ($sp)\n");
                 }
-                else if (id->child->nodeType == CONST_VALUE_NODE) {
-                    fprintf(F, "li      $t0, %d\n", id->child->semantic_value.const1->const_u.intval);
-                    fprintf(F, "sw      $t0, ($sp)\n");
-                }
                 else {
-                    fprintf(F, "li      $t0, %d\n", id->child->semantic_value.exprSemanticValue.constEvalValue.iValue);
+                    fprintf(F, "li      $t0, %d\n", getInitInt(id->child));
                     fprintf(F, "sw      $t0, ($sp)\n");
                 }
                 fprintf(F, "sub     $sp, $sp, 4\n");
@@ -514,10 +1234,17 @@ void emitVarDecl (FILE *F, AST_NODE *declarationNode) {
 //
 // return value
 //     stored in $v0
-void emitRead (FILE *F, AST_NODE *functionCallNode) {
+void emitRead (CompilerContext *ctx, FILE *F, AST_NODE *functionCallNode) {
     _DBG(F, functionCallNode, "read( ... )");
-    fprintf(F, "li      $v0, 5\n");
-    fprintf(F, "syscall\n");
+    if (ctx->batchedInput) {
+        fprintf(F, "jal     __read_int\n");
+    }
+    else {
+        if (ctx->bufferedIO)
+            fprintf(F, "jal     __buf_flush\n");
+        fprintf(F, "li      $v0, 5\n");
+        fprintf(F, "syscall\n");
+    }
     fprintf(F, "sw      $v0, ($sp)\n");
     fprintf(F, "sub     $sp, $sp, 4\n");
     return;
@@ -529,12 +1256,22 @@ void emitRead (FILE *F, AST_NODE *functionCallNode) {
 //
 // return value
 //     stored in $f0
-void emitFread (FILE *F, AST_NODE *functionCallNode) {
+void emitFread (CompilerContext *ctx, FILE *F, AST_NODE *functionCallNode) {
     _DBG(F, functionCallNode, "fread( ... )");
-    fprintf(F, "li      $v0, 6\n");
-    fprintf(F, "syscall\n");
-    fprintf(F, "s.s     $f0, ($sp)\n");
-    fprintf(F, "sub     $sp, $sp, 4\n");
+    if (ctx->batchedInput) {
+        fprintf(F, "jal     __read_float\n");
+    }
+    else {
+        if (ctx->bufferedIO)
+            fprintf(F, "jal     __buf_flush\n");
+        fprintf(F, "li      $v0, 6\n");
+        fprintf(F, "syscall\n");
+    }
+
+    const char *dest = fregPush(ctx);
+    if (strcmp(dest, "$f0") != 0)
+        fprintf(F, "mov.s   %s, $f0\n", dest);
+    fregCommit(ctx, F);
     return;
 }
 
@@ -559,59 +1296,98 @@ void emitFread (FILE *F, AST_NODE *functionCallNode) {
 // syscall when
 //     $v0 == 4
 //     $a0 = address of null-terminated string to print
-void emitWrite (FILE *F, AST_NODE *functionCallNode) {
+// returns the last write() statement it has emitted, following ones may be
+// merged into this one
+AST_NODE *emitWrite (CompilerContext *ctx, FILE *F, AST_NODE *functionCallNode) {
     _DBG(F, functionCallNode, "write( ... )");
 
     AST_NODE *actualParameter = functionCallNode->child->rightSibling->child;
+    AST_NODE *last = functionCallNode;
 
     int paramtype = actualParameter->dataType;
-    char label[20];
-    sprintf(label, "l_%d", rand() % 10000);
 
     switch (paramtype) {
         case INT_TYPE:
-            emitArithmeticStmt(F, actualParameter);
+            if (actualParameter->nodeType == EXPR_NODE || actualParameter->nodeType == STMT_NODE)
+                walkTree(ctx, F, actualParameter);
+            else
+                emitArithmeticStmt(ctx, F, actualParameter);
+
+            if (ctx->bufferedIO) {
+                fprintf(F, "lw      $a0, 4($sp)\n");
+                fprintf(F, "add     $sp, $sp, 4\n");
+                fprintf(F, "jal     __buf_put_int\n");
+                break;
+            }
+
+            if (functionCallNode->parent && functionCallNode->parent->nodeType == STMT_LIST_NODE && getWriteString(ctx, functionCallNode->rightSibling)) {
+                int str = mergeWriteStrings(ctx, functionCallNode->rightSibling, &last);
+                // digits, sign, the string and its '\0'
+                int size = 11 + strlen(ctx->strconstPool[str]) - 2 + 1;
+
+                if (size > ctx->writeBufSize)
+                    ctx->writeBufSize = size;
+                ctx->useWriteIntStr = 1;
+
+                fprintf(F, "lw      $a0, 4($sp)\n");
+                fprintf(F, "add     $sp, $sp, 4\n");
+                fprintf(F, "la      $a1, str_%d\n", str);
+                fprintf(F, "jal     __write_int_str\n");
+                break;
+            }
+
             fprintf(F, "li      $v0, 1\n");
             fprintf(F, "lw      $a0, 4($sp)\n");
             fprintf(F, "add     $sp, $sp, 4\n");
             fprintf(F, "syscall\n");
             break;
 
-        case FLOAT_TYPE:
-            emitArithmeticStmt(F, actualParameter);
+        case FLOAT_TYPE: {
+            if (actualParameter->nodeType == EXPR_NODE || actualParameter->nodeType == STMT_NODE)
+                walkTree(ctx, F, actualParameter);
+            else
+                emitArithmeticStmt(ctx, F, actualParameter);
+
+            const char *arg = fregPop(ctx, F, "$f12");
+            if (ctx->bufferedIO)
+                fprintf(F, "jal     __buf_flush\n");
             fprintf(F, "li      $v0, 2\n");
-            fprintf(F, "l.s     $f12, 4($sp)\n");
-            fprintf(F, "add     $sp, $sp, 4\n");
+            if (strcmp(arg, "$f12") != 0)
+                fprintf(F, "mov.s   $f12, %s\n", arg);
             fprintf(F, "syscall\n");
             break;
+        }
 
         // Note xatier: there's no double in this homework
 
         case CONST_STRING_TYPE:
+            if (ctx->bufferedIO) {
+                fprintf(F, "la      $a1, str_%d\n", mergeWriteStrings(ctx, functionCallNode, &last));
+                fprintf(F, "jal     __buf_put_str\n");
+                break;
+            }
+
             fprintf(F, "li      $v0, 4\n");
-            fprintf(F, "la      $a0, %s\n", label);
+            fprintf(F, "la      $a0, str_%d\n", mergeWriteStrings(ctx, functionCallNode, &last));
             fprintf(F, "syscall\n");
-            fprintf(F, ".data\n");
-            fprintf(F, "%s: .asciiz %s\n", label, actualParameter->semantic_value.const1->const_u.sc);
-            fprintf(F, ".text\n");
             break;
 
         default:
             // xatier: I hope this won't happen
             _DBG(F, functionCallNode, "wrong type for write()");
-            exit(1);
+            compileFailed(ctx, "wrong type for write()");
     }
-    return;
+    return last;
 }
 
 
-void emitBeforeFunc (FILE *F, AST_NODE *funcDeclNode) {
+void emitBeforeFunc (CompilerContext *ctx, FILE *F, AST_NODE *funcDeclNode) {
     _DBG(F, funcDeclNode, "before f( ... )");
     // xatier: .text, function name, prologue sequence here
     char *functionName = funcDeclNode->child->rightSibling->semantic_value.identifierSemanticValue.identifierName;
     fprintf(F, ".text\n");
 
-    if (strcmp(functionName, "main") == 0)
+    if (functionName == ctx->internedMain)
         fprintf(F, ".globl main\n");
 
     fprintf(F, "%s:\n", functionName);
@@ -628,7 +1404,7 @@ void emitBeforeFunc (FILE *F, AST_NODE *funcDeclNode) {
 }
 
 
-void emitAfterFunc(FILE *F, AST_NODE *funcDeclNode) {
+void emitAfterFunc(CompilerContext *ctx, FILE *F, AST_NODE *funcDeclNode) {
     _DBG(F, funcDeclNode, "after f( ... )");
     char *functionName = funcDeclNode->child->rightSibling->semantic_value.identifierSemanticValue.identifierName;
     fprintf(F, "# epilogue sequence\n");
@@ -636,7 +1412,9 @@ void emitAfterFunc(FILE *F, AST_NODE *funcDeclNode) {
     fprintf(F, "lw      $ra, 4($fp)\n");
     fprintf(F, "add     $sp, $fp, 4\n");
     fprintf(F, "lw      $fp, 0($fp)\n");
-    if (strcmp(functionName, "main") == 0) {
+    if (functionName == ctx->internedMain) {
+        if (ctx->bufferedIO)
+            fprintf(F, "jal     __buf_flush\n");
         fprintf(F, "li      $v0, 10\n");
         fprintf(F, "syscall\n");
     }
@@ -647,13 +1425,20 @@ void emitAfterFunc(FILE *F, AST_NODE *funcDeclNode) {
 }
 
 
-void emitFunc (FILE *F, AST_NODE *functionCallNode) {
+void emitFunc (CompilerContext *ctx, FILE *F, AST_NODE *functionCallNode) {
     _DBG(F, functionCallNode, "in f( ... )");
     char *functionName = functionCallNode->child->semantic_value.identifierSemanticValue.identifierName;
     SymbolTableEntry *entry = functionCallNode->child->semantic_value.identifierSemanticValue.symbolTableEntry;
 
+    int live = fregSave(ctx, F);
     fprintf(F, "jal     %s\n", functionName);
-    if (entry->attribute->attr.functionSignature->returnType != VOID_TYPE) {
+    fregRestore(F, live);
+
+    if (entry->attribute->attr.functionSignature->returnType == FLOAT_TYPE) {
+        fprintf(F, "mtc1    $v0, %s\n", fregPush(ctx));
+        fregCommit(ctx, F);
+    }
+    else if (entry->attribute->attr.functionSignature->returnType != VOID_TYPE) {
         fprintf(F, "sw      $v0, ($sp)\n");
         fprintf(F, "sub     $sp, $sp, 4\n");
     }
@@ -661,31 +1446,27 @@ void emitFunc (FILE *F, AST_NODE *functionCallNode) {
 }
 
 
-void emitArithmeticStmt (FILE *F, AST_NODE *exprNode) {
+void emitArithmeticStmt (CompilerContext *ctx, FILE *F, AST_NODE *exprNode) {
     _DBG(F, exprNode, "expr");
 
 
     // jyhsu: make sure it is a expr node
     if (exprNode->nodeType == CONST_VALUE_NODE) {
         if (exprNode->dataType == FLOAT_TYPE) {
-            fprintf(F, "li.s    $f0, %f\n", exprNode->semantic_value.const1->const_u.fval);
-            fprintf(F, "s.s     $f0, ($sp)\n");
-        }
-        else {
-            fprintf(F, "li      $t0, %d\n", exprNode->semantic_value.const1->const_u.intval);
-            fprintf(F, "sw      $t0, ($sp)\n");
+            emitLoadFloat(ctx, F, exprNode, fregPush(ctx));
+            fregCommit(ctx, F);
+            return;
         }
+        fprintf(F, "li      $t0, %d\n", exprNode->semantic_value.const1->const_u.intval);
+        fprintf(F, "sw      $t0, ($sp)\n");
         fprintf(F, "sub     $sp, $sp, 4\n");
         return;
     }
     else if (exprNode->nodeType == IDENTIFIER_NODE) {
         if (exprNode->dataType == FLOAT_TYPE) {
-            if (exprNode->semantic_value.identifierSemanticValue.symbolTableEntry->nestingLevel == 0)
-                fprintf(F, "l.s     $f0, _%s\n", exprNode->semantic_value.identifierSemanticValue.identifierName);
-            else
-                fprintf(F, "l.s     $f0, %d($fp)\n", exprNode->semantic_value.identifierSemanticValue.symbolTableEntry->offset);
-
-            fprintf(F, "s.s     $f0, ($sp)\n");
+            emitLoadFloat(ctx, F, exprNode, fregPush(ctx));
+            fregCommit(ctx, F);
+            return;
         }
         else {
             if(exprNode->semantic_value.identifierSemanticValue.symbolTableEntry->nestingLevel == 0)
@@ -762,7 +1543,7 @@ void emitArithmeticStmt (FILE *F, AST_NODE *exprNode) {
                     break;
 
                 case BINARY_OP_EQ:
-                    sprintf(eqLabel, "eql_%d", rand() % 10000);
+                    sprintf(eqLabel, "eql_%d", ctx->labelCount++);
                     fprintf(F, "bne     $t0, $t1, %s\n", eqLabel);
                     fprintf(F, "addi    $t0, $zero, 1\n");
                     fprintf(F, "j       %sxx\n", eqLabel);
@@ -784,7 +1565,7 @@ void emitArithmeticStmt (FILE *F, AST_NODE *exprNode) {
                     break;
 
                 case BINARY_OP_NE:
-                    sprintf(neLabel, "nel_%d", rand() % 10000);
+                    sprintf(neLabel, "nel_%d", ctx->labelCount++);
                     fprintf(F, "beq     $t0, $t1, %s\n", neLabel);
                     fprintf(F, "addi    $t0, $zero, 1\n");
                     fprintf(F, "j       %sxx\n", neLabel);
@@ -810,8 +1591,7 @@ void emitArithmeticStmt (FILE *F, AST_NODE *exprNode) {
                     break;
 
                 default:
-                    printf("Undefined operation occurred\n");
-                    exit(1);
+                    compileFailed(ctx, "Undefined operation occurred");
                     break;
             }
 
@@ -821,86 +1601,40 @@ void emitArithmeticStmt (FILE *F, AST_NODE *exprNode) {
         }
         // instruction operands are float
         else if (leftOp->dataType == FLOAT_TYPE || rightOp->dataType == FLOAT_TYPE) {
-            // xatier: handle int -> float conversion
-            // some says that we need a nop stall here to avoid hazard
-            if (leftOp->dataType == INT_TYPE) {
-                if (leftOp->nodeType == IDENTIFIER_NODE)
-                    fprintf(F, "lw      $t0, %d($sp)\n", leftOp->semantic_value.identifierSemanticValue.symbolTableEntry->offset);
-                else if (leftOp->nodeType == CONST_VALUE_NODE)
-                    fprintf(F, "li      $t0, %d\n", leftOp->semantic_value.const1->const_u.intval);
-                else
-                    fprintf(F, "lw      $t0, 8($sp)\n");
-
-                fprintf(F, "mtc1    $t0, $f0\n");
-                fprintf(F, "nop");
-                fprintf(F, "swc1    $f0, 8($sp)\n");
-            }
-            if (rightOp->dataType == INT_TYPE) {
-                if (rightOp->nodeType == IDENTIFIER_NODE)
-                    fprintf(F, "lw      $t1, %d($sp)\n", rightOp->semantic_value.identifierSemanticValue.symbolTableEntry->offset);
-                else if (rightOp->nodeType == CONST_VALUE_NODE)
-                    fprintf(F, "li      $t1, %d\n", rightOp->semantic_value.const1->const_u.intval);
-                else
-                    fprintf(F, "lw      $t1, 4($sp)\n");
-
-                fprintf(F, "mtc1    $t1, $f1\n");
-                fprintf(F, "nop");
-                fprintf(F, "swc1    $f1, 4($sp)\n");
-            }
-
-            // load leftOp and rightOp to $f0 and $f1
-            if (rightOp->nodeType == IDENTIFIER_NODE) {
-                if (rightOp->semantic_value.identifierSemanticValue.symbolTableEntry->nestingLevel == 0)
-                    fprintf(F, "lwc1    $f1, _%s\n", rightOp->semantic_value.identifierSemanticValue.identifierName);
-                else
-                    fprintf(F, "lwc1    $f1, %d($fp)\n", rightOp->semantic_value.identifierSemanticValue.symbolTableEntry->offset);
-            }
-            else if (rightOp->nodeType == CONST_VALUE_NODE) {
-                fprintf(F, "li.s    $f1, %f\n", rightOp->semantic_value.const1->const_u.fval);
-            }
-            else {
-                fprintf(F, "lwc1    $f1, 4($sp)\n");
-                fprintf(F, "add     $sp, $sp, 4\n");
-            }
-
-            if (leftOp->nodeType == IDENTIFIER_NODE) {
-                if (leftOp->semantic_value.identifierSemanticValue.symbolTableEntry->nestingLevel == 0)
-                    fprintf(F, "lwc1    $f0, _%s\n", leftOp->semantic_value.identifierSemanticValue.identifierName);
-                else
-                    fprintf(F, "lwc1    $f0, %d($fp)\n", leftOp->semantic_value.identifierSemanticValue.symbolTableEntry->offset);
-            }
-            else if (leftOp->nodeType == CONST_VALUE_NODE) {
-                fprintf(F, "li.s    $f0, %f\n", leftOp->semantic_value.const1->const_u.fval);
-            }
-            else {
-                fprintf(F, "lwc1    $f0, 4($sp)\n");
-                fprintf(F, "add     $sp, $sp, 4\n");
-            }
+            // load leftOp and rightOp into registers, int operands are
+            // converted with cvt.s.w on the way
+            const char *right = emitFloatOperand(ctx, F, rightOp, "$f1");
+            const char *left = emitFloatOperand(ctx, F, leftOp, "$f0");
+            const char *dest = NULL;
 
             // for floating point comparision
             char fcmpl[20];
-            sprintf(fcmpl, "fcmpl%d", rand() % 10000);
+            sprintf(fcmpl, "fcmpl%d", ctx->labelCount++);
 
             switch (exprNode->semantic_value.exprSemanticValue.op.binaryOp) {
                 case BINARY_OP_ADD:
-                    fprintf(F, "add.s   $f0, $f0, $f1\n");
+                    dest = fregPush(ctx);
+                    fprintf(F, "add.s   %s, %s, %s\n", dest, left, right);
                     break;
 
                 case BINARY_OP_SUB:
-                    fprintf(F, "sub.s   $f0, $f0, $f1\n");
+                    dest = fregPush(ctx);
+                    fprintf(F, "sub.s   %s, %s, %s\n", dest, left, right);
                     break;
 
                 case BINARY_OP_MUL:
-                    fprintf(F, "mul.s   $f0, $f0, $f1\n");
+                    dest = fregPush(ctx);
+                    fprintf(F, "mul.s   %s, %s, %s\n", dest, left, right);
                     break;
 
                 case BINARY_OP_DIV:
-                    fprintf(F, "div.s   $f0, $f0, $f1\n");
+                    dest = fregPush(ctx);
+                    fprintf(F, "div.s   %s, %s, %s\n", dest, left, right);
                     break;
 
                 // xatier: for floating point comparison, set $t0 = true ? 1 : 0
                 case BINARY_OP_EQ:
-                    fprintf(F, "c.eq.s   $f0, $f1\n");
+                    fprintf(F, "c.eq.s   %s, %s\n", left, right);
                     fprintf(F, "bc1t     %s_t\n", fcmpl);
                     fprintf(F, "addi    $t0, $zero, 0\n");
                     fprintf(F, "j       %s_exit\n", fcmpl);
@@ -911,7 +1645,7 @@ void emitArithmeticStmt (FILE *F, AST_NODE *exprNode) {
 
                 case BINARY_OP_GE:
                     // xatier: ge = not lt
-                    fprintf(F, "c.lt.s   $f1, $f0\n");
+                    fprintf(F, "c.lt.s   %s, %s\n", right, left);
                     fprintf(F, "bc1t     %s_t\n", fcmpl);
                     fprintf(F, "addi    $t0, $zero, 0\n");
                     fprintf(F, "j       %s_exit\n", fcmpl);
@@ -921,7 +1655,7 @@ void emitArithmeticStmt (FILE *F, AST_NODE *exprNode) {
                     break;
 
                 case BINARY_OP_LE:
-                    fprintf(F, "c.le.s   $f0, $f1\n");
+                    fprintf(F, "c.le.s   %s, %s\n", left, right);
                     fprintf(F, "bc1t     %s_t\n", fcmpl);
                     fprintf(F, "addi    $t0, $zero, 0\n");
                     fprintf(F, "j       %s_exit\n", fcmpl);
@@ -932,7 +1666,7 @@ void emitArithmeticStmt (FILE *F, AST_NODE *exprNode) {
 
                 case BINARY_OP_NE:
                     // xatier: note, bd1f
-                    fprintf(F, "c.eq.s   $f0, $f1\n");
+                    fprintf(F, "c.eq.s   %s, %s\n", left, right);
                     fprintf(F, "bc1f     %s_f\n", fcmpl);
                     fprintf(F, "addi    $t0, $zero, 0\n");
                     fprintf(F, "j       %s_exit\n", fcmpl);
@@ -943,7 +1677,7 @@ void emitArithmeticStmt (FILE *F, AST_NODE *exprNode) {
 
                 case BINARY_OP_GT:
                     // xatier: gt = not le
-                    fprintf(F, "c.le.s   $f1, $f0\n");
+                    fprintf(F, "c.le.s   %s, %s\n", right, left);
                     fprintf(F, "bc1t     %s_t\n", fcmpl);
                     fprintf(F, "addi    $t0, $zero, 0\n");
                     fprintf(F, "j       %s_exit\n", fcmpl);
@@ -953,7 +1687,7 @@ void emitArithmeticStmt (FILE *F, AST_NODE *exprNode) {
                     break;
 
                 case BINARY_OP_LT:
-                    fprintf(F, "c.lt.s   $f0, $f1\n");
+                    fprintf(F, "c.lt.s   %s, %s\n", left, right);
                     fprintf(F, "bc1t     %s_t\n", fcmpl);
                     fprintf(F, "addi    $t0, $zero, 0\n");
                     fprintf(F, "j       %s_exit\n", fcmpl);
@@ -963,31 +1697,28 @@ void emitArithmeticStmt (FILE *F, AST_NODE *exprNode) {
                     break;
 
                 default:
-                    printf("Undefined operation occurred\n");
-                    exit(1);
+                    compileFailed(ctx, "Undefined operation occurred");
             }
             //push stack frame
             switch (exprNode->semantic_value.exprSemanticValue.op.binaryOp) {
                 case BINARY_OP_ADD: case BINARY_OP_SUB:
                 case BINARY_OP_MUL: case BINARY_OP_DIV:
-                    fprintf(F, "s.s     $f0, ($sp)\n");
+                    fregCommit(ctx, F);
                     break;
 
                 case BINARY_OP_EQ: case BINARY_OP_GE:
                 case BINARY_OP_LE: case BINARY_OP_NE:
                 case BINARY_OP_GT: case BINARY_OP_LT:
                     fprintf(F, "sw      $t0, ($sp)\n");
+                    fprintf(F, "sub     $sp, $sp, 4\n");
                     break;
 
                 default:
-                    printf("Undefined operation occurred\n");
-                    exit(1);
+                    compileFailed(ctx, "Undefined operation occurred");
             }
-            fprintf(F, "sub     $sp, $sp, 4\n");
         }
         else {
-            printf("Undefined operation occurred\n");
-            exit(1);
+            compileFailed(ctx, "Undefined operation occurred");
         }
     }
     else if (exprNode->semantic_value.exprSemanticValue.kind == UNARY_OPERATION) {
@@ -1022,7 +1753,7 @@ void emitArithmeticStmt (FILE *F, AST_NODE *exprNode) {
                     break;
 
                 default:
-                    printf("Unhandled case in void evaluateExprValue(AST_NODE* exprNode)\n");
+                    fprintf(ctx->diagnostics, "Unhandled case in void evaluateExprValue(AST_NODE* exprNode)\n");
                     break;
             }
             //push
@@ -1030,49 +1761,39 @@ void emitArithmeticStmt (FILE *F, AST_NODE *exprNode) {
             fprintf(F, "sub     $sp, $sp, 4\n");
         }
         else if (operand->dataType == FLOAT_TYPE) {
-            if (operand->nodeType == IDENTIFIER_NODE) {
-                if (operand->semantic_value.identifierSemanticValue.symbolTableEntry->nestingLevel == 0)
-                    fprintf(F, "lwc1    $f0, _%s\n", operand->semantic_value.identifierSemanticValue.identifierName);
-                else
-                    fprintf(F, "lwc1    $f0, %d($fp)\n", operand->semantic_value.identifierSemanticValue.symbolTableEntry->offset);
-            }
-            else if (operand->nodeType == CONST_VALUE_NODE) {
-                fprintf(F, "li.s    $f0, %f\n", operand->semantic_value.const1->const_u.fval);
-            }
-            else {
-                fprintf(F, "lwc1    $f0, 4($sp)\n");
-                fprintf(F, "add     $sp, $sp, 4\n");
-            }
+            const char *src = emitFloatOperand(ctx, F, operand, "$f0");
+            const char *dest = fregPush(ctx);
 
             switch (exprNode->semantic_value.exprSemanticValue.op.unaryOp) {
                 case UNARY_OP_POSITIVE:
                     // skip
+                    if (strcmp(dest, src) != 0)
+                        fprintf(F, "mov.s   %s, %s\n", dest, src);
                     break;
 
                 case UNARY_OP_NEGATIVE:
-                    fprintf(F, "neg.s   $f0, $f0\n");
+                    fprintf(F, "neg.s   %s, %s\n", dest, src);
                     break;
 
                 case UNARY_OP_LOGICAL_NEGATION:
                     // skip
+                    if (strcmp(dest, src) != 0)
+                        fprintf(F, "mov.s   %s, %s\n", dest, src);
                     break;
 
                 default:
-                    printf("Unhandled case in void evaluateExprValue(AST_NODE* exprNode)\n");
+                    fprintf(ctx->diagnostics, "Unhandled case in void evaluateExprValue(AST_NODE* exprNode)\n");
                     break;
             }
             //push
-            fprintf(F, "s.s     $f0, ($sp)\n");
-            fprintf(F, "sub     $sp, $sp, 4\n");
+            fregCommit(ctx, F);
         }
         else {
-            printf("Undefined operation occurred\n");
-            exit(1);
+            compileFailed(ctx, "Undefined operation occurred");
         }
     }
     else {
-        printf("Undefined operation occurred\n");
-        exit(1);
+        compileFailed(ctx, "Undefined operation occurred");
 
     }
 
@@ -1080,7 +1801,22 @@ void emitArithmeticStmt (FILE *F, AST_NODE *exprNode) {
 }
 
 
-void walkTree (FILE *F, AST_NODE *node) {
+// is this function call a statement of its own rather than part of an expression
+int isCallStatement (AST_NODE *callNode) {
+    AST_NODE *parent = callNode->parent;
+
+    if (parent == NULL)
+        return 0;
+    if (parent->nodeType == STMT_LIST_NODE)
+        return 1;
+    // the body of an if/while without braces
+    if (parent->nodeType == STMT_NODE && parent->child != callNode)
+        return parent->semantic_value.stmtSemanticValue.kind == IF_STMT || parent->semantic_value.stmtSemanticValue.kind == WHILE_STMT;
+    return 0;
+}
+
+
+void walkTree (CompilerContext *ctx, FILE *F, AST_NODE *node) {
     // xaiter: what does left mean?
     // jyhsu : leftmost sibling
     AST_NODE *left = node;
@@ -1090,10 +1826,10 @@ void walkTree (FILE *F, AST_NODE *node) {
     while (left != NULL) {
         switch (left->nodeType) {
             case VARIABLE_DECL_LIST_NODE:
-                if (symbolTable.currentLevel == 0)
+                if (ctx->symbolTable.currentLevel == 0)
                     emitPreface(F, left);
                 else
-                    walkTree(F, left->child);
+                    walkTree(ctx, F, left->child);
                 break;
 
             case DECLARATION_NODE:
@@ -1101,10 +1837,10 @@ void walkTree (FILE *F, AST_NODE *node) {
                     AST_NODE *id = left->child->rightSibling;
 
                     while (id != NULL) {
-                        enterSymbol(id->semantic_value.identifierSemanticValue.identifierName, id->semantic_value.identifierSemanticValue.symbolTableEntry->attribute);
-                        id->semantic_value.identifierSemanticValue.symbolTableEntry->offset = ARoffset;
-                        if (id->semantic_value.identifierSemanticValue.kind == NORMAL_ID) {
-                            ARoffset -= 4;
+                        enterSymbol(ctx, id->semantic_value.identifierSemanticValue.identifierName, id->semantic_value.identifierSemanticValue.symbolTableEntry->attribute);
+                        id->semantic_value.identifierSemanticValue.symbolTableEntry->offset = ctx->ARoffset;
+                        if (id->semantic_value.identifierSemanticValue.kind == NORMAL_ID || id->semantic_value.identifierSemanticValue.kind == WITH_INIT_ID) {
+                            ctx->ARoffset -= 4;
                         }
                         else if (id->semantic_value.identifierSemanticValue.kind == ARRAY_ID) {
                             AST_NODE *dim = id->child;
@@ -1118,59 +1854,63 @@ void walkTree (FILE *F, AST_NODE *node) {
 
                                 dim = dim->rightSibling;
                             }
-                            ARoffset -= size*4;
+                            ctx->ARoffset -= size*4;
                         }
 
                         id = id->rightSibling;
                     }
-                    emitVarDecl(F, left);
+                    emitVarDecl(ctx, F, left);
                 }
                 else if (left->semantic_value.declSemanticValue.kind == FUNCTION_DECL) {
-                    ARoffset = -4;
-                    emitBeforeFunc(F, left);
-                    walkTree(F, left->child);
-                    emitAfterFunc(F, left);
+                    ctx->ARoffset = -4;
+                    emitBeforeFunc(ctx, F, left);
+                    walkTree(ctx, F, left->child);
+                    emitAfterFunc(ctx, F, left);
                 }
                 break;
 
             case BLOCK_NODE:
                 emitBeforeBlock(F, left);
-                openScope();
-                walkTree(F, left->child);
-                closeScope();
-                emitAfterBlock(F, left);
+                openScope(ctx);
+                walkTree(ctx, F, left->child);
+                closeScope(ctx);
+                emitAfterBlock(ctx, F, left);
                 break;
 
             case STMT_LIST_NODE:
-                walkTree(F, left->child);
+                walkTree(ctx, F, left->child);
                 break;
 
             case STMT_NODE:
                 switch (left->semantic_value.stmtSemanticValue.kind) {
                     case ASSIGN_STMT:
-                        emitAssignStmt(F, left);
+                        emitAssignStmt(ctx, F, left);
                         break;
                     case IF_STMT:
-                        emitIfStmt(F, left);
+                        emitIfStmt(ctx, F, left);
                         break;
                     case WHILE_STMT:
-                        emitWhileStmt(F, left);
+                        emitWhileStmt(ctx, F, left);
                         break;
                     case FOR_STMT:
                         emitForStmt(F, left);
                         break;
                     case RETURN_STMT:
-                        emitRetStmt(F, left);
+                        emitRetStmt(ctx, F, left);
                         break;
                     case FUNCTION_CALL_STMT:
-                        if (strcmp(left->child->semantic_value.identifierSemanticValue.identifierName, "read") == 0)
-                            emitRead(F, left);
-                        else if (strcmp(left->child->semantic_value.identifierSemanticValue.identifierName, "fread") == 0)
-                            emitFread(F, left);
-                        else if (strcmp(left->child->semantic_value.identifierSemanticValue.identifierName, "write") == 0)
-                            emitWrite(F, left);
+                        if (left->child->semantic_value.identifierSemanticValue.identifierName == ctx->internedRead)
+                            emitRead(ctx, F, left);
+                        else if (left->child->semantic_value.identifierSemanticValue.identifierName == ctx->internedFread)
+                            emitFread(ctx, F, left);
+                        else if (left->child->semantic_value.identifierSemanticValue.identifierName == ctx->internedWrite)
+                            left = emitWrite(ctx, F, left);
                         else
-                            emitFunc(F, left);
+                            emitFunc(ctx, F, left);
+
+                        // nobody uses the result of a call statement, drop it from the RA pool
+                        if (left->dataType == FLOAT_TYPE && isCallStatement(left))
+                            fregPop(ctx, F, "$f0");
                         break;
                     default:
                         break;
@@ -1178,13 +1918,13 @@ void walkTree (FILE *F, AST_NODE *node) {
                 break;
 
             case EXPR_NODE:
-                walkTree(F, left->child);
-                emitArithmeticStmt(F, left);
+                walkTree(ctx, F, left->child);
+                emitArithmeticStmt(ctx, F, left);
                 break;
 
             default:
 
-                walkTree(F, left->child);
+                walkTree(ctx, F, left->child);
                 break;
         }
         left = left->rightSibling;
@@ -1194,21 +1934,47 @@ void walkTree (FILE *F, AST_NODE *node) {
 }
 
 
-void codeGen(AST_NODE *prog) {
+// the constant pools belong to one compilation
+static void codeGenEnd (CompilerContext *ctx) {
+    free(ctx->strconstPool);
+    free(ctx->strconstIndex);
+    ctx->strconstPool = NULL;
+    ctx->strconstIndex = NULL;
+    ctx->strconstCount = ctx->strconstCapacity = 0;
+    free(ctx->fconstPool);
+    free(ctx->fconstIndex);
+    ctx->fconstPool = NULL;
+    ctx->fconstIndex = NULL;
+    ctx->fconstCount = ctx->fconstCapacity = 0;
+}
+
+
+int codeGen(CompilerContext *ctx, AST_NODE *prog) {
 
-    FILE *output = fopen("output.s", "w");
-    srand(time(NULL));
+    FILE *output = ctx->output ? ctx->output : fopen(ctx->outputPath, "w");
+    jmp_buf failed;
+    int status = 0;
 
     if (!output) {
-        puts("[-] file open error");
-        exit(1);
+        fputs("[-] file open error\n", ctx->diagnostics);
+        return -1;
     }
 
-    // xaiter: walk the AST
-    walkTree(output, prog);
-    // end of walk the AST
-    emitAppendix(output, prog);
+    // compileFailed() comes back here, with what was written so far left
+    // in the output
+    ctx->failed = &failed;
+    if (setjmp(failed) == 0) {
+        // xaiter: walk the AST
+        walkTree(ctx, output, prog);
+        // end of walk the AST
+        emitAppendix(ctx, output, prog);
+    }
+    else
+        status = -1;
+    ctx->failed = NULL;
 
-    fclose(output);
-    return;
+    if (output != ctx->output)
+        fclose(output);
+    codeGenEnd(ctx);
+    return status;
 }
@@ -3,7 +3,12 @@
 #include "header.h"
 
 
-void codeGen (AST_NODE *prog);
+// writes to ctx->output, or else ctx->outputPath, -1 if that can't be
+// opened or the tree has something code can't be generated for (the message
+// is in ctx->diagnostics). with ctx->bufferedIO (--buffered-io) write() output is
+// collected in a buffer and printed in chunks, with ctx->batchedInput
+// (--batched-input) read() and fread() parse numbers from chunks of stdin
+int codeGen (CompilerContext *ctx, AST_NODE *prog);
 
 
 
@@ -0,0 +1,113 @@
+#ifndef __COMPILER_CONTEXT_H__
+#define __COMPILER_CONTEXT_H__
+
+#include <stdio.h>
+#include <string.h>
+#include <setjmp.h>
+
+#include "header.h"
+#include "symbolTable.h"
+
+
+// everything one compilation reads and writes, from the scanner to the code
+// generator, so that compilations in different threads don't share state.
+// every phase takes the context it works on
+//
+// the arena (alloc.c) is not in here, it belongs to the thread: a thread
+// runs one compilation at a time and releases the arena after it
+
+struct InternedName;
+struct TokenPipe;
+struct DescentParser;
+
+struct CompilerContext {
+    // options
+    int bufferedIO;          // --buffered-io
+    int batchedInput;        // --batched-input
+    int threadedLexer;       // --threaded-lexer
+    int descentParser;       // --descent-parser
+    int tokensOnly;          // --dump-tokens, to stdout instead of compiling
+    int astOnly;             // --dump-ast, to stdout instead of compiling
+    int skipCodeOnError;     // no output file for a program with errors
+    int reuseArena;          // arenaReset() instead of arenaRelease() at the end
+    const char *cacheDirectory;  // --cache, see cache.h
+    long long cacheLimit;        // --cache-size, in bytes
+
+    // where the error messages go and the assembly is written: to output if
+    // it is set, or else into the file outputPath
+    FILE *diagnostics;
+    FILE *output;
+    const char *outputPath;
+    // where compileFailed() leaves the pass that is running, NULL to exit()
+    jmp_buf *failed;
+
+    // scanning and parsing
+    void *scanner;           // the yyscan_t of lexer3.l or scanner.c
+    int tokenLine;           // the line the scanner is at
+    int linenumber;          // the line of the token the parser read last
+    struct TokenPipe *tokenPipe;   // tokenPipe.c, --threaded-lexer
+    struct DescentParser *parser;  // descentParser.c, --descent-parser
+    AST_NODE *prog;
+
+    // the identifiers, see internName()
+    struct InternedName **internTable;
+    int internTableSize;
+    int internedCount;
+    char *internedInt;
+    char *internedFloat;
+    char *internedVoid;
+    char *internedRead;
+    char *internedFread;
+    char *internedWrite;
+    char *internedMain;
+
+    // semantic analysis
+    SymbolTable symbolTable;
+    int anyErrorOccur;
+    int errorCount;
+
+    // code generation, see codegen.c
+    int ARoffset;
+    int labelCount;          // numbers the labels of ifs, whiles and compares
+    int fregTop;
+    unsigned int *fconstPool;
+    int *fconstIndex;
+    int fconstCount;
+    int fconstCapacity;
+    const char **strconstPool;   // interned, not owned
+    int *strconstIndex;
+    int strconstCount;
+    int strconstCapacity;
+    int useWriteIntStr;
+    int writeBufSize;
+};
+
+
+// no options set and nothing compiled yet
+static inline void initializeContext (CompilerContext *ctx) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->tokenLine = 1;
+    ctx->linenumber = 1;
+    ctx->ARoffset = -4;
+    ctx->diagnostics = stdout;
+    ctx->outputPath = "output.s";
+}
+
+
+// alloc.c: give up on the compilation, for a tree code generation can't
+// handle or memory that runs out. `message` goes to ctx->diagnostics and the
+// pass returns through ctx->failed
+void compileFailed (CompilerContext *ctx, const char *message);
+
+// parser.y: scan and parse `text` (see loadSource()) into ctx->prog, or
+// dump its tokens with ctx->tokensOnly. -1 after a syntax error
+int parseSource (CompilerContext *ctx, char *text, size_t size);
+
+// libcmm.c: compile `source` into ctx->output or ctx->outputPath. returns -1
+// when it stopped before code generation (the file can't be read, a syntax
+// error, the output can't be written), 0 otherwise; ctx->anyErrorOccur tells
+// whether semantic analysis found errors
+int compileFile (CompilerContext *ctx, const char *source);
+
+
+#endif // __COMPILER_CONTEXT_H__
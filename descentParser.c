@@ -0,0 +1,802 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <setjmp.h>
+
+#include "header.h"
+#include "symbolTable.h"
+#include "astBuilder.h"
+#include "descentParser.h"
+#include "compilerContext.h"
+#include "parser.tab.h"
+
+
+// recursive descent version of the grammar in parser.y. statements and
+// declarations get a function per rule, with the rules that start with ID
+// factored so one token of lookahead is enough. expressions (relop_expr down
+// to factor) are parsed by precedence climbing, one call per operand instead
+// of one per grammar level.
+//
+// the tree has to be the one bison builds, down to the line numbers
+// Allocate() stamps on the nodes, so
+//  - a token is only read when a decision needs it, like bison reads its
+//    lookahead only in states that need one,
+//  - every node is made when bison would reduce the rule that makes it:
+//    `+ - * /` and the relational operators as soon as the operator is read
+//    (add_op, mul_op, rel_op), `&&`, `||` and the rest once their last
+//    operand is complete.
+
+
+int yylex(YYSTYPE *value, CompilerContext *ctx);
+int yyerror(CompilerContext *ctx, const char *mesg);
+
+
+// binding power of the binary operators, 0 for any other token. the
+// relational operators don't associate: a < b < c is a syntax error
+#define PRECEDENCE_OR         1
+#define PRECEDENCE_AND        2
+#define PRECEDENCE_RELATIONAL 3
+#define PRECEDENCE_ADDITIVE   4
+#define PRECEDENCE_MULTIPLY   5
+
+
+// ctx->parser, for one parseProgram()
+struct DescentParser {
+    // -1 while the next token hasn't been read
+    int lookahead;
+    YYSTYPE lookaheadValue;
+    // where a syntax error leaves the parse
+    jmp_buf failed;
+};
+
+
+static int peekToken (CompilerContext *ctx) {
+    if (ctx->parser->lookahead < 0) {
+        ctx->parser->lookahead = yylex(&ctx->parser->lookaheadValue, ctx);
+    }
+    return ctx->parser->lookahead;
+}
+
+
+static void nextToken (CompilerContext *ctx) {
+    ctx->parser->lookahead = -1;
+}
+
+
+static void syntaxError (CompilerContext *ctx) {
+    yyerror(ctx, "syntax error");
+    longjmp(ctx->parser->failed, 1);
+}
+
+
+static void expect (CompilerContext *ctx, int token) {
+    if (peekToken(ctx) != token) {
+        syntaxError(ctx);
+    }
+    nextToken(ctx);
+}
+
+
+static char *expectId (CompilerContext *ctx) {
+    char *lexeme;
+    if (peekToken(ctx) != ID) {
+        syntaxError(ctx);
+    }
+    lexeme = ctx->parser->lookaheadValue.lexeme;
+    nextToken(ctx);
+    return lexeme;
+}
+
+
+static int startsExpression (int token) {
+    return token == ID || token == CONST || token == MK_LPAREN || token == OP_MINUS || token == OP_NOT;
+}
+
+
+static int binaryPrecedence (int token) {
+    switch (token) {
+        case OP_OR:
+            return PRECEDENCE_OR;
+        case OP_AND:
+            return PRECEDENCE_AND;
+        case OP_EQ:
+        case OP_NE:
+        case OP_LT:
+        case OP_GT:
+        case OP_LE:
+        case OP_GE:
+            return PRECEDENCE_RELATIONAL;
+        case OP_PLUS:
+        case OP_MINUS:
+            return PRECEDENCE_ADDITIVE;
+        case OP_TIMES:
+        case OP_DIVIDE:
+            return PRECEDENCE_MULTIPLY;
+    }
+    return 0;
+}
+
+
+static BINARY_OPERATOR binaryOperator (int token) {
+    switch (token) {
+        case OP_OR:     return BINARY_OP_OR;
+        case OP_AND:    return BINARY_OP_AND;
+        case OP_EQ:     return BINARY_OP_EQ;
+        case OP_NE:     return BINARY_OP_NE;
+        case OP_LT:     return BINARY_OP_LT;
+        case OP_GT:     return BINARY_OP_GT;
+        case OP_LE:     return BINARY_OP_LE;
+        case OP_GE:     return BINARY_OP_GE;
+        case OP_PLUS:   return BINARY_OP_ADD;
+        case OP_MINUS:  return BINARY_OP_SUB;
+        case OP_TIMES:  return BINARY_OP_MUL;
+        default:        return BINARY_OP_DIV;
+    }
+}
+
+
+static AST_NODE *makeConstNode (CompilerContext *ctx, CON_Type *constant) {
+    AST_NODE *node = Allocate(ctx, CONST_VALUE_NODE);
+    node->semantic_value.const1 = constant;
+    return node;
+}
+
+
+static AST_NODE *parseExpression(CompilerContext *ctx, int minPrecedence, char *leadingId);
+
+
+// relop_expr_list: empty, or relop_exprs separated by commas
+static AST_NODE *parseRelopExprList (CompilerContext *ctx) {
+    AST_NODE *list;
+
+    if (!startsExpression(peekToken(ctx))) {
+        return Allocate(ctx, NUL_NODE);
+    }
+    list = parseExpression(ctx, PRECEDENCE_OR, NULL);
+    while (peekToken(ctx) == MK_COMMA) {
+        nextToken(ctx);
+        list = makeSibling(list, parseExpression(ctx, PRECEDENCE_OR, NULL));
+    }
+    return makeChild(Allocate(ctx, NONEMPTY_RELOP_EXPR_LIST_NODE), list);
+}
+
+
+// var_ref after its ID: the ID alone or with a dim_list of exprs
+static AST_NODE *parseVarRef (CompilerContext *ctx, char *lexeme) {
+    AST_NODE *dims = NULL;
+
+    while (peekToken(ctx) == MK_LB) {
+        nextToken(ctx);
+        dims = dims ? makeSibling(dims, parseExpression(ctx, PRECEDENCE_ADDITIVE, NULL)) : parseExpression(ctx, PRECEDENCE_ADDITIVE, NULL);
+        expect(ctx, MK_RB);
+    }
+    if (dims == NULL) {
+        return makeIDNode(ctx, lexeme, NORMAL_ID);
+    }
+    return makeChild(makeIDNode(ctx, lexeme, ARRAY_ID), dims);
+}
+
+
+// a factor that starts with an ID that has been read: a call or a var_ref
+static AST_NODE *parseIdFactor (CompilerContext *ctx, char *lexeme) {
+    AST_NODE *call;
+    AST_NODE *arguments;
+
+    if (peekToken(ctx) != MK_LPAREN) {
+        return parseVarRef(ctx, lexeme);
+    }
+    nextToken(ctx);
+    arguments = parseRelopExprList(ctx);
+    expect(ctx, MK_RPAREN);
+    call = makeStmtNode(ctx, FUNCTION_CALL_STMT);
+    return makeFamily(call, 2, makeIDNode(ctx, lexeme, NORMAL_ID), arguments);
+}
+
+
+// - or ! only apply to a parenthesized relop_expr, a constant, a call or a
+// var_ref
+static AST_NODE *parseUnary (CompilerContext *ctx, UNARY_OPERATOR op) {
+    AST_NODE *node;
+    AST_NODE *operand;
+    char *lexeme;
+
+    switch (peekToken(ctx)) {
+        case MK_LPAREN:
+            nextToken(ctx);
+            operand = parseExpression(ctx, PRECEDENCE_OR, NULL);
+            expect(ctx, MK_RPAREN);
+            node = makeExprNode(ctx, UNARY_OPERATION, op);
+            return makeChild(node, operand);
+
+        case CONST:
+            nextToken(ctx);
+            node = makeExprNode(ctx, UNARY_OPERATION, op);
+            return makeChild(node, makeConstNode(ctx, ctx->parser->lookaheadValue.const1));
+
+        case ID:
+            lexeme = expectId(ctx);
+            if (peekToken(ctx) == MK_LPAREN) {
+                nextToken(ctx);
+                operand = parseRelopExprList(ctx);
+                expect(ctx, MK_RPAREN);
+                node = makeExprNode(ctx, UNARY_OPERATION, op);
+                AST_NODE *call = makeStmtNode(ctx, FUNCTION_CALL_STMT);
+                makeChild(node, call);
+                makeFamily(call, 2, makeIDNode(ctx, lexeme, NORMAL_ID), operand);
+                return node;
+            }
+            operand = parseVarRef(ctx, lexeme);
+            node = makeExprNode(ctx, UNARY_OPERATION, op);
+            return makeChild(node, operand);
+    }
+    syntaxError(ctx);
+    return NULL;
+}
+
+
+// factor, `leadingId` is an ID the caller has already read
+static AST_NODE *parseFactor (CompilerContext *ctx, char *leadingId) {
+    AST_NODE *node;
+
+    if (leadingId) {
+        return parseIdFactor(ctx, leadingId);
+    }
+
+    switch (peekToken(ctx)) {
+        case MK_LPAREN:
+            nextToken(ctx);
+            node = parseExpression(ctx, PRECEDENCE_OR, NULL);
+            expect(ctx, MK_RPAREN);
+            return node;
+
+        case OP_MINUS:
+            nextToken(ctx);
+            return parseUnary(ctx, UNARY_OP_NEGATIVE);
+
+        case OP_NOT:
+            nextToken(ctx);
+            return parseUnary(ctx, UNARY_OP_LOGICAL_NEGATION);
+
+        case CONST:
+            nextToken(ctx);
+            return makeConstNode(ctx, ctx->parser->lookaheadValue.const1);
+
+        case ID:
+            return parseIdFactor(ctx, expectId(ctx));
+    }
+    syntaxError(ctx);
+    return NULL;
+}
+
+
+// precedence climbing over the operators binding at least `minPrecedence`,
+// PRECEDENCE_OR parses a relop_expr and PRECEDENCE_ADDITIVE an expr
+static AST_NODE *parseExpression (CompilerContext *ctx, int minPrecedence, char *leadingId) {
+    AST_NODE *left = parseFactor(ctx, leadingId);
+
+    for (;;) {
+        int token = peekToken(ctx);
+        int precedence = binaryPrecedence(token);
+        AST_NODE *op = NULL;
+        AST_NODE *right;
+
+        if (precedence == 0 || precedence < minPrecedence) {
+            return left;
+        }
+        nextToken(ctx);
+        if (precedence > PRECEDENCE_AND) {
+            op = makeExprNode(ctx, BINARY_OPERATION, binaryOperator(token));
+        }
+        right = parseExpression(ctx, precedence + 1, NULL);
+        if (op == NULL) {
+            op = makeExprNode(ctx, BINARY_OPERATION, binaryOperator(token));
+        }
+        left = makeFamily(op, 2, left, right);
+
+        if (precedence == PRECEDENCE_RELATIONAL && binaryPrecedence(peekToken(ctx)) == PRECEDENCE_RELATIONAL) {
+            syntaxError(ctx);
+        }
+    }
+}
+
+
+// assign_expr: ID = relop_expr or a relop_expr
+static AST_NODE *parseAssignExpr (CompilerContext *ctx) {
+    AST_NODE *node;
+    char *lexeme;
+
+    if (peekToken(ctx) != ID) {
+        return parseExpression(ctx, PRECEDENCE_OR, NULL);
+    }
+    lexeme = expectId(ctx);
+    if (peekToken(ctx) != OP_ASSIGN) {
+        return parseExpression(ctx, PRECEDENCE_OR, lexeme);
+    }
+    nextToken(ctx);
+    AST_NODE *value = parseExpression(ctx, PRECEDENCE_OR, NULL);
+    node = makeStmtNode(ctx, ASSIGN_STMT);
+    return makeFamily(node, 2, makeIDNode(ctx, lexeme, NORMAL_ID), value);
+}
+
+
+// assign_expr_list: empty, or assign_exprs separated by commas
+static AST_NODE *parseAssignExprList (CompilerContext *ctx) {
+    AST_NODE *list;
+
+    if (!startsExpression(peekToken(ctx))) {
+        return Allocate(ctx, NUL_NODE);
+    }
+    list = parseAssignExpr(ctx);
+    while (peekToken(ctx) == MK_COMMA) {
+        nextToken(ctx);
+        list = makeSibling(list, parseAssignExpr(ctx));
+    }
+    return makeChild(Allocate(ctx, NONEMPTY_ASSIGN_EXPR_LIST_NODE), list);
+}
+
+
+// cexpr, the constant expressions of array declarations
+
+static AST_NODE *parseCexpr(CompilerContext *ctx);
+
+static AST_NODE *parseCfactor (CompilerContext *ctx) {
+    AST_NODE *node;
+
+    if (peekToken(ctx) == CONST) {
+        nextToken(ctx);
+        return makeConstNode(ctx, ctx->parser->lookaheadValue.const1);
+    }
+    expect(ctx, MK_LPAREN);
+    node = parseCexpr(ctx);
+    expect(ctx, MK_RPAREN);
+    return node;
+}
+
+
+static AST_NODE *parseMcexpr (CompilerContext *ctx) {
+    AST_NODE *left = parseCfactor(ctx);
+
+    while (peekToken(ctx) == OP_TIMES || peekToken(ctx) == OP_DIVIDE) {
+        BINARY_OPERATOR op = binaryOperator(peekToken(ctx));
+        nextToken(ctx);
+        AST_NODE *right = parseCfactor(ctx);
+        left = makeFamily(makeExprNode(ctx, BINARY_OPERATION, op), 2, left, right);
+    }
+    return left;
+}
+
+
+static AST_NODE *parseCexpr (CompilerContext *ctx) {
+    AST_NODE *left = parseMcexpr(ctx);
+
+    while (peekToken(ctx) == OP_PLUS || peekToken(ctx) == OP_MINUS) {
+        BINARY_OPERATOR op = binaryOperator(peekToken(ctx));
+        nextToken(ctx);
+        AST_NODE *right = parseMcexpr(ctx);
+        left = makeFamily(makeExprNode(ctx, BINARY_OPERATION, op), 2, left, right);
+    }
+    return left;
+}
+
+
+// dim_decl: one or more [cexpr]
+static AST_NODE *parseDimDecl (CompilerContext *ctx) {
+    AST_NODE *dims = NULL;
+
+    do {
+        expect(ctx, MK_LB);
+        dims = dims ? makeSibling(dims, parseCexpr(ctx)) : parseCexpr(ctx);
+        expect(ctx, MK_RB);
+    } while (peekToken(ctx) == MK_LB);
+    return dims;
+}
+
+
+// declarations
+
+static AST_NODE *parseType (CompilerContext *ctx) {
+    int token = peekToken(ctx);
+    nextToken(ctx);
+    if (token == INT) {
+        return makeIDNode(ctx, ctx->internedInt, NORMAL_ID);
+    }
+    return makeIDNode(ctx, ctx->internedFloat, NORMAL_ID);
+}
+
+
+// init_id after its ID
+static AST_NODE *parseInitId (CompilerContext *ctx, char *lexeme) {
+    AST_NODE *node;
+
+    if (peekToken(ctx) == MK_LB) {
+        AST_NODE *dims = parseDimDecl(ctx);
+        return makeChild(makeIDNode(ctx, lexeme, ARRAY_ID), dims);
+    }
+    if (peekToken(ctx) == OP_ASSIGN) {
+        nextToken(ctx);
+        AST_NODE *value = parseExpression(ctx, PRECEDENCE_OR, NULL);
+        node = makeIDNode(ctx, lexeme, WITH_INIT_ID);
+        return makeChild(node, value);
+    }
+    return makeIDNode(ctx, lexeme, NORMAL_ID);
+}
+
+
+// var_decl after its type and first ID: the rest of the init_id_list and
+// the semicolon. `type` is NULL when the type is the ID `typeName`
+static AST_NODE *parseVarDecl (CompilerContext *ctx, AST_NODE *type, char *typeName, char *lexeme) {
+    AST_NODE *list = parseInitId(ctx, lexeme);
+    AST_NODE *decl;
+
+    while (peekToken(ctx) == MK_COMMA) {
+        nextToken(ctx);
+        list = makeSibling(list, parseInitId(ctx, expectId(ctx)));
+    }
+    expect(ctx, MK_SEMICOLON);
+
+    decl = makeDeclNode(ctx, VARIABLE_DECL);
+    if (type == NULL) {
+        type = makeIDNode(ctx, typeName, NORMAL_ID);
+    }
+    return makeFamily(decl, 2, type, list);
+}
+
+
+// id_list item after its ID
+static AST_NODE *parseIdListItem (CompilerContext *ctx, char *lexeme) {
+    if (peekToken(ctx) == MK_LB) {
+        AST_NODE *dims = parseDimDecl(ctx);
+        return makeChild(makeIDNode(ctx, lexeme, ARRAY_ID), dims);
+    }
+    return makeIDNode(ctx, lexeme, NORMAL_ID);
+}
+
+
+// type_decl after TYPEDEF
+static AST_NODE *parseTypeDecl (CompilerContext *ctx) {
+    AST_NODE *type = NULL;
+    AST_NODE *list;
+    AST_NODE *decl;
+
+    if (peekToken(ctx) == INT || peekToken(ctx) == FLOAT) {
+        type = parseType(ctx);
+    }
+    else {
+        expect(ctx, VOID);
+    }
+
+    list = parseIdListItem(ctx, expectId(ctx));
+    while (peekToken(ctx) == MK_COMMA) {
+        nextToken(ctx);
+        list = makeSibling(list, parseIdListItem(ctx, expectId(ctx)));
+    }
+    expect(ctx, MK_SEMICOLON);
+
+    decl = makeDeclNode(ctx, TYPE_DECL);
+    if (type == NULL) {
+        type = makeIDNode(ctx, ctx->internedVoid, NORMAL_ID);
+    }
+    return makeFamily(decl, 2, type, list);
+}
+
+
+// statements
+
+static AST_NODE *parseBlock(CompilerContext *ctx);
+static AST_NODE *parseStatement(CompilerContext *ctx);
+
+
+// a statement that starts with an ID that has been read: a call or an
+// assignment
+static AST_NODE *parseIdStatement (CompilerContext *ctx, char *lexeme) {
+    AST_NODE *node;
+
+    if (peekToken(ctx) == MK_LPAREN) {
+        nextToken(ctx);
+        AST_NODE *arguments = parseRelopExprList(ctx);
+        expect(ctx, MK_RPAREN);
+        expect(ctx, MK_SEMICOLON);
+        node = makeStmtNode(ctx, FUNCTION_CALL_STMT);
+        return makeFamily(node, 2, makeIDNode(ctx, lexeme, NORMAL_ID), arguments);
+    }
+
+    AST_NODE *target = parseVarRef(ctx, lexeme);
+    expect(ctx, OP_ASSIGN);
+    AST_NODE *value = parseExpression(ctx, PRECEDENCE_OR, NULL);
+    expect(ctx, MK_SEMICOLON);
+    node = makeStmtNode(ctx, ASSIGN_STMT);
+    return makeFamily(node, 2, target, value);
+}
+
+
+static AST_NODE *parseStatement (CompilerContext *ctx) {
+    AST_NODE *node;
+    AST_NODE *test;
+    AST_NODE *body;
+
+    switch (peekToken(ctx)) {
+        case MK_LBRACE:
+            nextToken(ctx);
+            node = parseBlock(ctx);
+            expect(ctx, MK_RBRACE);
+            return node;
+
+        case WHILE:
+            nextToken(ctx);
+            expect(ctx, MK_LPAREN);
+            test = parseAssignExpr(ctx);
+            expect(ctx, MK_RPAREN);
+            body = parseStatement(ctx);
+            node = makeStmtNode(ctx, WHILE_STMT);
+            return makeFamily(node, 2, test, body);
+
+        case FOR: {
+            nextToken(ctx);
+            expect(ctx, MK_LPAREN);
+            AST_NODE *init = parseAssignExprList(ctx);
+            expect(ctx, MK_SEMICOLON);
+            AST_NODE *condition = parseRelopExprList(ctx);
+            expect(ctx, MK_SEMICOLON);
+            AST_NODE *step = parseAssignExprList(ctx);
+            expect(ctx, MK_RPAREN);
+            body = parseStatement(ctx);
+            node = makeStmtNode(ctx, FOR_STMT);
+            return makeFamily(node, 4, init, condition, step, body);
+        }
+
+        case IF:
+            nextToken(ctx);
+            expect(ctx, MK_LPAREN);
+            test = parseAssignExpr(ctx);
+            expect(ctx, MK_RPAREN);
+            body = parseStatement(ctx);
+            // the else goes with the nearest if, like bison's shift
+            if (peekToken(ctx) == ELSE) {
+                nextToken(ctx);
+                AST_NODE *elseBody = parseStatement(ctx);
+                node = makeStmtNode(ctx, IF_STMT);
+                return makeFamily(node, 3, test, body, elseBody);
+            }
+            node = makeStmtNode(ctx, IF_STMT);
+            return makeFamily(node, 3, test, body, Allocate(ctx, NUL_NODE));
+
+        case ID:
+            return parseIdStatement(ctx, expectId(ctx));
+
+        case MK_SEMICOLON:
+            nextToken(ctx);
+            return Allocate(ctx, NUL_NODE);
+
+        case RETURN:
+            nextToken(ctx);
+            if (peekToken(ctx) == MK_SEMICOLON) {
+                nextToken(ctx);
+                return makeStmtNode(ctx, RETURN_STMT);
+            }
+            AST_NODE *value = parseExpression(ctx, PRECEDENCE_OR, NULL);
+            expect(ctx, MK_SEMICOLON);
+            node = makeStmtNode(ctx, RETURN_STMT);
+            return makeChild(node, value);
+    }
+    syntaxError(ctx);
+    return NULL;
+}
+
+
+static int startsStatement (int token) {
+    return token == MK_LBRACE || token == WHILE || token == FOR || token == IF ||
+           token == ID || token == MK_SEMICOLON || token == RETURN;
+}
+
+
+// block: declarations, then statements, up to the closing brace. an ID
+// followed by an ID starts a declaration, by anything else a statement
+static AST_NODE *parseBlock (CompilerContext *ctx) {
+    AST_NODE *decls = NULL;
+    AST_NODE *stmts = NULL;
+    AST_NODE *block;
+    AST_NODE *decl;
+
+    for (;;) {
+        int token = peekToken(ctx);
+        if (token == TYPEDEF) {
+            nextToken(ctx);
+            decl = parseTypeDecl(ctx);
+        }
+        else if (token == INT || token == FLOAT) {
+            AST_NODE *type = parseType(ctx);
+            decl = parseVarDecl(ctx, type, NULL, expectId(ctx));
+        }
+        else if (token == ID) {
+            char *lexeme = expectId(ctx);
+            if (peekToken(ctx) != ID) {
+                stmts = parseIdStatement(ctx, lexeme);
+                break;
+            }
+            decl = parseVarDecl(ctx, NULL, lexeme, expectId(ctx));
+        }
+        else {
+            break;
+        }
+        decls = decls ? makeSibling(decls, decl) : decl;
+    }
+
+    while (startsStatement(peekToken(ctx))) {
+        stmts = stmts ? makeSibling(stmts, parseStatement(ctx)) : parseStatement(ctx);
+    }
+
+    block = Allocate(ctx, BLOCK_NODE);
+    if (decls && stmts) {
+        AST_NODE *declNode = makeChild(Allocate(ctx, VARIABLE_DECL_LIST_NODE), decls);
+        AST_NODE *stmtNode = makeChild(Allocate(ctx, STMT_LIST_NODE), stmts);
+        makeFamily(block, 2, declNode, stmtNode);
+    }
+    else if (stmts) {
+        makeChild(block, makeChild(Allocate(ctx, STMT_LIST_NODE), stmts));
+    }
+    else if (decls) {
+        makeChild(block, makeChild(Allocate(ctx, VARIABLE_DECL_LIST_NODE), decls));
+    }
+    return block;
+}
+
+
+// functions
+
+// param after its type (NULL for the ID `typeName`)
+static AST_NODE *parseParam (CompilerContext *ctx, AST_NODE *type, char *typeName) {
+    char *lexeme = expectId(ctx);
+    AST_NODE *dims = NULL;
+    AST_NODE *param;
+    AST_NODE *id;
+
+    if (peekToken(ctx) == MK_LB) {
+        // dim_fn, the first dimension may be left out
+        nextToken(ctx);
+        dims = startsExpression(peekToken(ctx)) ? parseExpression(ctx, PRECEDENCE_ADDITIVE, NULL) : Allocate(ctx, NUL_NODE);
+        expect(ctx, MK_RB);
+        while (peekToken(ctx) == MK_LB) {
+            nextToken(ctx);
+            dims = makeSibling(dims, parseExpression(ctx, PRECEDENCE_ADDITIVE, NULL));
+            expect(ctx, MK_RB);
+        }
+    }
+
+    param = makeDeclNode(ctx, FUNCTION_PARAMETER_DECL);
+    if (type == NULL) {
+        type = makeIDNode(ctx, typeName, NORMAL_ID);
+    }
+    if (dims) {
+        id = makeChild(makeIDNode(ctx, lexeme, ARRAY_ID), dims);
+    }
+    else {
+        id = makeIDNode(ctx, lexeme, NORMAL_ID);
+    }
+    return makeFamily(param, 2, type, id);
+}
+
+
+static AST_NODE *parseParamList (CompilerContext *ctx) {
+    AST_NODE *list = NULL;
+
+    for (;;) {
+        AST_NODE *param;
+        if (peekToken(ctx) == INT || peekToken(ctx) == FLOAT) {
+            AST_NODE *type = parseType(ctx);
+            param = parseParam(ctx, type, NULL);
+        }
+        else if (peekToken(ctx) == ID || list) {
+            param = parseParam(ctx, NULL, expectId(ctx));
+        }
+        else {
+            break;
+        }
+        list = list ? makeSibling(list, param) : param;
+        if (peekToken(ctx) != MK_COMMA) {
+            break;
+        }
+        nextToken(ctx);
+    }
+    return makeChild(Allocate(ctx, PARAM_LIST_NODE), list);
+}
+
+
+// function_decl after its function_head, from the parameter list on
+static AST_NODE *parseFunction (CompilerContext *ctx, AST_NODE *head) {
+    AST_NODE *params;
+    AST_NODE *block;
+
+    expect(ctx, MK_LPAREN);
+    params = parseParamList(ctx);
+    expect(ctx, MK_RPAREN);
+    expect(ctx, MK_LBRACE);
+    block = parseBlock(ctx);
+    expect(ctx, MK_RBRACE);
+
+    makeChild(head, params);
+    makeChild(head, block);
+    return head;
+}
+
+
+static AST_NODE *makeFunctionHead (CompilerContext *ctx, AST_NODE *type, char *lexeme) {
+    AST_NODE *head = makeDeclNode(ctx, FUNCTION_DECL);
+    return makeFamily(head, 2, type, makeIDNode(ctx, lexeme, NORMAL_ID));
+}
+
+
+// global_decl: declarations and the function they come before
+static AST_NODE *parseGlobalDecl (CompilerContext *ctx) {
+    AST_NODE *decls = NULL;
+    AST_NODE *function;
+
+    for (;;) {
+        int token = peekToken(ctx);
+        AST_NODE *decl;
+
+        if (token == TYPEDEF) {
+            nextToken(ctx);
+            decl = parseTypeDecl(ctx);
+        }
+        else if (token == VOID) {
+            nextToken(ctx);
+            // nothing but a function can follow, bison doesn't look
+            // ahead before it makes the head
+            char *lexeme = expectId(ctx);
+            AST_NODE *head = makeDeclNode(ctx, FUNCTION_DECL);
+            AST_NODE *voidNode = makeIDNode(ctx, ctx->internedVoid, NORMAL_ID);
+            function = parseFunction(ctx, makeFamily(head, 2, voidNode, makeIDNode(ctx, lexeme, NORMAL_ID)));
+            break;
+        }
+        else if (token == INT || token == FLOAT) {
+            AST_NODE *type = parseType(ctx);
+            char *lexeme = expectId(ctx);
+            if (peekToken(ctx) == MK_LPAREN) {
+                function = parseFunction(ctx, makeFunctionHead(ctx, type, lexeme));
+                break;
+            }
+            decl = parseVarDecl(ctx, type, NULL, lexeme);
+        }
+        else if (token == ID) {
+            char *typeName = expectId(ctx);
+            char *lexeme = expectId(ctx);
+            if (peekToken(ctx) == MK_LPAREN) {
+                AST_NODE *head = makeDeclNode(ctx, FUNCTION_DECL);
+                AST_NODE *idNode = makeIDNode(ctx, typeName, NORMAL_ID);
+                function = parseFunction(ctx, makeFamily(head, 2, idNode, makeIDNode(ctx, lexeme, NORMAL_ID)));
+                break;
+            }
+            decl = parseVarDecl(ctx, NULL, typeName, lexeme);
+        }
+        else {
+            syntaxError(ctx);
+        }
+        decls = decls ? makeSibling(decls, decl) : decl;
+    }
+
+    if (decls == NULL) {
+        return function;
+    }
+    return makeSibling(makeChild(Allocate(ctx, VARIABLE_DECL_LIST_NODE), decls), function);
+}
+
+
+AST_NODE *parseProgram (CompilerContext *ctx) {
+    struct DescentParser parser;
+    AST_NODE *list = NULL;
+    AST_NODE *program;
+
+    parser.lookahead = -1;
+    ctx->parser = &parser;
+    if (setjmp(parser.failed) != 0) {
+        ctx->parser = NULL;
+        return NULL;
+    }
+    while (peekToken(ctx) != 0) {
+        AST_NODE *global = parseGlobalDecl(ctx);
+        list = list ? makeSibling(list, global) : global;
+    }
+
+    program = Allocate(ctx, PROGRAM_NODE);
+    ctx->parser = NULL;
+    return makeChild(program, list);
+}
@@ -0,0 +1,13 @@
+#ifndef __DESCENT_PARSER_H__
+#define __DESCENT_PARSER_H__
+#include "header.h"
+
+
+// hand written recursive descent parser for the grammar in parser.y
+// (--descent-parser). it reads the same yylex() tokens and returns the same
+// tree yyparse() leaves in ctx->prog, syntax errors go to yyerror() at the
+// same token and return NULL
+AST_NODE *parseProgram (CompilerContext *ctx);
+
+
+#endif // __DESCENT_PARSER_H__
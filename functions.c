@@ -216,3 +216,31 @@ int printGVNode (FILE *fp, AST_NODE *node, int count) {
     return countAfterCheckSibling;
 }
 
+
+
+// the tree as indented text, a node per line with its line number. children
+// whose parent or leftmostSibling don't point back where they should are
+// marked, so two dumps only match if the links match too
+static void printASTNode (FILE *fp, AST_NODE *node, int depth) {
+    AST_NODE *child;
+
+    fprintf(fp, "%*s%d ", 2 * depth, "", node->linenumber);
+    printLabelString(fp, node);
+    fprintf(fp, "\n");
+
+    for (child = node->child; child; child = child->rightSibling) {
+        if (child->parent != node) {
+            fprintf(fp, "%*sbad parent\n", 2 * depth + 2, "");
+        }
+        if (child->leftmostSibling != node->child) {
+            fprintf(fp, "%*sbad leftmostSibling\n", 2 * depth + 2, "");
+        }
+        printASTNode(fp, child, depth + 1);
+    }
+}
+
+void printAST (FILE *fp, AST_NODE *root) {
+    if (root) {
+        printASTNode(fp, root, 0);
+    }
+}
@@ -1,8 +1,14 @@
 #ifndef __HEADER_H__
 #define __HEADER_H__
 
+#include <stddef.h>
+#include <stdio.h>
+
 #define MAX_ARRAY_DIMENSION 10
 
+// all the state of one compilation, see compilerContext.h
+typedef struct CompilerContext CompilerContext;
+
 typedef enum DATA_TYPE {
     INT_TYPE,
     FLOAT_TYPE,
@@ -176,8 +182,23 @@ typedef struct AST_NODE {
     } semantic_value;
 } AST_NODE;
 
-AST_NODE *Allocate(AST_TYPE type);
-void semanticAnalysis(AST_NODE *root);
+// a node on the line of the token the parser read last
+AST_NODE *Allocate(CompilerContext *ctx, AST_TYPE type);
+// the AST as indented text, one node per line (--dump-ast)
+void printAST(FILE *fp, AST_NODE *root);
+
+// memory for the AST, constants and the symbol table, it is all released
+// together by arenaRelease() once the compilation is over
+void *arenaAlloc(size_t size);
+char *arenaStrdup(const char *str);
+void arenaRelease(void);
+// the same, but some of the memory is kept for the next compilation
+void arenaReset(void);
+// the arena is per thread: a thread that is done can detach its chunks,
+// another one attaches them to its own arena and releases them with it
+void *arenaDetach(void);
+void arenaAttach(void *chunks);
+void semanticAnalysis(CompilerContext *ctx, AST_NODE *root);
 
 #endif    // __HEADER_H__
 
@@ -0,0 +1,253 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+
+#include "header.h"
+#include "libcmm.h"
+#include "cache.h"
+#include "codegen.h"
+#include "passTimer.h"
+#include "sourceBuffer.h"
+#include "symbolTable.h"
+#include "compilerContext.h"
+
+
+// parsing and semantic analysis, with the "lex + parse" pass started. `text`
+// is released as soon as the tree is built
+static int analyse (CompilerContext *ctx, char *text, size_t size, int mapped) {
+    jmp_buf gaveUp;
+    volatile int released = 0;
+    int failed;
+
+    // compileFailed() comes back here when the intern or the symbol table
+    // can't be allocated
+    ctx->failed = &gaveUp;
+    if (setjmp(gaveUp) != 0) {
+        ctx->failed = NULL;
+        if (!released)
+            releaseSource(text, size, mapped);
+        endPass();
+        ctx->anyErrorOccur = 1;
+        ctx->errorCount++;
+        return 1;
+    }
+
+    failed = parseSource(ctx, text, size) != 0;
+    // the lexemes the AST keeps are interned by now
+    releaseSource(text, size, mapped);
+    released = 1;
+    endPass();
+    // printGV(ctx->prog, NULL);
+    if (!failed && ctx->astOnly)
+        printAST(stdout, ctx->prog);
+
+    if (!failed && !ctx->tokensOnly && !ctx->astOnly) {
+        startPass("semantic analysis");
+        initializeSymbolTable(ctx);
+        semanticAnalysis(ctx, ctx->prog);
+        endPass();
+    }
+    ctx->failed = NULL;
+    return failed;
+}
+
+
+static int generatesCode (const CompilerContext *ctx, int failed) {
+    return !failed && !ctx->tokensOnly && !ctx->astOnly && (!ctx->anyErrorOccur || !ctx->skipCodeOnError);
+}
+
+
+// code generation after analyse(), then the tree and the tables go
+static int generate (CompilerContext *ctx, int failed) {
+    if (generatesCode(ctx, failed)) {
+        startPass("code generation");
+        if (codeGen(ctx, ctx->prog) != 0) {
+            ctx->anyErrorOccur = 1;
+            ctx->errorCount++;
+            failed = 1;
+        }
+        endPass();
+    }
+
+    symbolTableEnd(ctx);
+    if (ctx->reuseArena)
+        arenaReset();
+    else
+        arenaRelease();
+    return failed ? -1 : 0;
+}
+
+
+static int runPasses (CompilerContext *ctx, char *text, size_t size, int mapped) {
+    return generate(ctx, analyse(ctx, text, size, mapped));
+}
+
+
+// --cache: a hit prints and writes what the compilation did, a miss
+// compiles into memory, stores that and then does the same
+static int compileCached (CompilerContext *ctx, char *text, size_t size, int mapped) {
+    FILE *output = ctx->output;
+    FILE *diagnostics = ctx->diagnostics;
+    char key[CACHE_KEY_LENGTH + 1];
+    CacheEntry entry;
+    int status;
+
+    // without the two NULs
+    cacheKey(ctx, text, size - 2, key);
+    if (cacheLookup(ctx->cacheDirectory, key, &entry)) {
+        releaseSource(text, size, mapped);
+        endPass();
+    }
+    else {
+        int failed;
+
+        entry.assembly = entry.diagnostics = NULL;
+        ctx->output = open_memstream(&entry.assembly, &entry.assemblyLength);
+        ctx->diagnostics = open_memstream(&entry.diagnostics, &entry.diagnosticsLength);
+        if (ctx->output == NULL || ctx->diagnostics == NULL) {
+            // compiled without the cache then
+            if (ctx->output)
+                fclose(ctx->output);
+            if (ctx->diagnostics)
+                fclose(ctx->diagnostics);
+            free(entry.assembly);
+            free(entry.diagnostics);
+            ctx->output = output;
+            ctx->diagnostics = diagnostics;
+            return runPasses(ctx, text, size, mapped);
+        }
+        failed = analyse(ctx, text, size, mapped);
+        entry.hasAssembly = generatesCode(ctx, failed);
+        entry.failed = generate(ctx, failed) != 0;
+        entry.hasAssembly = entry.hasAssembly && !entry.failed;
+        entry.errorCount = ctx->errorCount;
+        fclose(ctx->output);
+        fclose(ctx->diagnostics);
+        ctx->output = output;
+        ctx->diagnostics = diagnostics;
+        cacheStore(ctx->cacheDirectory, ctx->cacheLimit > 0 ? ctx->cacheLimit : CACHE_DEFAULT_LIMIT,
+                   key, &entry);
+    }
+
+    fwrite(entry.diagnostics, 1, entry.diagnosticsLength, ctx->diagnostics);
+    ctx->errorCount = entry.errorCount;
+    ctx->anyErrorOccur = entry.errorCount > 0;
+    status = entry.failed ? -1 : 0;
+    if (entry.hasAssembly) {
+        FILE *file = ctx->output ? ctx->output : fopen(ctx->outputPath, "w");
+        if (file == NULL) {
+            fputs("[-] file open error\n", ctx->diagnostics);
+            ctx->anyErrorOccur = 1;
+            ctx->errorCount++;
+            status = -1;
+        }
+        else {
+            fwrite(entry.assembly, 1, entry.assemblyLength, file);
+            if (file != ctx->output)
+                fclose(file);
+        }
+    }
+    cacheEntryEnd(&entry);
+    return status;
+}
+
+
+static int compileSource (CompilerContext *ctx, char *text, size_t size, int mapped) {
+    if (ctx->cacheDirectory && !ctx->tokensOnly && !ctx->astOnly)
+        return compileCached(ctx, text, size, mapped);
+    return runPasses(ctx, text, size, mapped);
+}
+
+
+int compileFile (CompilerContext *ctx, const char *source) {
+    char *text;
+    size_t size;
+    int mapped;
+
+    // the scanner runs inside yyparse(), so lexing is timed with parsing
+    startPass("lex + parse");
+    text = loadSource(source, &size, &mapped);
+    if (text == NULL) {
+        fprintf(ctx->diagnostics, "cannot open %s\n", source);
+        ctx->anyErrorOccur = 1;
+        ctx->errorCount++;
+        return -1;
+    }
+    return compileSource(ctx, text, size, mapped);
+}
+
+
+// cmm_compile() without the memory to start: no assembly and one error
+static int cannotCompile (cmm_diagnostics *diagnostics) {
+    static const char message[] = "out of memory\n";
+
+    if (diagnostics) {
+        diagnostics->text = strdup(message);
+        diagnostics->length = diagnostics->text ? strlen(message) : 0;
+        diagnostics->errorCount = 1;
+    }
+    return -1;
+}
+
+
+int cmm_compile (const char *src, size_t len, const cmm_options *options,
+                 char **asm_out, size_t *asm_len, cmm_diagnostics *diagnostics) {
+    CompilerContext context;
+    char *messages = NULL;
+    size_t messagesLength = 0;
+    char *text;
+    size_t size;
+    int failed;
+
+    initializeContext(&context);
+    if (options) {
+        context.bufferedIO = options->bufferedIO;
+        context.batchedInput = options->batchedInput;
+        context.descentParser = options->descentParser;
+        context.threadedLexer = options->threadedLexer;
+        context.reuseArena = options->reuseMemory;
+        context.cacheDirectory = options->cacheDirectory;
+        context.cacheLimit = options->cacheLimit;
+    }
+    // no assembly at all for a program with errors
+    context.skipCodeOnError = 1;
+    *asm_out = NULL;
+    *asm_len = 0;
+    context.output = open_memstream(asm_out, asm_len);
+    context.diagnostics = open_memstream(&messages, &messagesLength);
+    startPass("lex + parse");
+    text = copySource(src, len, &size);
+    if (context.output == NULL || context.diagnostics == NULL || text == NULL) {
+        endPass();
+        if (context.output)
+            fclose(context.output);
+        if (context.diagnostics)
+            fclose(context.diagnostics);
+        free(*asm_out);
+        free(messages);
+        free(text);
+        *asm_out = NULL;
+        *asm_len = 0;
+        return cannotCompile(diagnostics);
+    }
+    failed = compileSource(&context, text, size, 0) != 0 || context.anyErrorOccur;
+
+    fclose(context.output);
+    fclose(context.diagnostics);
+    if (failed) {
+        free(*asm_out);
+        *asm_out = NULL;
+        *asm_len = 0;
+    }
+    if (diagnostics) {
+        diagnostics->text = messages;
+        diagnostics->length = messagesLength;
+        diagnostics->errorCount = context.errorCount;
+    }
+    else
+        free(messages);
+    return failed ? -1 : 0;
+}
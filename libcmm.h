@@ -0,0 +1,60 @@
+#ifndef __LIBCMM_H__
+#define __LIBCMM_H__
+
+#include <stddef.h>
+
+
+// the compiler as a library (make libcmm.a libcmm.so): C-- source in memory
+// in, MIPS assembly in memory out. calls on different threads don't share
+// any state
+
+
+// the release; the key of the compile cache (--cache) also has a hash of
+// the compiler's sources that the Makefile computes, so a change to them
+// doesn't need a new version to stop old entries from being used
+#define CMM_VERSION "1.0"
+
+
+#if defined(__GNUC__)
+#define CMM_API __attribute__((visibility("default")))
+#else
+#define CMM_API
+#endif
+
+
+// the parser's command line options, all off with NULL
+typedef struct cmm_options {
+    int bufferedIO;          // --buffered-io
+    int batchedInput;        // --batched-input
+    int descentParser;       // --descent-parser
+    int threadedLexer;       // --threaded-lexer
+    // keep some of the memory for the thread's next call instead of freeing
+    // all of it, for hosts that compile one program after another
+    int reuseMemory;
+    // --cache and --cache-size, in bytes; no cache with NULL, the default
+    // size with 0
+    const char *cacheDirectory;
+    long long cacheLimit;
+} cmm_options;
+
+
+// the messages the parser prints, NUL terminated and malloc'ed
+typedef struct cmm_diagnostics {
+    char *text;
+    size_t length;
+    int errorCount;
+} cmm_diagnostics;
+
+
+// compiles the `len` bytes at `src`. returns 0 and the assembly in
+// *asm_out, *asm_len bytes and NUL terminated, or -1 and *asm_out NULL if
+// the program has errors. the messages go to `diagnostics` unless it is
+// NULL; the caller free()s *asm_out and diagnostics->text. nothing is
+// printed to stdout and running out of memory for the buffers, the tables or
+// the code is one more error; only the tree's own arena (alloc.c) still
+// ends the process when malloc() fails
+CMM_API int cmm_compile(const char *src, size_t len, const cmm_options *options,
+                        char **asm_out, size_t *asm_len, cmm_diagnostics *diagnostics);
+
+
+#endif // __LIBCMM_H__
@@ -0,0 +1,1371 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+
+#include "mipsim.h"
+#include "profile.h"
+
+// a tiny MIPS simulator for the code our code generator emits
+//
+// it only knows the subset of SPIM assembly that codegen.c prints: one
+// instruction per line, `label:` lines, `# ...` comments and the .data/.text
+// directives. pseudo-instructions (li, la, li.s, lw label, blt, ...) are kept
+// as they are instead of being expanded, but each one is charged the number
+// of real instructions SPIM would expand it to, so the dynamic instruction
+// count is comparable with what `spim` executes.
+
+
+#define TEXT_BASE   0x00400000
+#define DATA_BASE   0x10010000
+#define STACK_TOP   0x7ffffffc
+#define STACK_SIZE  (8 << 20)
+#define HEAP_SIZE   (8 << 20)
+#define RA_SENTINEL 0x00000004
+
+
+typedef enum MIPS_OP {
+    M_ADD, M_ADDU, M_SUB, M_SUBU, M_ADDI, M_ADDIU,
+    M_MULT, M_MULTU, M_DIV, M_DIVU, M_MFHI, M_MFLO, M_MUL, M_REM,
+    M_AND, M_ANDI, M_OR, M_ORI, M_XOR, M_XORI, M_NOR, M_NOT, M_NEG,
+    M_SLT, M_SLTI, M_SLTU, M_SLTIU, M_SEQ, M_SNE,
+    M_SLL, M_SRL, M_SRA, M_SLLV, M_SRLV,
+    M_LW, M_SW, M_LB, M_LBU, M_SB,
+    M_LI, M_LA, M_LUI, M_MOVE,
+    M_BEQ, M_BNE, M_BEQZ, M_BNEZ, M_BLEZ, M_BGTZ, M_BLTZ, M_BGEZ,
+    M_BLT, M_BGT, M_BLE, M_BGE, M_B,
+    M_J, M_JAL, M_JR, M_JALR,
+    M_SYSCALL, M_NOP,
+
+    M_LS, M_SS, M_LIS, M_MOVS, M_MTC1, M_MFC1,
+    M_ADDS, M_SUBS, M_MULS, M_DIVS, M_NEGS, M_ABSS,
+    M_CVTSW, M_CVTWS,
+    M_CEQS, M_CLTS, M_CLES, M_BC1T, M_BC1F,
+} MIPS_OP;
+
+
+typedef struct MnemonicInfo {
+    const char *name;
+    MIPS_OP op;
+} MnemonicInfo;
+
+
+static const MnemonicInfo mnemonics[] = {
+    {"add", M_ADD}, {"addu", M_ADDU}, {"sub", M_SUB}, {"subu", M_SUBU},
+    {"addi", M_ADDI}, {"addiu", M_ADDIU},
+    {"mult", M_MULT}, {"multu", M_MULTU}, {"div", M_DIV}, {"divu", M_DIVU},
+    {"mfhi", M_MFHI}, {"mflo", M_MFLO}, {"mul", M_MUL}, {"rem", M_REM},
+    {"and", M_AND}, {"andi", M_ANDI}, {"or", M_OR}, {"ori", M_ORI},
+    {"xor", M_XOR}, {"xori", M_XORI}, {"nor", M_NOR}, {"not", M_NOT}, {"neg", M_NEG},
+    {"slt", M_SLT}, {"slti", M_SLTI}, {"sltu", M_SLTU}, {"sltiu", M_SLTIU}, {"seq", M_SEQ}, {"sne", M_SNE},
+    {"sll", M_SLL}, {"srl", M_SRL}, {"sra", M_SRA}, {"sllv", M_SLLV}, {"srlv", M_SRLV},
+    {"lw", M_LW}, {"sw", M_SW}, {"lb", M_LB}, {"lbu", M_LBU}, {"sb", M_SB},
+    {"li", M_LI}, {"la", M_LA}, {"lui", M_LUI}, {"move", M_MOVE},
+    {"beq", M_BEQ}, {"bne", M_BNE}, {"beqz", M_BEQZ}, {"bnez", M_BNEZ},
+    {"blez", M_BLEZ}, {"bgtz", M_BGTZ}, {"bltz", M_BLTZ}, {"bgez", M_BGEZ},
+    {"blt", M_BLT}, {"bgt", M_BGT}, {"ble", M_BLE}, {"bge", M_BGE}, {"b", M_B},
+    {"j", M_J}, {"jal", M_JAL}, {"jr", M_JR}, {"jalr", M_JALR},
+    {"syscall", M_SYSCALL}, {"nop", M_NOP},
+
+    {"l.s", M_LS}, {"lwc1", M_LS}, {"s.s", M_SS}, {"swc1", M_SS},
+    {"li.s", M_LIS}, {"mov.s", M_MOVS}, {"mtc1", M_MTC1}, {"mfc1", M_MFC1},
+    {"add.s", M_ADDS}, {"sub.s", M_SUBS}, {"mul.s", M_MULS}, {"div.s", M_DIVS},
+    {"neg.s", M_NEGS}, {"abs.s", M_ABSS},
+    {"cvt.s.w", M_CVTSW}, {"cvt.w.s", M_CVTWS}, {"trunc.w.s", M_CVTWS},
+    {"c.eq.s", M_CEQS}, {"c.lt.s", M_CLTS}, {"c.le.s", M_CLES},
+    {"bc1t", M_BC1T}, {"bc1f", M_BC1F},
+    {NULL, M_NOP},
+};
+
+
+static const char *gprNames[32] = {
+    "zero", "at", "v0", "v1", "a0", "a1", "a2", "a3",
+    "t0", "t1", "t2", "t3", "t4", "t5", "t6", "t7",
+    "s0", "s1", "s2", "s3", "s4", "s5", "s6", "s7",
+    "t8", "t9", "k0", "k1", "gp", "sp", "fp", "ra",
+};
+
+
+// one decoded instruction
+//
+// rd/rs/rt are register numbers (general purpose or floating point depending
+// on the opcode), `imm` is an immediate or a memory offset, and `label` is the
+// symbol used by branches, jumps and label-addressed loads/stores. Labels are
+// resolved into `target` (an instruction index or a data address) after the
+// whole file has been read.
+typedef struct Insn {
+    MIPS_OP op;
+    int rd, rs, rt;
+    int32_t imm;
+    float fimm;
+    char *label;
+    int32_t target;
+    int hasBase;            // memory operand is C($rs) rather than a label
+    int cost;               // real instructions after SPIM's pseudo expansion
+    int asmLine;            // line number in the .s file
+    int srcLine;            // C-- line from the last `# [At: N]` annotation
+    int function;           // index in functionNames, -1 outside functions
+    long long executed;
+} Insn;
+
+
+typedef struct Label {
+    char *name;
+    int isText;
+    int32_t value;          // instruction index for .text, address for .data
+    struct Label *next;
+} Label;
+
+
+#define LABEL_HASH_SIZE 1024
+
+static Label *labelTable[LABEL_HASH_SIZE];
+
+static Insn *text = NULL;
+static int textCount = 0;
+static int textCapacity = 0;
+
+static uint8_t *dataSeg = NULL;
+static uint32_t dataSize = 0;       // static data, heap starts right after
+static uint32_t dataCapacity = 0;
+static uint32_t heapBreak = 0;
+
+static uint8_t *stackSeg = NULL;
+
+static int32_t gpr[32];
+static uint32_t fpr[32];
+static int32_t hi, lo;
+static int fcc;
+
+static const char *asmFileName = "";
+static int asmLineNumber = 0;
+
+// where the instructions being assembled come from, see mipsimLoad()
+static int srcLine = 0;
+static int currentFunction = -1;
+static int functionStart = 0;
+static char **functionNames = NULL;
+static int functionCount = 0;
+
+MipsStats mipsStats;
+
+static MipsCallHook callHook = NULL;
+static MipsReturnHook returnHook = NULL;
+
+
+static char *copyString (const char *s, size_t n) {
+    char *copy = (char *)malloc(n + 1);
+    if (!copy) {
+        fprintf(stderr, "mipsim: out of memory\n");
+        exit(2);
+    }
+    memcpy(copy, s, n);
+    copy[n] = '\0';
+    return copy;
+}
+
+
+static void die (const char *msg, const char *detail) {
+    fprintf(stderr, "mipsim: %s:%d: %s", asmFileName, asmLineNumber, msg);
+    if (detail)
+        fprintf(stderr, " '%s'", detail);
+    fprintf(stderr, "\n");
+    exit(2);
+}
+
+
+static unsigned hashName (const char *s) {
+    unsigned h = 5381;
+    while (*s)
+        h = h * 33 + (unsigned char)*s++;
+    return h & (LABEL_HASH_SIZE - 1);
+}
+
+
+static Label *findLabel (const char *name) {
+    Label *l = labelTable[hashName(name)];
+    while (l && strcmp(l->name, name) != 0)
+        l = l->next;
+    return l;
+}
+
+
+static void defineLabel (const char *name, int isText, int32_t value) {
+    if (findLabel(name))
+        die("duplicate label", name);
+
+    Label *l = (Label *)malloc(sizeof(Label));
+    l->name = copyString(name, strlen(name));
+    l->isText = isText;
+    l->value = value;
+    l->next = labelTable[hashName(name)];
+    labelTable[hashName(name)] = l;
+}
+
+
+// memory
+
+static void dataReserve (uint32_t bytes) {
+    if (dataSize + bytes <= dataCapacity)
+        return;
+    while (dataSize + bytes > dataCapacity)
+        dataCapacity = dataCapacity ? dataCapacity * 2 : 4096;
+    dataSeg = (uint8_t *)realloc(dataSeg, dataCapacity);
+}
+
+
+static void dataAlign (uint32_t align) {
+    uint32_t pad = (align - dataSize % align) % align;
+    dataReserve(pad);
+    memset(dataSeg + dataSize, 0, pad);
+    dataSize += pad;
+}
+
+
+static void dataEmit (const void *bytes, uint32_t n) {
+    dataReserve(n);
+    memcpy(dataSeg + dataSize, bytes, n);
+    dataSize += n;
+}
+
+
+static uint8_t *memAt (uint32_t addr, uint32_t n) {
+    if (addr >= DATA_BASE && addr + n <= DATA_BASE + heapBreak)
+        return dataSeg + (addr - DATA_BASE);
+    if (addr <= (uint32_t)STACK_TOP + 4 && addr >= (uint32_t)STACK_TOP + 4 - STACK_SIZE && addr + n <= (uint32_t)STACK_TOP + 4)
+        return stackSeg + (addr - ((uint32_t)STACK_TOP + 4 - STACK_SIZE));
+
+    fprintf(stderr, "mipsim: bad memory access at 0x%08x\n", addr);
+    exit(2);
+}
+
+
+static int32_t loadWord (uint32_t addr) {
+    int32_t v;
+    if (addr & 3) {
+        fprintf(stderr, "mipsim: unaligned load at 0x%08x\n", addr);
+        exit(2);
+    }
+    memcpy(&v, memAt(addr, 4), 4);
+    return v;
+}
+
+
+static void storeWord (uint32_t addr, int32_t v) {
+    if (addr & 3) {
+        fprintf(stderr, "mipsim: unaligned store at 0x%08x\n", addr);
+        exit(2);
+    }
+    memcpy(memAt(addr, 4), &v, 4);
+}
+
+
+static float asFloat (uint32_t bits) {
+    float f;
+    memcpy(&f, &bits, 4);
+    return f;
+}
+
+
+static uint32_t asBits (float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, 4);
+    return bits;
+}
+
+
+// assembler
+
+static int parseGpr (const char *s) {
+    int i;
+    if (s[0] != '$')
+        die("expected a register", s);
+    if (isdigit((unsigned char)s[1]))
+        return atoi(s + 1) & 31;
+    for (i = 0; i < 32; ++i)
+        if (strcmp(s + 1, gprNames[i]) == 0)
+            return i;
+    if (strcmp(s + 1, "s8") == 0)
+        return 30;
+    die("unknown register", s);
+    return 0;
+}
+
+
+static int parseFpr (const char *s) {
+    if (s[0] != '$' || s[1] != 'f' || !isdigit((unsigned char)s[2]))
+        die("expected a floating point register", s);
+    return atoi(s + 2) & 31;
+}
+
+
+static int isImmediate (const char *s) {
+    return isdigit((unsigned char)s[0]) || ((s[0] == '-' || s[0] == '+') && isdigit((unsigned char)s[1]));
+}
+
+
+static int32_t parseImmediate (const char *s) {
+    return (int32_t)strtol(s, NULL, 0);
+}
+
+
+static int fitsInHalf (int32_t v) {
+    return v >= -32768 && v <= 32767;
+}
+
+
+// memory operand: C($r), ($r), label, label+C, label($r)
+static void parseMemOperand (Insn *insn, const char *s) {
+    const char *paren = strchr(s, '(');
+
+    if (paren) {
+        char prefix[256];
+        size_t n = paren - s;
+        if (n >= sizeof(prefix))
+            die("operand too long", s);
+        memcpy(prefix, s, n);
+        prefix[n] = '\0';
+
+        char reg[16];
+        const char *close = strchr(paren, ')');
+        if (!close || (size_t)(close - paren - 1) >= sizeof(reg))
+            die("bad memory operand", s);
+        memcpy(reg, paren + 1, close - paren - 1);
+        reg[close - paren - 1] = '\0';
+
+        insn->rs = parseGpr(reg);
+        insn->hasBase = 1;
+        if (n == 0)
+            insn->imm = 0;
+        else if (isImmediate(prefix))
+            insn->imm = parseImmediate(prefix);
+        else
+            insn->label = copyString(prefix, strlen(prefix));
+    }
+    else {
+        const char *plus = strchr(s, '+');
+        insn->hasBase = 0;
+        if (plus) {
+            insn->label = copyString(s, plus - s);
+            insn->imm = parseImmediate(plus + 1);
+        }
+        else {
+            insn->label = copyString(s, strlen(s));
+            insn->imm = 0;
+        }
+    }
+}
+
+
+static Insn *newInsn (void) {
+    if (textCount == textCapacity) {
+        textCapacity = textCapacity ? textCapacity * 2 : 1024;
+        text = (Insn *)realloc(text, textCapacity * sizeof(Insn));
+    }
+    Insn *insn = &text[textCount++];
+    memset(insn, 0, sizeof(Insn));
+    insn->asmLine = asmLineNumber;
+    insn->srcLine = srcLine;
+    insn->function = currentFunction;
+    insn->target = -1;
+    insn->cost = 1;
+    return insn;
+}
+
+
+// split "a, b, c" into at most 4 operands; returns the operand count
+static int splitOperands (char *s, char **ops) {
+    int n = 0;
+    while (*s && n < 4) {
+        while (isspace((unsigned char)*s) || *s == ',')
+            ++s;
+        if (!*s)
+            break;
+        ops[n++] = s;
+        while (*s && *s != ',' && !isspace((unsigned char)*s))
+            ++s;
+        if (*s)
+            *s++ = '\0';
+    }
+    return n;
+}
+
+
+static void assembleInstruction (const char *mnemonic, char *operands) {
+    const MnemonicInfo *info = mnemonics;
+    while (info->name && strcmp(info->name, mnemonic) != 0)
+        ++info;
+    if (!info->name)
+        die("unknown instruction", mnemonic);
+
+    char *ops[4] = {NULL, NULL, NULL, NULL};
+    int n = splitOperands(operands, ops);
+    Insn *insn = newInsn();
+    insn->op = info->op;
+
+#define NEED(k) do { if (n < (k)) die("missing operand for", mnemonic); } while (0)
+
+    switch (insn->op) {
+        // three-register or register-register-immediate arithmetic;
+        // SPIM accepts `add $d, $s, C` as a pseudo for addi
+        case M_ADD: case M_ADDU: case M_SUB: case M_SUBU:
+        case M_AND: case M_OR: case M_XOR: case M_NOR:
+        case M_SLT: case M_SLTU: case M_SEQ: case M_SNE:
+        case M_MUL: case M_REM: case M_SLLV: case M_SRLV:
+        case M_ADDI: case M_ADDIU: case M_ANDI: case M_ORI: case M_XORI: case M_SLTI: case M_SLTIU:
+            NEED(2);
+            insn->rd = parseGpr(ops[0]);
+            // `xori $t, C` is short for `xori $t, $t, C`
+            if (n == 2) {
+                ops[2] = ops[1];
+                ops[1] = ops[0];
+            }
+            insn->rs = parseGpr(ops[1]);
+            if (isImmediate(ops[2])) {
+                insn->imm = parseImmediate(ops[2]);
+                insn->rt = -1;
+                if (!fitsInHalf(insn->imm))
+                    insn->cost = 3;
+                else if (insn->op == M_ADD || insn->op == M_ADDU || insn->op == M_SUB || insn->op == M_SUBU ||
+                         insn->op == M_AND || insn->op == M_OR || insn->op == M_XOR || insn->op == M_SLT)
+                    insn->cost = (insn->op == M_SUB || insn->op == M_SUBU) ? 2 : 1;
+            }
+            else {
+                insn->rt = parseGpr(ops[2]);
+            }
+            if (insn->op == M_MUL || insn->op == M_REM || insn->op == M_SEQ || insn->op == M_SNE)
+                insn->cost = 2;
+            break;
+
+        case M_SLL: case M_SRL: case M_SRA:
+            NEED(3);
+            insn->rd = parseGpr(ops[0]);
+            insn->rs = parseGpr(ops[1]);
+            insn->imm = parseImmediate(ops[2]) & 31;
+            break;
+
+        case M_MULT: case M_MULTU: case M_DIV: case M_DIVU:
+            NEED(2);
+            insn->rs = parseGpr(ops[0]);
+            insn->rt = parseGpr(ops[1]);
+            break;
+
+        case M_MFHI: case M_MFLO: case M_JR:
+            NEED(1);
+            insn->rd = parseGpr(ops[0]);
+            break;
+
+        case M_JALR:
+            NEED(1);
+            insn->rd = parseGpr(ops[0]);
+            break;
+
+        case M_NOT: case M_NEG: case M_MOVE:
+            NEED(2);
+            insn->rd = parseGpr(ops[0]);
+            insn->rs = parseGpr(ops[1]);
+            break;
+
+        case M_LW: case M_SW: case M_LB: case M_LBU: case M_SB:
+            NEED(2);
+            insn->rd = parseGpr(ops[0]);
+            parseMemOperand(insn, ops[1]);
+            if (insn->label)
+                insn->cost = 2;
+            break;
+
+        case M_LS: case M_SS:
+            NEED(2);
+            insn->rd = parseFpr(ops[0]);
+            parseMemOperand(insn, ops[1]);
+            if (insn->label)
+                insn->cost = 2;
+            break;
+
+        case M_LI: case M_LUI:
+            NEED(2);
+            insn->rd = parseGpr(ops[0]);
+            insn->imm = parseImmediate(ops[1]);
+            if (insn->op == M_LI && !fitsInHalf(insn->imm) && (insn->imm & 0xffff) != 0)
+                insn->cost = 2;
+            break;
+
+        case M_LA:
+            NEED(2);
+            insn->rd = parseGpr(ops[0]);
+            parseMemOperand(insn, ops[1]);
+            insn->cost = 2;
+            break;
+
+        case M_LIS:
+            NEED(2);
+            insn->rd = parseFpr(ops[0]);
+            insn->fimm = strtof(ops[1], NULL);
+            insn->cost = 3;
+            break;
+
+        case M_BEQ: case M_BNE: case M_BLT: case M_BGT: case M_BLE: case M_BGE:
+            NEED(3);
+            insn->rs = parseGpr(ops[0]);
+            if (isImmediate(ops[1])) {
+                insn->rt = -1;
+                insn->imm = parseImmediate(ops[1]);
+                insn->cost = 2;
+            }
+            else {
+                insn->rt = parseGpr(ops[1]);
+            }
+            insn->label = copyString(ops[2], strlen(ops[2]));
+            if (insn->op != M_BEQ && insn->op != M_BNE)
+                insn->cost = 2;
+            break;
+
+        case M_BEQZ: case M_BNEZ: case M_BLEZ: case M_BGTZ: case M_BLTZ: case M_BGEZ:
+            NEED(2);
+            insn->rs = parseGpr(ops[0]);
+            insn->label = copyString(ops[1], strlen(ops[1]));
+            break;
+
+        case M_B: case M_J: case M_JAL: case M_BC1T: case M_BC1F:
+            NEED(1);
+            insn->label = copyString(ops[0], strlen(ops[0]));
+            break;
+
+        case M_SYSCALL: case M_NOP:
+            break;
+
+        case M_MOVS: case M_NEGS: case M_ABSS: case M_CVTSW: case M_CVTWS:
+            NEED(2);
+            insn->rd = parseFpr(ops[0]);
+            insn->rs = parseFpr(ops[1]);
+            break;
+
+        case M_MTC1: case M_MFC1:
+            NEED(2);
+            insn->rd = parseGpr(ops[0]);
+            insn->rs = parseFpr(ops[1]);
+            break;
+
+        case M_ADDS: case M_SUBS: case M_MULS: case M_DIVS:
+            NEED(3);
+            insn->rd = parseFpr(ops[0]);
+            insn->rs = parseFpr(ops[1]);
+            insn->rt = parseFpr(ops[2]);
+            break;
+
+        case M_CEQS: case M_CLTS: case M_CLES:
+            NEED(2);
+            insn->rs = parseFpr(ops[0]);
+            insn->rt = parseFpr(ops[1]);
+            break;
+    }
+
+#undef NEED
+}
+
+
+// parse the body of an .asciiz directive: "..." with C escapes
+static void assembleString (const char *s) {
+    while (isspace((unsigned char)*s))
+        ++s;
+    if (*s != '"')
+        die("expected a string literal", s);
+    ++s;
+
+    while (*s && *s != '"') {
+        char c = *s++;
+        if (c == '\\') {
+            switch (*s++) {
+                case 'n':  c = '\n'; break;
+                case 't':  c = '\t'; break;
+                case 'r':  c = '\r'; break;
+                case '0':  c = '\0'; break;
+                case '\\': c = '\\'; break;
+                case '"':  c = '"';  break;
+                default:   c = s[-1]; break;
+            }
+        }
+        dataEmit(&c, 1);
+    }
+    dataEmit("", 1);
+}
+
+
+static void assembleDirective (const char *directive, char *rest, int *inText) {
+    if (strcmp(directive, ".data") == 0) {
+        *inText = 0;
+    }
+    else if (strcmp(directive, ".text") == 0) {
+        *inText = 1;
+    }
+    else if (strcmp(directive, ".globl") == 0 || strcmp(directive, ".extern") == 0) {
+        // nothing to do, everything is in one file
+    }
+    else if (strcmp(directive, ".word") == 0) {
+        char *ops[4];
+        int n = splitOperands(rest, ops);
+        int i;
+        dataAlign(4);
+        for (i = 0; i < n; ++i) {
+            int32_t v = parseImmediate(ops[i]);
+            dataEmit(&v, 4);
+        }
+    }
+    else if (strcmp(directive, ".float") == 0) {
+        char *ops[4];
+        int n = splitOperands(rest, ops);
+        int i;
+        dataAlign(4);
+        for (i = 0; i < n; ++i) {
+            float f = strtof(ops[i], NULL);
+            dataEmit(&f, 4);
+        }
+    }
+    else if (strcmp(directive, ".space") == 0) {
+        uint32_t n = parseImmediate(rest);
+        dataReserve(n);
+        memset(dataSeg + dataSize, 0, n);
+        dataSize += n;
+    }
+    else if (strcmp(directive, ".align") == 0) {
+        dataAlign(1u << parseImmediate(rest));
+    }
+    else if (strcmp(directive, ".asciiz") == 0) {
+        assembleString(rest);
+    }
+    else if (strcmp(directive, ".ascii") == 0) {
+        assembleString(rest);
+        --dataSize;
+    }
+    else {
+        die("unknown directive", directive);
+    }
+}
+
+
+static int addFunction (const char *name) {
+    int i;
+    for (i = 0; i < functionCount; ++i)
+        if (strcmp(functionNames[i], name) == 0)
+            return i;
+
+    functionNames = (char **)realloc(functionNames, (functionCount + 1) * sizeof(char *));
+    functionNames[functionCount] = copyString(name, strlen(name));
+    return functionCount++;
+}
+
+
+// codegen's `# [At: N]: what` annotations map the instructions after them
+// to source line N. a function's code starts at its "before f( ... )"
+// annotation and gets its name from the `_begin_<fn>` label after the
+// prologue, the runtime routines after the "end" annotation belong to
+// "(runtime)"
+static void readAnnotation (const char *line) {
+    int n, offset = 0;
+
+    if (sscanf(line, " # [At: %d]: %n", &n, &offset) != 1 || offset == 0)
+        return;
+
+    srcLine = n;
+    if (strncmp(line + offset, "before f(", 9) == 0) {
+        functionStart = textCount;
+        currentFunction = -1;
+    }
+    else if (strcmp(line + offset, "end\n") == 0 || strcmp(line + offset, "end") == 0) {
+        srcLine = 0;
+        currentFunction = addFunction("(runtime)");
+    }
+}
+
+
+static void beginFunction (const char *name) {
+    int i;
+
+    currentFunction = addFunction(name);
+    for (i = functionStart; i < textCount; ++i)
+        text[i].function = currentFunction;
+}
+
+
+// strip a trailing `# comment` that is not inside a string literal
+static void stripComment (char *line) {
+    int inString = 0;
+    for (; *line; ++line) {
+        if (*line == '"' && (line[-1] != '\\'))
+            inString = !inString;
+        else if (*line == '#' && !inString) {
+            *line = '\0';
+            return;
+        }
+    }
+}
+
+
+void mipsimLoad (const char *fileName) {
+    FILE *F = fopen(fileName, "r");
+    if (!F) {
+        fprintf(stderr, "mipsim: cannot open '%s'\n", fileName);
+        exit(2);
+    }
+    asmFileName = fileName;
+
+    char buf[8192];
+    int inText = 1;
+
+    while (fgets(buf, sizeof(buf), F)) {
+        ++asmLineNumber;
+        readAnnotation(buf);
+        stripComment(buf);
+
+        char *s = buf;
+        while (isspace((unsigned char)*s))
+            ++s;
+
+        // labels, possibly followed by a directive or an instruction
+        for (;;) {
+            char *colon = s;
+            while (*colon && (isalnum((unsigned char)*colon) || *colon == '_' || *colon == '.' || *colon == '$'))
+                ++colon;
+            if (colon == s || *colon != ':')
+                break;
+            *colon = '\0';
+            if (inText && strncmp(s, "_begin_", 7) == 0)
+                beginFunction(s + 7);
+            if (inText)
+                defineLabel(s, 1, textCount);
+            else
+                defineLabel(s, 0, DATA_BASE + dataSize);
+            s = colon + 1;
+            while (isspace((unsigned char)*s))
+                ++s;
+        }
+
+        if (!*s)
+            continue;
+
+        char *word = s;
+        while (*s && !isspace((unsigned char)*s))
+            ++s;
+        if (*s)
+            *s++ = '\0';
+
+        if (word[0] == '.') {
+            // `.word` right after a label has to be aligned before the label
+            // is bound, but the label was already defined above; SPIM only
+            // aligns in that case too when the preceding data is misaligned,
+            // which codegen never produces
+            assembleDirective(word, s, &inText);
+        }
+        else if (!inText) {
+            die("instruction in .data segment", word);
+        }
+        else {
+            assembleInstruction(word, s);
+        }
+    }
+    fclose(F);
+
+    // resolve label references
+    int i;
+    for (i = 0; i < textCount; ++i) {
+        Insn *insn = &text[i];
+        asmLineNumber = insn->asmLine;
+        if (!insn->label)
+            continue;
+
+        Label *l = findLabel(insn->label);
+        if (!l)
+            die("undefined label", insn->label);
+
+        switch (insn->op) {
+            case M_LW: case M_SW: case M_LB: case M_LBU: case M_SB:
+            case M_LS: case M_SS: case M_LA:
+                if (l->isText)
+                    insn->target = TEXT_BASE + 4 * l->value;
+                else
+                    insn->target = l->value;
+                break;
+
+            default:
+                if (!l->isText)
+                    die("branch to a data label", insn->label);
+                insn->target = l->value;
+                break;
+        }
+    }
+
+    heapBreak = dataSize;
+    dataReserve(HEAP_SIZE);
+    stackSeg = (uint8_t *)calloc(1, STACK_SIZE);
+}
+
+
+int mipsimEntry (const char *name) {
+    Label *l = findLabel(name);
+    if (!l || !l->isText)
+        return -1;
+    return l->value;
+}
+
+
+void mipsimSetCallHooks (MipsCallHook call, MipsReturnHook ret) {
+    callHook = call;
+    returnHook = ret;
+}
+
+
+int mipsimTextCount (void) {
+    return textCount;
+}
+
+
+void mipsimInsnInfo (int pc, MipsInsnInfo *info) {
+    const Insn *insn = &text[pc];
+
+    info->srcLine = insn->srcLine;
+    info->function = insn->function < 0 ? NULL : functionNames[insn->function];
+    info->executed = insn->executed;
+    info->cost = insn->cost;
+    info->isLoad = insn->op == M_LW || insn->op == M_LB || insn->op == M_LBU || insn->op == M_LS;
+    info->isStore = insn->op == M_SW || insn->op == M_SB || insn->op == M_SS;
+    info->isSyscall = insn->op == M_SYSCALL;
+}
+
+
+// syscalls
+
+static int doSyscall (void) {
+    ++mipsStats.syscalls;
+
+    switch (gpr[2]) {
+        case 1:
+            printf("%d", gpr[4]);
+            break;
+
+        case 2:
+            printf("%.8f", asFloat(fpr[12]));
+            break;
+
+        case 4: {
+            uint32_t addr = (uint32_t)gpr[4];
+            uint8_t *p = memAt(addr, 1);
+            uint8_t *end = dataSeg + heapBreak;
+            uint8_t *q = p;
+            // strings live in .data or on the stack
+            if (p >= dataSeg && p < end) {
+                while (q < end && *q)
+                    ++q;
+                fwrite(p, 1, q - p, stdout);
+            }
+            else {
+                while (*memAt(addr, 1))
+                    putchar(*memAt(addr++, 1));
+            }
+            break;
+        }
+
+        case 5: {
+            int v = 0;
+            if (scanf("%d", &v) != 1)
+                v = 0;
+            gpr[2] = v;
+            break;
+        }
+
+        case 6: {
+            float f = 0;
+            if (scanf("%f", &f) != 1)
+                f = 0;
+            fpr[0] = asBits(f);
+            break;
+        }
+
+        case 8: {
+            // read up to $a1 - 1 bytes like SPIM: stop after a newline, which
+            // is kept, so a reader gets at most one line per syscall
+            uint32_t addr = (uint32_t)gpr[4];
+            int32_t len = gpr[5];
+            int32_t n = 0;
+            if (len > 0) {
+                uint8_t *p = memAt(addr, len);
+                int c = 0;
+                while (n < len - 1 && c != '\n' && (c = getchar()) != EOF)
+                    p[n++] = (uint8_t)c;
+                p[n] = '\0';
+            }
+            gpr[2] = n;
+            break;
+        }
+
+        case 9: {
+            uint32_t addr = DATA_BASE + heapBreak;
+            uint32_t n = ((uint32_t)gpr[4] + 3) & ~3u;
+            if (heapBreak + n > dataSize + HEAP_SIZE) {
+                fprintf(stderr, "mipsim: out of heap\n");
+                exit(2);
+            }
+            heapBreak += n;
+            gpr[2] = (int32_t)addr;
+            break;
+        }
+
+        case 10:
+            return 0;
+
+        case 11:
+            putchar(gpr[4] & 0xff);
+            break;
+
+        case 17:
+            return 0;
+
+        default:
+            fprintf(stderr, "mipsim: unsupported syscall %d\n", gpr[2]);
+            exit(2);
+    }
+    return 1;
+}
+
+
+// interpreter
+
+int mipsimRun (int entry) {
+    memset(gpr, 0, sizeof(gpr));
+    memset(fpr, 0, sizeof(fpr));
+    memset(&mipsStats, 0, sizeof(mipsStats));
+    gpr[28] = 0x10008000;
+    gpr[29] = STACK_TOP - 4;
+    gpr[31] = RA_SENTINEL;
+
+    int pc = entry;
+
+    while (pc >= 0 && pc < textCount) {
+        Insn *insn = &text[pc];
+        int next = pc + 1;
+        int32_t a, b;
+
+        mipsStats.instructions += insn->cost;
+        ++mipsStats.statements;
+        ++insn->executed;
+
+        switch (insn->op) {
+            case M_ADD: case M_ADDU: case M_ADDI: case M_ADDIU:
+                b = insn->rt < 0 ? insn->imm : gpr[insn->rt];
+                gpr[insn->rd] = (int32_t)((uint32_t)gpr[insn->rs] + (uint32_t)b);
+                break;
+
+            case M_SUB: case M_SUBU:
+                b = insn->rt < 0 ? insn->imm : gpr[insn->rt];
+                gpr[insn->rd] = (int32_t)((uint32_t)gpr[insn->rs] - (uint32_t)b);
+                break;
+
+            case M_AND: case M_ANDI:
+                b = insn->rt < 0 ? insn->imm : gpr[insn->rt];
+                if (insn->op == M_ANDI)
+                    b &= 0xffff;
+                gpr[insn->rd] = gpr[insn->rs] & b;
+                break;
+
+            case M_OR: case M_ORI:
+                b = insn->rt < 0 ? insn->imm : gpr[insn->rt];
+                if (insn->op == M_ORI)
+                    b &= 0xffff;
+                gpr[insn->rd] = gpr[insn->rs] | b;
+                break;
+
+            case M_XOR: case M_XORI:
+                b = insn->rt < 0 ? insn->imm : gpr[insn->rt];
+                if (insn->op == M_XORI)
+                    b &= 0xffff;
+                gpr[insn->rd] = gpr[insn->rs] ^ b;
+                break;
+
+            case M_NOR:
+                b = insn->rt < 0 ? insn->imm : gpr[insn->rt];
+                gpr[insn->rd] = ~(gpr[insn->rs] | b);
+                break;
+
+            case M_SLT: case M_SLTI:
+                b = insn->rt < 0 ? insn->imm : gpr[insn->rt];
+                gpr[insn->rd] = gpr[insn->rs] < b;
+                break;
+
+            case M_SLTU: case M_SLTIU:
+                b = insn->rt < 0 ? insn->imm : gpr[insn->rt];
+                gpr[insn->rd] = (uint32_t)gpr[insn->rs] < (uint32_t)b;
+                break;
+
+            case M_SEQ:
+                b = insn->rt < 0 ? insn->imm : gpr[insn->rt];
+                gpr[insn->rd] = gpr[insn->rs] == b;
+                break;
+
+            case M_SNE:
+                b = insn->rt < 0 ? insn->imm : gpr[insn->rt];
+                gpr[insn->rd] = gpr[insn->rs] != b;
+                break;
+
+            case M_MUL:
+                b = insn->rt < 0 ? insn->imm : gpr[insn->rt];
+                gpr[insn->rd] = (int32_t)((int64_t)gpr[insn->rs] * b);
+                break;
+
+            case M_REM:
+                b = insn->rt < 0 ? insn->imm : gpr[insn->rt];
+                gpr[insn->rd] = b ? gpr[insn->rs] % b : 0;
+                break;
+
+            case M_SLLV:
+                gpr[insn->rd] = (int32_t)((uint32_t)gpr[insn->rs] << (gpr[insn->rt] & 31));
+                break;
+
+            case M_SRLV:
+                gpr[insn->rd] = (int32_t)((uint32_t)gpr[insn->rs] >> (gpr[insn->rt] & 31));
+                break;
+
+            case M_SLL:
+                gpr[insn->rd] = (int32_t)((uint32_t)gpr[insn->rs] << insn->imm);
+                break;
+
+            case M_SRL:
+                gpr[insn->rd] = (int32_t)((uint32_t)gpr[insn->rs] >> insn->imm);
+                break;
+
+            case M_SRA:
+                gpr[insn->rd] = gpr[insn->rs] >> insn->imm;
+                break;
+
+            case M_MULT: {
+                int64_t p = (int64_t)gpr[insn->rs] * gpr[insn->rt];
+                lo = (int32_t)p;
+                hi = (int32_t)(p >> 32);
+                break;
+            }
+
+            case M_MULTU: {
+                uint64_t p = (uint64_t)(uint32_t)gpr[insn->rs] * (uint32_t)gpr[insn->rt];
+                lo = (int32_t)p;
+                hi = (int32_t)(p >> 32);
+                break;
+            }
+
+            case M_DIV:
+                a = gpr[insn->rs];
+                b = gpr[insn->rt];
+                if (b != 0 && !(a == INT32_MIN && b == -1)) {
+                    lo = a / b;
+                    hi = a % b;
+                }
+                break;
+
+            case M_DIVU:
+                if (gpr[insn->rt] != 0) {
+                    lo = (int32_t)((uint32_t)gpr[insn->rs] / (uint32_t)gpr[insn->rt]);
+                    hi = (int32_t)((uint32_t)gpr[insn->rs] % (uint32_t)gpr[insn->rt]);
+                }
+                break;
+
+            case M_MFHI:
+                gpr[insn->rd] = hi;
+                break;
+
+            case M_MFLO:
+                gpr[insn->rd] = lo;
+                break;
+
+            case M_NOT:
+                gpr[insn->rd] = ~gpr[insn->rs];
+                break;
+
+            case M_NEG:
+                gpr[insn->rd] = -gpr[insn->rs];
+                break;
+
+            case M_MOVE:
+                gpr[insn->rd] = gpr[insn->rs];
+                break;
+
+            case M_LI:
+                gpr[insn->rd] = insn->imm;
+                break;
+
+            case M_LUI:
+                gpr[insn->rd] = (int32_t)((uint32_t)insn->imm << 16);
+                break;
+
+            case M_LA:
+                gpr[insn->rd] = insn->hasBase ? gpr[insn->rs] + insn->imm : insn->target + insn->imm;
+                break;
+
+            case M_LW:
+                ++mipsStats.loads;
+                a = insn->hasBase ? gpr[insn->rs] + insn->imm : insn->target + insn->imm;
+                if (insn->hasBase && insn->label)
+                    a += insn->target;
+                gpr[insn->rd] = loadWord((uint32_t)a);
+                break;
+
+            case M_SW:
+                ++mipsStats.stores;
+                a = insn->hasBase ? gpr[insn->rs] + insn->imm : insn->target + insn->imm;
+                if (insn->hasBase && insn->label)
+                    a += insn->target;
+                storeWord((uint32_t)a, gpr[insn->rd]);
+                break;
+
+            case M_LB: case M_LBU:
+                ++mipsStats.loads;
+                a = insn->hasBase ? gpr[insn->rs] + insn->imm : insn->target + insn->imm;
+                if (insn->hasBase && insn->label)
+                    a += insn->target;
+                if (insn->op == M_LB)
+                    gpr[insn->rd] = (int8_t)*memAt((uint32_t)a, 1);
+                else
+                    gpr[insn->rd] = *memAt((uint32_t)a, 1);
+                break;
+
+            case M_SB:
+                ++mipsStats.stores;
+                a = insn->hasBase ? gpr[insn->rs] + insn->imm : insn->target + insn->imm;
+                if (insn->hasBase && insn->label)
+                    a += insn->target;
+                *memAt((uint32_t)a, 1) = (uint8_t)gpr[insn->rd];
+                break;
+
+            case M_LS:
+                ++mipsStats.loads;
+                a = insn->hasBase ? gpr[insn->rs] + insn->imm : insn->target + insn->imm;
+                if (insn->hasBase && insn->label)
+                    a += insn->target;
+                fpr[insn->rd] = (uint32_t)loadWord((uint32_t)a);
+                break;
+
+            case M_SS:
+                ++mipsStats.stores;
+                a = insn->hasBase ? gpr[insn->rs] + insn->imm : insn->target + insn->imm;
+                if (insn->hasBase && insn->label)
+                    a += insn->target;
+                storeWord((uint32_t)a, (int32_t)fpr[insn->rd]);
+                break;
+
+            case M_BEQ: case M_BNE: case M_BLT: case M_BGT: case M_BLE: case M_BGE: {
+                int taken = 0;
+                a = gpr[insn->rs];
+                b = insn->rt < 0 ? insn->imm : gpr[insn->rt];
+                switch (insn->op) {
+                    case M_BEQ: taken = a == b; break;
+                    case M_BNE: taken = a != b; break;
+                    case M_BLT: taken = a <  b; break;
+                    case M_BGT: taken = a >  b; break;
+                    case M_BLE: taken = a <= b; break;
+                    default:    taken = a >= b; break;
+                }
+                ++mipsStats.branches;
+                if (taken) {
+                    ++mipsStats.branchesTaken;
+                    next = insn->target;
+                }
+                break;
+            }
+
+            case M_BEQZ: case M_BNEZ: case M_BLEZ: case M_BGTZ: case M_BLTZ: case M_BGEZ: {
+                int taken = 0;
+                a = gpr[insn->rs];
+                switch (insn->op) {
+                    case M_BEQZ: taken = a == 0; break;
+                    case M_BNEZ: taken = a != 0; break;
+                    case M_BLEZ: taken = a <= 0; break;
+                    case M_BGTZ: taken = a >  0; break;
+                    case M_BLTZ: taken = a <  0; break;
+                    default:     taken = a >= 0; break;
+                }
+                ++mipsStats.branches;
+                if (taken) {
+                    ++mipsStats.branchesTaken;
+                    next = insn->target;
+                }
+                break;
+            }
+
+            case M_BC1T: case M_BC1F:
+                ++mipsStats.branches;
+                if ((insn->op == M_BC1T) == (fcc != 0)) {
+                    ++mipsStats.branchesTaken;
+                    next = insn->target;
+                }
+                break;
+
+            case M_B: case M_J:
+                ++mipsStats.jumps;
+                next = insn->target;
+                break;
+
+            case M_JAL:
+                ++mipsStats.jumps;
+                ++mipsStats.calls;
+                gpr[31] = TEXT_BASE + 4 * (pc + 1);
+                next = insn->target;
+                if (callHook)
+                    callHook(insn->label);
+                break;
+
+            case M_JALR:
+                ++mipsStats.jumps;
+                ++mipsStats.calls;
+                a = gpr[insn->rd];
+                gpr[31] = TEXT_BASE + 4 * (pc + 1);
+                next = (a - TEXT_BASE) / 4;
+                if (callHook)
+                    callHook(NULL);
+                break;
+
+            case M_JR:
+                ++mipsStats.jumps;
+                a = gpr[insn->rd];
+                if (a == RA_SENTINEL)
+                    return gpr[2];
+                if (insn->rd == 31 && returnHook)
+                    returnHook();
+                if (a < TEXT_BASE || (a - TEXT_BASE) / 4 >= textCount) {
+                    fprintf(stderr, "mipsim: jump to bad address 0x%08x\n", (uint32_t)a);
+                    exit(2);
+                }
+                next = (a - TEXT_BASE) / 4;
+                break;
+
+            case M_SYSCALL:
+                if (!doSyscall())
+                    return gpr[2] == 17 ? gpr[4] : 0;
+                break;
+
+            case M_NOP:
+                break;
+
+            case M_LIS:
+                fpr[insn->rd] = asBits(insn->fimm);
+                break;
+
+            case M_MOVS:
+                fpr[insn->rd] = fpr[insn->rs];
+                break;
+
+            case M_MTC1:
+                fpr[insn->rs] = (uint32_t)gpr[insn->rd];
+                break;
+
+            case M_MFC1:
+                gpr[insn->rd] = (int32_t)fpr[insn->rs];
+                break;
+
+            case M_ADDS:
+                fpr[insn->rd] = asBits(asFloat(fpr[insn->rs]) + asFloat(fpr[insn->rt]));
+                break;
+
+            case M_SUBS:
+                fpr[insn->rd] = asBits(asFloat(fpr[insn->rs]) - asFloat(fpr[insn->rt]));
+                break;
+
+            case M_MULS:
+                fpr[insn->rd] = asBits(asFloat(fpr[insn->rs]) * asFloat(fpr[insn->rt]));
+                break;
+
+            case M_DIVS:
+                fpr[insn->rd] = asBits(asFloat(fpr[insn->rs]) / asFloat(fpr[insn->rt]));
+                break;
+
+            case M_NEGS:
+                fpr[insn->rd] = fpr[insn->rs] ^ 0x80000000u;
+                break;
+
+            case M_ABSS:
+                fpr[insn->rd] = fpr[insn->rs] & 0x7fffffffu;
+                break;
+
+            case M_CVTSW:
+                fpr[insn->rd] = asBits((float)(int32_t)fpr[insn->rs]);
+                break;
+
+            case M_CVTWS:
+                fpr[insn->rd] = (uint32_t)(int32_t)asFloat(fpr[insn->rs]);
+                break;
+
+            case M_CEQS:
+                fcc = asFloat(fpr[insn->rs]) == asFloat(fpr[insn->rt]);
+                break;
+
+            case M_CLTS:
+                fcc = asFloat(fpr[insn->rs]) < asFloat(fpr[insn->rt]);
+                break;
+
+            case M_CLES:
+                fcc = asFloat(fpr[insn->rs]) <= asFloat(fpr[insn->rt]);
+                break;
+        }
+        gpr[0] = 0;
+        pc = next;
+    }
+
+    fprintf(stderr, "mipsim: fell off the end of .text\n");
+    return 0;
+}
+
+
+int main (int argc, char *argv[]) {
+    int stats = 0;
+    const char *fileName = NULL;
+    const char *profileSource = NULL;
+    const char *foldedFile = NULL;
+    int i;
+    for (i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--stats") == 0)
+            stats = 1;
+        else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+            profileSource = argv[++i];
+        else if (strcmp(argv[i], "--folded") == 0 && i + 1 < argc)
+            foldedFile = argv[++i];
+        else
+            fileName = argv[i];
+    }
+    if (!fileName) {
+        fprintf(stderr, "usage: mipsim [--stats] [--profile source.c] [--folded out.folded] output.s\n");
+        return 2;
+    }
+    mipsimLoad(fileName);
+    int entry = mipsimEntry("main");
+    if (entry < 0) {
+        fprintf(stderr, "mipsim: no main\n");
+        return 2;
+    }
+    if (foldedFile)
+        startCallProfile("main");
+    mipsimRun(entry);
+    fflush(stdout);
+
+    // one "name value" pair per line, on stderr so that it doesn't mix with
+    // the program's output
+    if (stats) {
+        fprintf(stderr, "instructions %lld\n", mipsStats.instructions);
+        fprintf(stderr, "statements %lld\n", mipsStats.statements);
+        fprintf(stderr, "loads %lld\n", mipsStats.loads);
+        fprintf(stderr, "stores %lld\n", mipsStats.stores);
+        fprintf(stderr, "branches %lld\n", mipsStats.branches);
+        fprintf(stderr, "branches_taken %lld\n", mipsStats.branchesTaken);
+        fprintf(stderr, "jumps %lld\n", mipsStats.jumps);
+        fprintf(stderr, "calls %lld\n", mipsStats.calls);
+        fprintf(stderr, "syscalls %lld\n", mipsStats.syscalls);
+    }
+    if (profileSource)
+        printProfile(stderr, profileSource);
+    if (foldedFile) {
+        FILE *out = strcmp(foldedFile, "-") == 0 ? stdout : fopen(foldedFile, "w");
+        if (!out) {
+            fprintf(stderr, "mipsim: cannot open '%s'\n", foldedFile);
+            return 2;
+        }
+        writeFoldedStacks(out);
+        if (out != stdout)
+            fclose(out);
+    }
+    return 0;
+}
@@ -0,0 +1,45 @@
+#ifndef __MIPSIM_H__
+#define __MIPSIM_H__
+
+#include <stdint.h>
+
+typedef struct MipsStats {
+    long long instructions;     // after pseudo-instruction expansion
+    long long statements;       // assembly lines executed
+    long long loads;
+    long long stores;
+    long long branches;
+    long long branchesTaken;
+    long long jumps;
+    long long calls;
+    long long syscalls;
+} MipsStats;
+
+// what the profiler knows about one instruction
+typedef struct MipsInsnInfo {
+    int srcLine;                // from `# [At: N]`, 0 if there is none
+    const char *function;       // from `_begin_<fn>`, NULL outside functions
+    long long executed;
+    int cost;
+    int isLoad;
+    int isStore;
+    int isSyscall;
+} MipsInsnInfo;
+
+// called by mipsimRun() at every jal / jalr with the callee's label (NULL
+// for jalr) and at every jr $ra
+typedef void (*MipsCallHook) (const char *callee);
+typedef void (*MipsReturnHook) (void);
+
+extern MipsStats mipsStats;
+
+void mipsimLoad (const char *fileName);
+int mipsimEntry (const char *name);
+int mipsimRun (int entry);
+
+void mipsimSetCallHooks (MipsCallHook call, MipsReturnHook ret);
+
+int mipsimTextCount (void);
+void mipsimInsnInfo (int pc, MipsInsnInfo *info);
+
+#endif // __MIPSIM_H__
@@ -7,109 +7,20 @@
 #include <stdarg.h>
 #include "header.h"
 #include "symbolTable.h"
-#include "codegen.h"
-
-int linenumber = 1;
-AST_NODE *prog;
-
-extern int g_anyErrorOccur;
-
-static inline AST_NODE *makeSibling (AST_NODE *a, AST_NODE *b) {
-    while (a->rightSibling) {
-        a = a->rightSibling;
-    }
-    if (b == NULL) {
-        return a;
-    }
-    b = b->leftmostSibling;
-    a->rightSibling = b;
-
-    b->leftmostSibling = a->leftmostSibling;
-    b->parent = a->parent;
-    while (b->rightSibling) {
-        b = b->rightSibling;
-        b->leftmostSibling = a->leftmostSibling;
-        b->parent = a->parent;
-    }
-    return b;
-}
-
-
-static inline AST_NODE *makeChild (AST_NODE *parent, AST_NODE *child) {
-    if (child == NULL) {
-        return parent;
-    }
-    if (parent->child) {
-        makeSibling(parent->child, child);
-    }
-    else {
-        child = child->leftmostSibling;
-        parent->child = child;
-        while (child) {
-            child->parent = parent;
-            child = child->rightSibling;
-        }
-    }
-    return parent;
-}
-
-
-static AST_NODE *makeFamily(AST_NODE *parent, int childrenCount, ...) {
-    va_list childrenList;
-    va_start(childrenList, childrenCount);
-    AST_NODE *child = va_arg(childrenList, AST_NODE *);
-    makeChild(parent, child);
-    AST_NODE *tmp = child;
-    int index = 1;
-    for (index = 1; index < childrenCount; ++index) {
-        child = va_arg(childrenList, AST_NODE *);
-        tmp = makeSibling(tmp, child);
-    }
-    va_end(childrenList);
-    return parent;
-}
-
-
-static inline AST_NODE *makeIDNode(char *lexeme, IDENTIFIER_KIND idKind) {
-    AST_NODE *identifier = Allocate(IDENTIFIER_NODE);
-    identifier->semantic_value.identifierSemanticValue.identifierName = lexeme;
-    identifier->semantic_value.identifierSemanticValue.kind = idKind;
-    identifier->semantic_value.identifierSemanticValue.symbolTableEntry = NULL;
-    return identifier;
-}
-
-
-static inline AST_NODE *makeStmtNode(STMT_KIND stmtKind) {
-    AST_NODE *stmtNode = Allocate(STMT_NODE);
-    stmtNode->semantic_value.stmtSemanticValue.kind = stmtKind;
-    return stmtNode;
-}
-
-
-static inline AST_NODE *makeDeclNode(DECL_KIND declKind) {
-    AST_NODE *declNode = Allocate(DECLARATION_NODE);
-    declNode->semantic_value.declSemanticValue.kind = declKind;
-    return declNode;
-}
-
-static inline AST_NODE *makeExprNode(EXPR_KIND exprKind, int operationEnumValue) {
-    AST_NODE *exprNode = Allocate(EXPR_NODE);
-    exprNode->semantic_value.exprSemanticValue.isConstEval = 0;
-    exprNode->semantic_value.exprSemanticValue.kind = exprKind;
-    if (exprKind == BINARY_OPERATION) {
-        exprNode->semantic_value.exprSemanticValue.op.binaryOp = operationEnumValue;
-    }
-    else if (exprKind == UNARY_OPERATION) {
-        exprNode->semantic_value.exprSemanticValue.op.unaryOp = operationEnumValue;
-    }
-    else {
-        printf("Error in makeExprNode(EXPR_KIND exprKind, int operationEnumValue)\n");
-    }
-    return exprNode;
-}
-
+#include "passTimer.h"
+#include "astBuilder.h"
+#include "descentParser.h"
+#include "compilerContext.h"
+#include "batch.h"
+#include "server.h"
 %}
 
+// reentrant: the parser, like the scanner, keeps its state in yyparse()'s
+// frame and in the context it is given
+%define api.pure full
+%parse-param {CompilerContext *ctx}
+%lex-param {CompilerContext *ctx}
+
 
 
 %union {
@@ -118,6 +29,11 @@ static inline AST_NODE *makeExprNode(EXPR_KIND exprKind, int operationEnumValue)
     AST_NODE  *node;
 };
 
+%code {
+int yylex (YYSTYPE *value, CompilerContext *ctx);
+int yyerror (CompilerContext *ctx, const char *mesg);
+}
+
 %token <lexeme>ID
 %token <const1>CONST
 %token VOID
@@ -167,8 +83,8 @@ static inline AST_NODE *makeExprNode(EXPR_KIND exprKind, int operationEnumValue)
 
 /* Productions */               /* Semantic actions */
 program
-    : global_decl_list                 { $$ = Allocate(PROGRAM_NODE); makeChild($$, $1); prog = $$;}
-    |                                  { $$ = Allocate(PROGRAM_NODE); prog = $$; }
+    : global_decl_list                 { $$ = Allocate(ctx, PROGRAM_NODE); makeChild($$, $1); ctx->prog = $$;}
+    |                                  { $$ = Allocate(ctx, PROGRAM_NODE); ctx->prog = $$; }
     ;
 
 
@@ -178,7 +94,7 @@ global_decl_list
     ;
 
 global_decl
-    : decl_list function_decl          { $$ = makeSibling(makeChild(Allocate(VARIABLE_DECL_LIST_NODE), $1), $2); }
+    : decl_list function_decl          { $$ = makeSibling(makeChild(Allocate(ctx, VARIABLE_DECL_LIST_NODE), $1), $2); }
     | function_decl                    { $$ = $1; }
     ;
 
@@ -195,20 +111,20 @@ function_head
     : type ID
         {
             // xatier the new version abstrct `function_head` (type ID) from `function_decl`
-            $$ = makeDeclNode(FUNCTION_DECL);
-            makeFamily($$, 2, $1, makeIDNode($2, NORMAL_ID));
+            $$ = makeDeclNode(ctx, FUNCTION_DECL);
+            makeFamily($$, 2, $1, makeIDNode(ctx, $2, NORMAL_ID));
         }
     | VOID ID
         {
-            $$ = makeDeclNode(FUNCTION_DECL);
-            AST_NODE *voidNode = makeIDNode("void", NORMAL_ID);
-            makeFamily($$, 2, voidNode, makeIDNode($2, NORMAL_ID));
+            $$ = makeDeclNode(ctx, FUNCTION_DECL);
+            AST_NODE *voidNode = makeIDNode(ctx, ctx->internedVoid, NORMAL_ID);
+            makeFamily($$, 2, voidNode, makeIDNode(ctx, $2, NORMAL_ID));
         }
     | ID ID
         {
-            $$ = makeDeclNode(FUNCTION_DECL);
-            AST_NODE *idNode = makeIDNode($1, NORMAL_ID);
-            makeFamily($$, 2, idNode, makeIDNode($2, NORMAL_ID));
+            $$ = makeDeclNode(ctx, FUNCTION_DECL);
+            AST_NODE *idNode = makeIDNode(ctx, $1, NORMAL_ID);
+            makeFamily($$, 2, idNode, makeIDNode(ctx, $2, NORMAL_ID));
         }
     ;
 
@@ -216,12 +132,12 @@ opt_param_list
     : param_list
         {
             // xatier: parameter list is optional
-            $$ = Allocate(PARAM_LIST_NODE);
+            $$ = Allocate(ctx, PARAM_LIST_NODE);
             makeChild($$, $1);
         }
     |
         {
-            $$ = Allocate(PARAM_LIST_NODE);
+            $$ = Allocate(ctx, PARAM_LIST_NODE);
         }
     ;
 
@@ -233,28 +149,28 @@ param_list
 param
     : type ID
         {
-            $$ = makeDeclNode(FUNCTION_PARAMETER_DECL);
-            makeFamily($$, 2, $1, makeIDNode($2, NORMAL_ID));
+            $$ = makeDeclNode(ctx, FUNCTION_PARAMETER_DECL);
+            makeFamily($$, 2, $1, makeIDNode(ctx, $2, NORMAL_ID));
         }
     | ID ID
         {
             // xatier: from TA's hw4 tarball
-            $$ = makeDeclNode(FUNCTION_PARAMETER_DECL);
-            makeFamily($$, 2, makeIDNode($1, NORMAL_ID), makeIDNode($2, NORMAL_ID));
+            $$ = makeDeclNode(ctx, FUNCTION_PARAMETER_DECL);
+            makeFamily($$, 2, makeIDNode(ctx, $1, NORMAL_ID), makeIDNode(ctx, $2, NORMAL_ID));
         }
     | type ID dim_fn
         {
             //jyhsu
-            $$ = makeDeclNode(FUNCTION_PARAMETER_DECL);
-            AST_NODE *idnode = makeIDNode($2, ARRAY_ID);
+            $$ = makeDeclNode(ctx, FUNCTION_PARAMETER_DECL);
+            AST_NODE *idnode = makeIDNode(ctx, $2, ARRAY_ID);
             makeChild(idnode, $3);
             makeFamily($$, 2, $1, idnode);
         }
     | ID ID dim_fn
         {
             // xatier: from TA's hw4 tarball
-            $$ = makeDeclNode(FUNCTION_PARAMETER_DECL);
-            makeFamily($$, 2, makeIDNode($1, NORMAL_ID), makeChild(makeIDNode($2, ARRAY_ID), $3));
+            $$ = makeDeclNode(ctx, FUNCTION_PARAMETER_DECL);
+            makeFamily($$, 2, makeIDNode(ctx, $1, NORMAL_ID), makeChild(makeIDNode(ctx, $2, ARRAY_ID), $3));
         }
     ;
 
@@ -265,32 +181,32 @@ dim_fn
 
 expr_null
     : expr                             { $$ = $1; }        //jyhsu
-    |                                  { $$ = Allocate(NUL_NODE); }
+    |                                  { $$ = Allocate(ctx, NUL_NODE); }
     ;
 
 block
     : decl_list stmt_list
         {
             //jyhsu
-            $$ = Allocate(BLOCK_NODE);
-            AST_NODE *declnode = makeChild(Allocate(VARIABLE_DECL_LIST_NODE), $1);
-            AST_NODE *stmtnode = makeChild(Allocate(STMT_LIST_NODE), $2);
+            $$ = Allocate(ctx, BLOCK_NODE);
+            AST_NODE *declnode = makeChild(Allocate(ctx, VARIABLE_DECL_LIST_NODE), $1);
+            AST_NODE *stmtnode = makeChild(Allocate(ctx, STMT_LIST_NODE), $2);
             makeFamily($$, 2, declnode, stmtnode);
         }
     | stmt_list
         {
-            $$ = Allocate(BLOCK_NODE);
-            makeChild($$, makeChild(Allocate(STMT_LIST_NODE), $1));
+            $$ = Allocate(ctx, BLOCK_NODE);
+            makeChild($$, makeChild(Allocate(ctx, STMT_LIST_NODE), $1));
         }
     | decl_list
         {
-            $$ = Allocate(BLOCK_NODE);
-            makeChild($$, makeChild(Allocate(VARIABLE_DECL_LIST_NODE), $1));
+            $$ = Allocate(ctx, BLOCK_NODE);
+            makeChild($$, makeChild(Allocate(ctx, VARIABLE_DECL_LIST_NODE), $1));
         }
     |
         {
             //jyhsu
-            $$ = Allocate(BLOCK_NODE);
+            $$ = Allocate(ctx, BLOCK_NODE);
         }
     ;
 
@@ -308,14 +224,14 @@ type_decl
     : TYPEDEF type id_list MK_SEMICOLON
         {
            //jyhsu
-           $$ = makeDeclNode(TYPE_DECL);
+           $$ = makeDeclNode(ctx, TYPE_DECL);
            makeFamily($$, 2, $2, $3);
         }
     | TYPEDEF VOID id_list MK_SEMICOLON
         {
             //jyhsu
-            $$ = makeDeclNode(TYPE_DECL);
-            AST_NODE *voidtype = makeIDNode("void", NORMAL_ID);
+            $$ = makeDeclNode(ctx, TYPE_DECL);
+            AST_NODE *voidtype = makeIDNode(ctx, ctx->internedVoid, NORMAL_ID);
             makeFamily($$, 2, voidtype, $3);
         }
     ;
@@ -324,41 +240,41 @@ var_decl
     : type init_id_list MK_SEMICOLON
         {
             //jyhsu
-            $$ = makeDeclNode(VARIABLE_DECL);
+            $$ = makeDeclNode(ctx, VARIABLE_DECL);
             makeFamily($$, 2, $1, $2);
         }
     | ID init_id_list MK_SEMICOLON
         {
             //jyhsu
-            $$ = makeDeclNode(VARIABLE_DECL);
-            makeFamily($$, 2, makeIDNode($1, NORMAL_ID), $2);
+            $$ = makeDeclNode(ctx, VARIABLE_DECL);
+            makeFamily($$, 2, makeIDNode(ctx, $1, NORMAL_ID), $2);
         }
     ;
 
 type
-    : INT                              { $$ = makeIDNode("int", NORMAL_ID); }
-    | FLOAT                            { $$ = makeIDNode("float", NORMAL_ID); }
+    : INT                              { $$ = makeIDNode(ctx, ctx->internedInt, NORMAL_ID); }
+    | FLOAT                            { $$ = makeIDNode(ctx, ctx->internedFloat, NORMAL_ID); }
     ;
 
 id_list
-    : ID                               { $$ = makeIDNode($1, NORMAL_ID); }
+    : ID                               { $$ = makeIDNode(ctx, $1, NORMAL_ID); }
     | id_list MK_COMMA ID
         {
             //jyhsu
-            AST_NODE *idnode =  makeIDNode($3, NORMAL_ID);
+            AST_NODE *idnode =  makeIDNode(ctx, $3, NORMAL_ID);
             $$ = makeSibling($1, idnode);
         }
     | id_list MK_COMMA ID dim_decl
         {
             //jyhsu
-            AST_NODE *arraynode = makeIDNode($3, ARRAY_ID);
+            AST_NODE *arraynode = makeIDNode(ctx, $3, ARRAY_ID);
             makeChild(arraynode, $4);
             $$ = makeSibling($1, arraynode);
         }
     | ID dim_decl
         {
             //jyhsu
-            $$ = makeIDNode($1, ARRAY_ID);
+            $$ = makeIDNode(ctx, $1, ARRAY_ID);
             makeChild($$, $2);
         }
     ;
@@ -377,13 +293,13 @@ dim_decl
 cexpr
     : cexpr OP_PLUS mcexpr
         {
-            $$ = makeExprNode(BINARY_OPERATION, BINARY_OP_ADD);
+            $$ = makeExprNode(ctx, BINARY_OPERATION, BINARY_OP_ADD);
             makeFamily($$, 2, $1, $3);
         } /* This is for array declarations */
     | cexpr OP_MINUS mcexpr
         {
             //jyhsu
-            $$ = makeExprNode(BINARY_OPERATION, BINARY_OP_SUB);
+            $$ = makeExprNode(ctx, BINARY_OPERATION, BINARY_OP_SUB);
             makeFamily($$, 2, $1, $3);
         }
     | mcexpr                           { $$ = $1; }        //jyhsu
@@ -393,13 +309,13 @@ mcexpr
     : mcexpr OP_TIMES cfactor
         {
             //jyhsu
-            $$ = makeExprNode(BINARY_OPERATION, BINARY_OP_MUL);
+            $$ = makeExprNode(ctx, BINARY_OPERATION, BINARY_OP_MUL);
             makeFamily($$, 2, $1, $3);
         }
     | mcexpr OP_DIVIDE cfactor
         {
             //jyhsu
-            $$ = makeExprNode(BINARY_OPERATION, BINARY_OP_DIV);
+            $$ = makeExprNode(ctx, BINARY_OPERATION, BINARY_OP_DIV);
             makeFamily($$, 2, $1, $3);
         }
     | cfactor                          { $$ = $1; }        //jyhsu
@@ -408,7 +324,7 @@ cfactor
     : CONST
         {
             //jyhsu
-            $$ = Allocate(CONST_VALUE_NODE);
+            $$ = Allocate(ctx, CONST_VALUE_NODE);
             $$->semantic_value.const1 = $1;
         }
     | MK_LPAREN cexpr MK_RPAREN        { $$ = $2; }        //jyhsu
@@ -420,17 +336,17 @@ init_id_list
     ;
 
 init_id
-    : ID                               { $$ = makeIDNode($1, NORMAL_ID); }
+    : ID                               { $$ = makeIDNode(ctx, $1, NORMAL_ID); }
     | ID dim_decl
         {
             //jyhsu
-            AST_NODE* arraynode = makeIDNode($1, ARRAY_ID);
+            AST_NODE* arraynode = makeIDNode(ctx, $1, ARRAY_ID);
             $$ = makeChild(arraynode, $2);
         }
     | ID OP_ASSIGN relop_expr
         {
             //jyhsu
-            $$ = makeIDNode($1, WITH_INIT_ID);
+            $$ = makeIDNode(ctx, $1, WITH_INIT_ID);
             makeChild($$, $3);
         }
     ;
@@ -451,44 +367,44 @@ stmt
     | WHILE MK_LPAREN test MK_RPAREN stmt
         {
             // xatier
-            $$ = makeStmtNode(WHILE_STMT);
+            $$ = makeStmtNode(ctx, WHILE_STMT);
             makeFamily($$, 2, $3, $5);
         }
     | FOR MK_LPAREN assign_expr_list MK_SEMICOLON relop_expr_list MK_SEMICOLON assign_expr_list MK_RPAREN stmt
         {
             // xatier
-            $$ = makeStmtNode(FOR_STMT);
+            $$ = makeStmtNode(ctx, FOR_STMT);
             makeFamily($$, 4, $3, $5, $7, $9);
         }
     | var_ref OP_ASSIGN relop_expr MK_SEMICOLON
         {
             // xatier
-            $$ = makeStmtNode(ASSIGN_STMT);
+            $$ = makeStmtNode(ctx, ASSIGN_STMT);
             makeFamily($$, 2, $1, $3);
         }
     | IF MK_LPAREN test MK_RPAREN stmt
         {
-            $$ = makeStmtNode(IF_STMT);
-            makeFamily($$, 3, $3, $5, Allocate(NUL_NODE));
+            $$ = makeStmtNode(ctx, IF_STMT);
+            makeFamily($$, 3, $3, $5, Allocate(ctx, NUL_NODE));
         }
     | IF MK_LPAREN test MK_RPAREN stmt ELSE stmt
         {
             // xatier
-            $$ = makeStmtNode(IF_STMT);
+            $$ = makeStmtNode(ctx, IF_STMT);
             makeFamily($$, 3, $3, $5, $7);
         }
     | ID MK_LPAREN relop_expr_list MK_RPAREN MK_SEMICOLON
         {
             // xatier
-            $$ = makeStmtNode(FUNCTION_CALL_STMT);
-            makeFamily($$, 2, makeIDNode($1, NORMAL_ID), $3);
+            $$ = makeStmtNode(ctx, FUNCTION_CALL_STMT);
+            makeFamily($$, 2, makeIDNode(ctx, $1, NORMAL_ID), $3);
         }
-    | MK_SEMICOLON                     { $$ = Allocate(NUL_NODE); }        // xatier
-    | RETURN MK_SEMICOLON              { $$ = makeStmtNode(RETURN_STMT); } // xatier
+    | MK_SEMICOLON                     { $$ = Allocate(ctx, NUL_NODE); }        // xatier
+    | RETURN MK_SEMICOLON              { $$ = makeStmtNode(ctx, RETURN_STMT); } // xatier
     | RETURN relop_expr MK_SEMICOLON
         {
             // xatier
-            $$ = makeStmtNode(RETURN_STMT);
+            $$ = makeStmtNode(ctx, RETURN_STMT);
             makeChild($$, $2);
         }
     ;
@@ -497,12 +413,12 @@ assign_expr_list
     : nonempty_assign_expr_list
          {
             //jyhsu
-            $$ = Allocate(NONEMPTY_ASSIGN_EXPR_LIST_NODE);
+            $$ = Allocate(ctx, NONEMPTY_ASSIGN_EXPR_LIST_NODE);
             makeChild($$, $1);
          }
     |
          {
-             $$ = Allocate(NUL_NODE);
+             $$ = Allocate(ctx, NUL_NODE);
          }
     ;
 
@@ -530,8 +446,8 @@ assign_expr
     : ID OP_ASSIGN relop_expr
         {
             //jyhsu
-            $$ = makeStmtNode(ASSIGN_STMT);
-            makeFamily($$, 2, makeIDNode($1, NORMAL_ID), $3);
+            $$ = makeStmtNode(ctx, ASSIGN_STMT);
+            makeFamily($$, 2, makeIDNode(ctx, $1, NORMAL_ID), $3);
         }
     | relop_expr
         {
@@ -547,7 +463,7 @@ relop_expr
         }
     | relop_expr OP_OR relop_term
         {
-            $$ = makeExprNode(BINARY_OPERATION, BINARY_OP_OR);
+            $$ = makeExprNode(ctx, BINARY_OPERATION, BINARY_OP_OR);
             makeFamily($$, 2, $1, $3);
         }
     ;
@@ -557,7 +473,7 @@ relop_term
     | relop_term OP_AND relop_factor
         {
             //jyhsu
-            $$ = makeExprNode(BINARY_OPERATION, BINARY_OP_AND);
+            $$ = makeExprNode(ctx, BINARY_OPERATION, BINARY_OP_AND);
             makeFamily($$, 2, $1, $3);
         }
     ;
@@ -575,32 +491,32 @@ rel_op
     : OP_EQ
         {
             //jyhsu
-            $$ = makeExprNode(BINARY_OPERATION, BINARY_OP_EQ);
+            $$ = makeExprNode(ctx, BINARY_OPERATION, BINARY_OP_EQ);
         }
     | OP_GE
         {
             //jyhsu
-            $$ = makeExprNode(BINARY_OPERATION, BINARY_OP_GE);
+            $$ = makeExprNode(ctx, BINARY_OPERATION, BINARY_OP_GE);
         }
     | OP_LE
         {
             //jyhsu
-            $$ = makeExprNode(BINARY_OPERATION, BINARY_OP_LE);
+            $$ = makeExprNode(ctx, BINARY_OPERATION, BINARY_OP_LE);
         }
     | OP_NE
         {
             //jyhsu
-            $$ = makeExprNode(BINARY_OPERATION, BINARY_OP_NE);
+            $$ = makeExprNode(ctx, BINARY_OPERATION, BINARY_OP_NE);
         }
     | OP_GT
         {
             //jyhsu
-            $$ = makeExprNode(BINARY_OPERATION, BINARY_OP_GT);
+            $$ = makeExprNode(ctx, BINARY_OPERATION, BINARY_OP_GT);
         }
     | OP_LT
         {
             //jyhsu
-            $$ = makeExprNode(BINARY_OPERATION, BINARY_OP_LT);
+            $$ = makeExprNode(ctx, BINARY_OPERATION, BINARY_OP_LT);
         }
     ;
 
@@ -609,12 +525,12 @@ relop_expr_list
     : nonempty_relop_expr_list
         {
             //jyhsu
-            $$ = Allocate(NONEMPTY_RELOP_EXPR_LIST_NODE);
+            $$ = Allocate(ctx, NONEMPTY_RELOP_EXPR_LIST_NODE);
             makeChild($$, $1);
         }
     |
         {
-            $$ = Allocate(NUL_NODE);
+            $$ = Allocate(ctx, NUL_NODE);
         }
     ;
 
@@ -645,8 +561,8 @@ expr
     ;
 
 add_op
-    : OP_PLUS                          { $$ = makeExprNode(BINARY_OPERATION, BINARY_OP_ADD); }
-    | OP_MINUS                         { $$ = makeExprNode(BINARY_OPERATION, BINARY_OP_SUB); }
+    : OP_PLUS                          { $$ = makeExprNode(ctx, BINARY_OPERATION, BINARY_OP_ADD); }
+    | OP_MINUS                         { $$ = makeExprNode(ctx, BINARY_OPERATION, BINARY_OP_SUB); }
     ;
 
 term
@@ -666,12 +582,12 @@ mul_op
     : OP_TIMES
         {
             //jyhsu
-            $$ = makeExprNode(BINARY_OPERATION, BINARY_OP_MUL);
+            $$ = makeExprNode(ctx, BINARY_OPERATION, BINARY_OP_MUL);
         }
     | OP_DIVIDE
         {
             //jyhsu
-            $$ = makeExprNode(BINARY_OPERATION, BINARY_OP_DIV);
+            $$ = makeExprNode(ctx, BINARY_OPERATION, BINARY_OP_DIV);
         }
     ;
 
@@ -685,59 +601,59 @@ factor
      ===jyhsu try ===*/
     | OP_MINUS MK_LPAREN relop_expr MK_RPAREN
         {
-            $$ = makeExprNode(UNARY_OPERATION, UNARY_OP_NEGATIVE);
+            $$ = makeExprNode(ctx, UNARY_OPERATION, UNARY_OP_NEGATIVE);
             makeChild($$, $3);
         }
     | OP_NOT MK_LPAREN relop_expr MK_RPAREN
         {
             //jyhsu
-            $$ = makeExprNode(UNARY_OPERATION, UNARY_OP_LOGICAL_NEGATION);
+            $$ = makeExprNode(ctx, UNARY_OPERATION, UNARY_OP_LOGICAL_NEGATION);
             makeChild($$, $3);
         }
     | CONST
         {
-            $$ = Allocate(CONST_VALUE_NODE);
+            $$ = Allocate(ctx, CONST_VALUE_NODE);
             $$->semantic_value.const1 = $1;
         }
     /*TODO: | -<constant> e.g. -4
     ===jyhsu try===*/
     | OP_MINUS CONST
         {
-            $$ = makeExprNode(UNARY_OPERATION, UNARY_OP_NEGATIVE);
-            AST_NODE *c = Allocate(CONST_VALUE_NODE);
+            $$ = makeExprNode(ctx, UNARY_OPERATION, UNARY_OP_NEGATIVE);
+            AST_NODE *c = Allocate(ctx, CONST_VALUE_NODE);
             c->semantic_value.const1 = $2;
             makeChild($$, c);
         }
     | OP_NOT CONST
         {
             //jyhsu
-            $$ = makeExprNode(UNARY_OPERATION, UNARY_OP_LOGICAL_NEGATION);
-            AST_NODE *c = Allocate(CONST_VALUE_NODE);
+            $$ = makeExprNode(ctx, UNARY_OPERATION, UNARY_OP_LOGICAL_NEGATION);
+            AST_NODE *c = Allocate(ctx, CONST_VALUE_NODE);
             c->semantic_value.const1 = $2;
             makeChild($$, c);
         }
     | ID MK_LPAREN relop_expr_list MK_RPAREN
         {
             //jyhsu
-            $$ = makeStmtNode(FUNCTION_CALL_STMT);
-            makeFamily($$, 2, makeIDNode($1, NORMAL_ID), $3);
+            $$ = makeStmtNode(ctx, FUNCTION_CALL_STMT);
+            makeFamily($$, 2, makeIDNode(ctx, $1, NORMAL_ID), $3);
         }
     /*TODO: | -<function call> e.g. -f(4)
     ===jyhsu try*/
     | OP_MINUS ID MK_LPAREN relop_expr_list MK_RPAREN
         {
-            $$ = makeExprNode(UNARY_OPERATION, UNARY_OP_NEGATIVE);
-            AST_NODE* negnode = makeStmtNode(FUNCTION_CALL_STMT);
+            $$ = makeExprNode(ctx, UNARY_OPERATION, UNARY_OP_NEGATIVE);
+            AST_NODE* negnode = makeStmtNode(ctx, FUNCTION_CALL_STMT);
             makeChild($$, negnode);
-            makeFamily(negnode, 2, makeIDNode($2, NORMAL_ID), $4);
+            makeFamily(negnode, 2, makeIDNode(ctx, $2, NORMAL_ID), $4);
         }
     | OP_NOT ID MK_LPAREN relop_expr_list MK_RPAREN
         {
             //jyhsu
-            $$ = makeExprNode(UNARY_OPERATION, UNARY_OP_LOGICAL_NEGATION);
-            AST_NODE* notnode = makeStmtNode(FUNCTION_CALL_STMT);
+            $$ = makeExprNode(ctx, UNARY_OPERATION, UNARY_OP_LOGICAL_NEGATION);
+            AST_NODE* notnode = makeStmtNode(ctx, FUNCTION_CALL_STMT);
             makeChild($$, notnode);
-            makeFamily(notnode, 2, makeIDNode($2, NORMAL_ID), $4);
+            makeFamily(notnode, 2, makeIDNode(ctx, $2, NORMAL_ID), $4);
         }
     | var_ref
         {
@@ -748,13 +664,13 @@ factor
     ===jyhsu try===*/
     | OP_MINUS var_ref
         {
-            $$ = makeExprNode(UNARY_OPERATION, UNARY_OP_NEGATIVE);
+            $$ = makeExprNode(ctx, UNARY_OPERATION, UNARY_OP_NEGATIVE);
             makeChild($$, $2);
         }
     | OP_NOT var_ref
         {
             //jyhsu
-            $$ = makeExprNode(UNARY_OPERATION, UNARY_OP_LOGICAL_NEGATION);
+            $$ = makeExprNode(ctx, UNARY_OPERATION, UNARY_OP_LOGICAL_NEGATION);
             makeChild($$, $2);
         }
     ;
@@ -763,12 +679,12 @@ var_ref
     : ID
         {
             //jyhsu
-            $$ = makeIDNode($1, NORMAL_ID);
+            $$ = makeIDNode(ctx, $1, NORMAL_ID);
         }
     | ID dim_list
         {
             //jyhsu
-            $$ = makeIDNode($1, ARRAY_ID);
+            $$ = makeIDNode(ctx, $1, ARRAY_ID);
             makeChild($$, $2);
         }
     ;
@@ -790,31 +706,190 @@ dim_list
 
 %%
 
+#include "tokenPipe.h"
+
+#ifdef HAND_LEXER
+#include "scanner.h"
+#else
+#define YY_DECL int scanToken (YYSTYPE *tokenValue, yyscan_t yyscanner)
 #include "lex.yy.c"
+#endif
+
+
+// the parsers get their tokens here, from the scanner or from the lexer
+// thread
+int yylex (YYSTYPE *value, CompilerContext *ctx) {
+    int token;
+
+    if (ctx->threadedLexer)
+        return nextPipedToken(ctx, value);
+    token = scanToken(value, ctx->scanner);
+    ctx->linenumber = ctx->tokenLine;
+    return token;
+}
+
+
+// the text of the token yylex() returned last, the scanner's belongs to the
+// lexer thread if there is one
+static void printTokenText (CompilerContext *ctx, FILE *out) {
+    if (ctx->threadedLexer) {
+        int length;
+        const char *text = pipedText(ctx, &length);
+        fprintf(out, "%.*s", length, text);
+    }
+    else
+        fputs(yyget_text(ctx->scanner), out);
+}
+
+
+// --dump-tokens: one line per token with its yylval, for comparing scanners
+static void dumpTokens (CompilerContext *ctx, FILE *out) {
+    YYSTYPE value;
+    int token;
+
+    while ((token = yylex(&value, ctx)) != 0) {
+        fprintf(out, "%d\t%d\t", ctx->linenumber, token);
+        printTokenText(ctx, out);
+        if (token == ID)
+            fprintf(out, "\t%s", value.lexeme);
+        else if (token == CONST && value.const1->const_type == INTEGERC)
+            fprintf(out, "\tint %d", value.const1->const_u.intval);
+        else if (token == CONST && value.const1->const_type == FLOATC)
+            fprintf(out, "\tfloat %.17g", value.const1->const_u.fval);
+        else if (token == CONST)
+            fprintf(out, "\tstring %s", value.const1->const_u.sc);
+        fprintf(out, "\n");
+    }
+    fprintf(out, "%d\teof\n", ctx->linenumber);
+}
+
+int parseSource (CompilerContext *ctx, char *text, size_t size) {
+    YY_BUFFER_STATE sourceBuffer;
+
+    // the parsers use the builtin names while the lexer interns
+    initializeInternTable(ctx);
+    if (yylex_init_extra(ctx, &ctx->scanner) != 0) {
+        fputs("cannot start the scanner\n", ctx->diagnostics);
+        ctx->anyErrorOccur = 1;
+        ctx->errorCount++;
+        return -1;
+    }
+    sourceBuffer = yy_scan_buffer(text, size, ctx->scanner);
+    if (ctx->threadedLexer)
+        startLexerThread(ctx);
+    if (ctx->tokensOnly)
+        dumpTokens(ctx, stdout);
+    else if (ctx->descentParser)
+        ctx->prog = parseProgram(ctx);
+    else
+        yyparse(ctx);
+    if (ctx->threadedLexer)
+        joinLexerThread(ctx);
+    yy_delete_buffer(sourceBuffer, ctx->scanner);
+    yylex_destroy(ctx->scanner);
+    ctx->scanner = NULL;
+    // so far only yyerror() reports errors
+    return ctx->anyErrorOccur ? -1 : 0;
+}
+
+
+// libcmm.a and libcmm.so are built from this file with CMM_LIBRARY, without
+// the command line
+#ifndef CMM_LIBRARY
 main (argc, argv)
   int argc;
   char *argv[];
 {
-    yyin = fopen(argv[1], "r");
-    yyparse();
-    // printGV(prog, NULL);
+    CompilerContext context;
+    CompilerContext *ctx = &context;
+    char **sources = (char **)malloc(argc * sizeof(char *));
+    int sourceCount = 0;
+    int threads = 0;
+    int server = 0;
+    const char *socketPath = NULL;
+    int i;
+
+    if (sources == NULL) {
+        printf("out of memory\n");
+        exit(1);
+    }
+    initializeContext(ctx);
+    for (i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--buffered-io") == 0)
+            ctx->bufferedIO = 1;
+        else if (strcmp(argv[i], "--batched-input") == 0)
+            ctx->batchedInput = 1;
+        else if (strcmp(argv[i], "--time-passes") == 0)
+            timePasses = 1;
+        else if (strcmp(argv[i], "--dump-tokens") == 0)
+            ctx->tokensOnly = 1;
+        else if (strcmp(argv[i], "--descent-parser") == 0)
+            ctx->descentParser = 1;
+        else if (strcmp(argv[i], "--dump-ast") == 0)
+            ctx->astOnly = 1;
+        else if (strcmp(argv[i], "--threaded-lexer") == 0)
+            ctx->threadedLexer = 1;
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc)
+            ctx->cacheDirectory = argv[++i];
+        else if (strcmp(argv[i], "--cache-size") == 0 && i + 1 < argc)
+            ctx->cacheLimit = atoll(argv[++i]) << 20;
+        else if (strcmp(argv[i], "--server") == 0)
+            server = 1;
+        else if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc)
+            socketPath = argv[++i];
+        else
+            sources[sourceCount++] = argv[i];
+    }
 
-    initializeSymbolTable();
+    if ((!server && sourceCount == 0) || (threads == 0 && sourceCount > 1) || threads < 0 ||
+        (threads > 0 && (ctx->tokensOnly || ctx->astOnly)) ||
+        (server && (sourceCount > 0 || threads > 0)) || (socketPath && !server)) {
+        printf("usage: %s [--buffered-io] [--batched-input] [--time-passes] [--dump-tokens]\n"
+               "       [--descent-parser] [--dump-ast] [--threaded-lexer]\n"
+               "       [--cache dir] [--cache-size MB] file\n"
+               "       %s -j N [--buffered-io] [--batched-input] [--time-passes]\n"
+               "       [--descent-parser] [--threaded-lexer] [--cache dir] [--cache-size MB] file...\n"
+               "       %s --server [--socket path] [--cache dir] [--cache-size MB]\n", argv[0], argv[0], argv[0]);
+        exit(1);
+    }
 
-    semanticAnalysis(prog);
+    // --server: the options come with every request, see server.h
+    if (server) {
+        cmm_options defaults = { 0 };
+        defaults.cacheDirectory = ctx->cacheDirectory;
+        defaults.cacheLimit = ctx->cacheLimit;
+        exit(runServer(socketPath, &defaults));
+    }
 
-    codeGen(prog);
+    // -j: every file into its own .s, see batch.c
+    if (threads > 0) {
+        ctx->skipCodeOnError = 1;
+        exit(compileBatch(ctx, sources, sourceCount, threads) == 0 ? 0 : 1);
+    }
 
-    symbolTableEnd();
-    if (!g_anyErrorOccur) {
+    if (compileFile(ctx, sources[0]) != 0)
+        exit(1);
+    if (ctx->tokensOnly || ctx->astOnly)
+        exit(0);
+    free(sources);
+    reportPasses(stderr);
+    if (!ctx->anyErrorOccur) {
        printf("Parsing completed. No errors found.\n");
     }
 } /* main */
-
-
-int yyerror (mesg)
-char *mesg;
-{
-    printf("%s\t%d\t%s\t%s\n", "Error found in Line ", linenumber, "next token: ", yytext);
-    exit(1);
+#endif // CMM_LIBRARY
+
+
+// the parse stops after the first syntax error
+int yyerror (CompilerContext *ctx, const char *mesg) {
+    // bison's message isn't printed, the token is
+    (void)mesg;
+    ctx->anyErrorOccur = 1;
+    ctx->errorCount++;
+    fprintf(ctx->diagnostics, "%s\t%d\t%s\t", "Error found in Line ", ctx->linenumber, "next token: ");
+    printTokenText(ctx, ctx->diagnostics);
+    fprintf(ctx->diagnostics, "\n");
+    return 0;
 }
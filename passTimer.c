@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <time.h>
+#include <sys/resource.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "passTimer.h"
+
+
+// the passes run one after another, so one table of finished passes and the
+// start of the current one are all that is kept
+
+#define MAX_PASSES 16
+
+
+typedef struct PassTime {
+    const char *name;
+    double seconds;
+    long long heapBytes;
+    long peakRSS;
+} PassTime;
+
+
+int timePasses = 0;
+
+static PassTime passes[MAX_PASSES];
+static int passCount = 0;
+static const char *currentPass = NULL;
+static double passStart;
+static long long heapStart;
+
+
+static double wallClock (void) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+
+// bytes of heap in use, -1 when the C library can't tell. a pass is given
+// the difference between its end and its start: what it allocated minus
+// what it freed, not how much it allocated. the arena takes 64KB chunks, so
+// the AST shows up in steps of those
+static long long heapInUse (void) {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 info = mallinfo2();
+    return (long long)info.uordblks + (long long)info.hblkhd;
+#else
+    return -1;
+#endif
+}
+
+
+// in KB on Linux
+static long peakRSS (void) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+    return usage.ru_maxrss;
+}
+
+
+void startPass (const char *name) {
+    if (!timePasses)
+        return;
+    currentPass = name;
+    heapStart = heapInUse();
+    passStart = wallClock();
+}
+
+
+void endPass (void) {
+    double end;
+
+    if (!timePasses || currentPass == NULL)
+        return;
+    end = wallClock();
+
+    if (passCount < MAX_PASSES) {
+        PassTime *pass = &passes[passCount++];
+        pass->name = currentPass;
+        pass->seconds = end - passStart;
+        pass->heapBytes = heapStart < 0 ? -1 : heapInUse() - heapStart;
+        pass->peakRSS = peakRSS();
+    }
+    currentPass = NULL;
+}
+
+
+void reportPasses (FILE *out) {
+    double total = 0;
+    int i;
+
+    if (!timePasses)
+        return;
+
+    for (i = 0; i < passCount; ++i)
+        total += passes[i].seconds;
+
+    fprintf(out, "%-20s %10s %7s %12s %12s\n", "pass", "wall ms", "%", "net heap KB", "peak RSS KB");
+    for (i = 0; i < passCount; ++i) {
+        fprintf(out, "%-20s %10.3f %6.2f%% ", passes[i].name, passes[i].seconds * 1e3,
+                total > 0 ? 100.0 * passes[i].seconds / total : 0.0);
+        if (passes[i].heapBytes < 0)
+            fprintf(out, "%12s ", "-");
+        else
+            fprintf(out, "%+12.1f ", passes[i].heapBytes / 1024.0);
+        fprintf(out, "%12ld\n", passes[i].peakRSS);
+    }
+    fprintf(out, "%-20s %10.3f\n", "total", total * 1e3);
+}
@@ -0,0 +1,19 @@
+#ifndef __PASS_TIMER_H__
+#define __PASS_TIMER_H__
+
+#include <stdio.h>
+
+
+// --time-passes: time every compiler pass and print a table at the end
+extern int timePasses;
+
+// start measuring the pass `name`, the previous pass has to be ended first
+void startPass (const char *name);
+void endPass (void);
+
+// wall time, net heap growth and peak RSS of every pass, in the order they
+// ran
+void reportPasses (FILE *out);
+
+
+#endif // __PASS_TIMER_H__
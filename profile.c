@@ -0,0 +1,275 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mipsim.h"
+#include "profile.h"
+
+
+// the simulator counts how many times every instruction has run, this file
+// adds those counts up by the source line and the function each instruction
+// came from
+
+
+typedef struct ProfileCounts {
+    long long instructions;
+    long long loads;
+    long long stores;
+    long long syscalls;
+} ProfileCounts;
+
+
+typedef struct FunctionProfile {
+    const char *name;
+    ProfileCounts counts;
+} FunctionProfile;
+
+
+static void addCounts (ProfileCounts *counts, const MipsInsnInfo *info) {
+    counts->instructions += info->executed * info->cost;
+    if (info->isLoad)
+        counts->loads += info->executed;
+    if (info->isStore)
+        counts->stores += info->executed;
+    if (info->isSyscall)
+        counts->syscalls += info->executed;
+}
+
+
+static int compareFunctions (const void *a, const void *b) {
+    long long x = ((const FunctionProfile *)a)->counts.instructions;
+    long long y = ((const FunctionProfile *)b)->counts.instructions;
+    return x < y ? 1 : x > y ? -1 : 0;
+}
+
+
+static void printHeader (FILE *out, const char *what) {
+    fprintf(out, "%12s %7s %10s %10s %9s  %s\n", "instructions", "%", "loads", "stores", "syscalls", what);
+}
+
+
+static void printCounts (FILE *out, const ProfileCounts *counts, long long total) {
+    if (counts->instructions == 0) {
+        fprintf(out, "%12s %7s %10s %10s %9s  ", "", "", "", "", "");
+        return;
+    }
+    fprintf(out, "%12lld %6.2f%% %10lld %10lld %9lld  ",
+            counts->instructions, total ? 100.0 * counts->instructions / total : 0.0,
+            counts->loads, counts->stores, counts->syscalls);
+}
+
+
+void printProfile (FILE *out, const char *sourceFile) {
+    int textCount = mipsimTextCount();
+    ProfileCounts total = {0, 0, 0, 0};
+    ProfileCounts *lines;
+    FunctionProfile *functions;
+    int maxLine = 0;
+    int functionCount = 0;
+    int pc, i;
+
+    for (pc = 0; pc < textCount; ++pc) {
+        MipsInsnInfo info;
+        mipsimInsnInfo(pc, &info);
+        if (info.srcLine > maxLine)
+            maxLine = info.srcLine;
+    }
+
+    lines = (ProfileCounts *)calloc(maxLine + 1, sizeof(ProfileCounts));
+    functions = (FunctionProfile *)calloc(textCount + 1, sizeof(FunctionProfile));
+    if (!lines || !functions) {
+        fprintf(stderr, "mipsim: out of memory\n");
+        exit(2);
+    }
+
+    for (pc = 0; pc < textCount; ++pc) {
+        MipsInsnInfo info;
+        const char *name;
+
+        mipsimInsnInfo(pc, &info);
+        name = info.function ? info.function : "(unknown)";
+
+        addCounts(&total, &info);
+        addCounts(&lines[info.srcLine], &info);
+
+        // function names are kept once by the simulator
+        for (i = 0; i < functionCount && functions[i].name != name; ++i)
+            ;
+        if (i == functionCount)
+            functions[functionCount++].name = name;
+        addCounts(&functions[i].counts, &info);
+    }
+
+    qsort(functions, functionCount, sizeof(FunctionProfile), compareFunctions);
+
+    fprintf(out, "\n# functions\n");
+    printHeader(out, "function");
+    for (i = 0; i < functionCount; ++i) {
+        if (functions[i].counts.instructions == 0)
+            continue;
+        printCounts(out, &functions[i].counts, total.instructions);
+        fprintf(out, "%s\n", functions[i].name);
+    }
+
+    fprintf(out, "\n# source lines (%s)\n", sourceFile);
+    printHeader(out, "line");
+
+    FILE *source = fopen(sourceFile, "r");
+    if (source) {
+        ProfileCounts none = {0, 0, 0, 0};
+        char buf[4096];
+        int n = 0;
+
+        while (fgets(buf, sizeof(buf), source)) {
+            ++n;
+            printCounts(out, n <= maxLine ? &lines[n] : &none, total.instructions);
+            fprintf(out, "%4d | %s", n, buf);
+            if (buf[strlen(buf) - 1] != '\n')
+                fprintf(out, "\n");
+        }
+        fclose(source);
+    }
+    else {
+        // no source, print the lines that have run
+        for (i = 1; i <= maxLine; ++i) {
+            if (lines[i].instructions == 0)
+                continue;
+            printCounts(out, &lines[i], total.instructions);
+            fprintf(out, "%4d\n", i);
+        }
+    }
+
+    // code that doesn't come from a line, e.g. the runtime routines
+    if (lines[0].instructions) {
+        printCounts(out, &lines[0], total.instructions);
+        fprintf(out, "(no line)\n");
+    }
+
+    printCounts(out, &total, total.instructions);
+    fprintf(out, "total\n");
+
+    free(lines);
+    free(functions);
+}
+
+
+// call stack profile
+//
+// the stacks seen so far form a tree, each node counts the instructions run
+// while it was the top of the stack. the counts are updated at every call
+// and return, from the difference in mipsStats.instructions
+
+typedef struct StackNode {
+    const char *name;
+    int parent;
+    int firstChild;
+    int nextSibling;
+    long long instructions;
+} StackNode;
+
+
+static StackNode *stackNodes = NULL;
+static int stackNodeCount = 0;
+static int stackNodeCapacity = 0;
+static int currentNode = -1;
+static long long lastInstructions = 0;
+
+
+static int newStackNode (const char *name, int parent) {
+    if (stackNodeCount == stackNodeCapacity) {
+        stackNodeCapacity = stackNodeCapacity ? stackNodeCapacity * 2 : 256;
+        stackNodes = (StackNode *)realloc(stackNodes, stackNodeCapacity * sizeof(StackNode));
+        if (!stackNodes) {
+            fprintf(stderr, "mipsim: out of memory\n");
+            exit(2);
+        }
+    }
+
+    StackNode *node = &stackNodes[stackNodeCount];
+    node->name = name;
+    node->parent = parent;
+    node->firstChild = -1;
+    node->nextSibling = -1;
+    node->instructions = 0;
+    if (parent >= 0) {
+        node->nextSibling = stackNodes[parent].firstChild;
+        stackNodes[parent].firstChild = stackNodeCount;
+    }
+    return stackNodeCount++;
+}
+
+
+// charge the instructions since the last call or return to the current stack
+static void chargeCurrentStack (void) {
+    stackNodes[currentNode].instructions += mipsStats.instructions - lastInstructions;
+    lastInstructions = mipsStats.instructions;
+}
+
+
+static void onCall (const char *callee) {
+    int child;
+
+    chargeCurrentStack();
+    if (callee == NULL)
+        callee = "(indirect)";
+
+    // label names live as long as the simulator
+    for (child = stackNodes[currentNode].firstChild; child >= 0; child = stackNodes[child].nextSibling) {
+        if (strcmp(stackNodes[child].name, callee) == 0)
+            break;
+    }
+    if (child < 0)
+        child = newStackNode(callee, currentNode);
+    currentNode = child;
+}
+
+
+static void onReturn (void) {
+    chargeCurrentStack();
+    if (stackNodes[currentNode].parent >= 0)
+        currentNode = stackNodes[currentNode].parent;
+}
+
+
+void startCallProfile (const char *entry) {
+    stackNodeCount = 0;
+    currentNode = newStackNode(entry, -1);
+    lastInstructions = 0;
+    mipsimSetCallHooks(onCall, onReturn);
+}
+
+
+void writeFoldedStacks (FILE *out) {
+    int *path = NULL;
+    int node, depth, n, i;
+
+    if (currentNode < 0)
+        return;
+    chargeCurrentStack();
+
+    for (node = 0; node < stackNodeCount; ++node) {
+        if (stackNodes[node].instructions == 0)
+            continue;
+
+        // walk up to the root, recursion can make the stack deep
+        depth = 0;
+        for (i = node; i >= 0; i = stackNodes[i].parent)
+            ++depth;
+        path = (int *)realloc(path, depth * sizeof(int));
+        if (!path) {
+            fprintf(stderr, "mipsim: out of memory\n");
+            exit(2);
+        }
+        n = depth;
+        for (i = node; i >= 0; i = stackNodes[i].parent)
+            path[--n] = i;
+
+        for (i = 0; i < depth; ++i) {
+            if (i > 0)
+                fputc(';', out);
+            fputs(stackNodes[path[i]].name, out);
+        }
+        fprintf(out, " %lld\n", stackNodes[node].instructions);
+    }
+    free(path);
+}
@@ -0,0 +1,20 @@
+#ifndef __PROFILE_H__
+#define __PROFILE_H__
+
+#include <stdio.h>
+
+
+// per-function and per-source-line profile of the last mipsimRun(),
+// `sourceFile` is the C-- file output.s was compiled from
+void printProfile (FILE *out, const char *sourceFile);
+
+// keep a shadow call stack during mipsimRun(), starting at `entry`, and
+// count the instructions run under every distinct stack
+void startCallProfile (const char *entry);
+
+// one "main;f;g count" line per stack, the folded format flame graph
+// scripts read
+void writeFoldedStacks (FILE *out);
+
+
+#endif // __PROFILE_H__
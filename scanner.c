@@ -0,0 +1,462 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "header.h"
+#include "symbolTable.h"
+#include "compilerContext.h"
+#include "parser.tab.h"
+#include "scanner.h"
+#include "tokenPipe.h"
+
+
+// the tokens and their precedence are the ones of lexer3.l: the longest
+// match wins, keywords beat identifiers of the same length, and every
+// character nothing else matches is an ERROR token of its own.
+//
+// blanks, identifiers, comments and strings are scanned a vector at a time:
+// 32 bytes with AVX2, 16 with SSE2 (built with -mavx2 or not), and a byte
+// at a time where neither is available. a vector is only loaded while it
+// fits before the end of the buffer, the rest is scanned byte by byte.
+
+
+// a yyscan_t points to one of these
+typedef struct Scanner {
+    CompilerContext *extra;
+    char *text;
+    int leng;
+    char *cursor;
+    char *bufferEnd;
+
+    // like flex, the lexeme is NUL-terminated in place until the next token
+    char *holdPos;
+    char holdChar;
+} Scanner;
+
+
+#if defined(__AVX2__)
+
+#define VECTOR_BYTES 32
+#define ALL_BYTES 0xffffffffu
+
+typedef __m256i Vector;
+
+static inline Vector loadVector (const char *p) {
+    return _mm256_loadu_si256((const __m256i *)p);
+}
+
+static inline unsigned int equalMask (Vector v, char c) {
+    return (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c)));
+}
+
+// bytes below `limit` once `offset` is added, as signed bytes
+static inline unsigned int rangeMask (Vector v, char offset, char limit) {
+    Vector shifted = _mm256_add_epi8(v, _mm256_set1_epi8(offset));
+    return (unsigned int)_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_set1_epi8(limit), shifted));
+}
+
+static inline Vector lowerCase (Vector v) {
+    return _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+}
+
+#elif defined(__SSE2__)
+
+#define VECTOR_BYTES 16
+#define ALL_BYTES 0xffffu
+
+typedef __m128i Vector;
+
+static inline Vector loadVector (const char *p) {
+    return _mm_loadu_si128((const __m128i *)p);
+}
+
+static inline unsigned int equalMask (Vector v, char c) {
+    return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c)));
+}
+
+static inline unsigned int rangeMask (Vector v, char offset, char limit) {
+    Vector shifted = _mm_add_epi8(v, _mm_set1_epi8(offset));
+    return (unsigned int)_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(limit), shifted));
+}
+
+static inline Vector lowerCase (Vector v) {
+    return _mm_or_si128(v, _mm_set1_epi8(0x20));
+}
+
+#endif
+
+
+#ifdef VECTOR_BYTES
+
+// [A-Za-z0-9_]: 'a'..'z' and '0'..'9' are moved to the bottom of the signed
+// byte range, so one signed compare checks each range
+static inline unsigned int identifierMask (Vector v) {
+    unsigned int letters = rangeMask(lowerCase(v), (char)(-128 - 'a'), (char)(-128 + 26));
+    unsigned int digits = rangeMask(v, (char)(-128 - '0'), (char)(-128 + 10));
+    return letters | digits | equalMask(v, '_');
+}
+
+static inline int countNewlines (unsigned int newlines) {
+    return __builtin_popcount(newlines);
+}
+
+#endif
+
+
+static inline int isLetter (char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static inline int isDigit (char c) {
+    return c >= '0' && c <= '9';
+}
+
+
+// past ' ', '\t' and '\n', counting the lines
+static char *skipBlanks (Scanner *s, char *p) {
+#ifdef VECTOR_BYTES
+    while (s->bufferEnd - p >= VECTOR_BYTES) {
+        Vector v = loadVector(p);
+        unsigned int newlines = equalMask(v, '\n');
+        unsigned int blanks = equalMask(v, ' ') | equalMask(v, '\t') | newlines;
+        if (blanks != ALL_BYTES) {
+            int n = __builtin_ctz(~blanks);
+            s->extra->tokenLine += countNewlines(newlines & ((1u << n) - 1));
+            return p + n;
+        }
+        s->extra->tokenLine += countNewlines(newlines);
+        p += VECTOR_BYTES;
+    }
+#endif
+    while (*p == ' ' || *p == '\t' || *p == '\n') {
+        if (*p == '\n')
+            ++s->extra->tokenLine;
+        ++p;
+    }
+    return p;
+}
+
+
+// past the letters, digits and underscores at `p`
+static char *skipIdentifier (Scanner *s, char *p) {
+#ifdef VECTOR_BYTES
+    while (s->bufferEnd - p >= VECTOR_BYTES) {
+        unsigned int inside = identifierMask(loadVector(p));
+        if (inside != ALL_BYTES)
+            return p + __builtin_ctz(~inside);
+        p += VECTOR_BYTES;
+    }
+#else
+    (void)s;
+#endif
+    while (isLetter(*p) || isDigit(*p) || *p == '_')
+        ++p;
+    return p;
+}
+
+
+// `p` is just past "/*", returns the end of the first "*/" and counts the
+// lines in between, or NULL (and no lines) when the comment isn't closed
+static char *skipComment (Scanner *s, char *p) {
+    int lines = 0;
+
+#ifdef VECTOR_BYTES
+    // the '/' of a "*/" is looked up one byte ahead
+    while (s->bufferEnd - p >= VECTOR_BYTES + 1) {
+        Vector v = loadVector(p);
+        unsigned int newlines = equalMask(v, '\n');
+        unsigned int closes = equalMask(v, '*') & equalMask(loadVector(p + 1), '/');
+        if (closes) {
+            int n = __builtin_ctz(closes);
+            s->extra->tokenLine += lines + countNewlines(newlines & ((1u << n) - 1));
+            return p + n + 2;
+        }
+        lines += countNewlines(newlines);
+        p += VECTOR_BYTES;
+    }
+#endif
+    for (; p < s->bufferEnd; ++p) {
+        if (p[0] == '*' && p[1] == '/') {
+            s->extra->tokenLine += lines;
+            return p + 2;
+        }
+        if (*p == '\n')
+            ++lines;
+    }
+    return NULL;
+}
+
+
+// `p` is just past the opening '"', returns the end of the closing one or
+// NULL if a newline or the end of the buffer comes first
+static char *skipString (Scanner *s, char *p) {
+#ifdef VECTOR_BYTES
+    while (s->bufferEnd - p >= VECTOR_BYTES) {
+        Vector v = loadVector(p);
+        unsigned int quotes = equalMask(v, '"');
+        unsigned int stops = quotes | equalMask(v, '\n');
+        if (stops) {
+            int n = __builtin_ctz(stops);
+            return (quotes >> n) & 1 ? p + n + 1 : NULL;
+        }
+        p += VECTOR_BYTES;
+    }
+#endif
+    for (; p < s->bufferEnd; ++p) {
+        if (*p == '"')
+            return p + 1;
+        if (*p == '\n')
+            return NULL;
+    }
+    return NULL;
+}
+
+
+// [eE][+-]?{digit}+ at `p`, returns its end or `p` if there is none
+static char *skipExponent (char *p) {
+    char *q = p;
+    if (*q != 'e' && *q != 'E')
+        return p;
+    ++q;
+    if (*q == '+' || *q == '-')
+        ++q;
+    if (!isDigit(*q))
+        return p;
+    while (isDigit(*q))
+        ++q;
+    return q;
+}
+
+
+// int_constant or flt_constant at `p`, NULL if `p` is a lone '.'
+static char *skipNumber (char *p, int *isFloat) {
+    char *q = p;
+    char *e;
+
+    while (isDigit(*q))
+        ++q;
+    *isFloat = 0;
+
+    if (*q == '.') {
+        char *fraction = q + 1;
+        char *r = fraction;
+        while (isDigit(*r))
+            ++r;
+        if (q == p && r == fraction)
+            return NULL;
+        *isFloat = 1;
+        return skipExponent(r);
+    }
+
+    e = skipExponent(q);
+    if (e != q)
+        *isFloat = 1;
+    return e;
+}
+
+
+static int keyword (const char *p, int length) {
+    switch (length) {
+        case 2:
+            if (memcmp(p, "if", 2) == 0) return IF;
+            break;
+        case 3:
+            if (memcmp(p, "int", 3) == 0) return INT;
+            if (memcmp(p, "for", 3) == 0) return FOR;
+            break;
+        case 4:
+            if (memcmp(p, "void", 4) == 0) return VOID;
+            if (memcmp(p, "else", 4) == 0) return ELSE;
+            break;
+        case 5:
+            if (memcmp(p, "float", 5) == 0) return FLOAT;
+            if (memcmp(p, "while", 5) == 0) return WHILE;
+            break;
+        case 6:
+            if (memcmp(p, "return", 6) == 0) return RETURN;
+            break;
+        case 7:
+            if (memcmp(p, "typedef", 7) == 0) return TYPEDEF;
+            break;
+    }
+    return 0;
+}
+
+
+// one or two character operators and punctuation
+static int punctuation (char *p, char **end) {
+    char c = p[0];
+    char d = p[1];
+
+    *end = p + 2;
+    if (c == '=' && d == '=') return OP_EQ;
+    if (c == '!' && d == '=') return OP_NE;
+    if (c == '<' && d == '=') return OP_LE;
+    if (c == '>' && d == '=') return OP_GE;
+    if (c == '&' && d == '&') return OP_AND;
+    if (c == '|' && d == '|') return OP_OR;
+
+    *end = p + 1;
+    switch (c) {
+        case '=': return OP_ASSIGN;
+        case '!': return OP_NOT;
+        case '<': return OP_LT;
+        case '>': return OP_GT;
+        case '+': return OP_PLUS;
+        case '-': return OP_MINUS;
+        case '*': return OP_TIMES;
+        case '/': return OP_DIVIDE;
+        case '(': return MK_LPAREN;
+        case ')': return MK_RPAREN;
+        case '{': return MK_LBRACE;
+        case '}': return MK_RBRACE;
+        case '[': return MK_LB;
+        case ']': return MK_RB;
+        case ',': return MK_COMMA;
+        case ';': return MK_SEMICOLON;
+        case '.': return MK_DOT;
+    }
+    return ERROR;
+}
+
+
+static CON_Type *newConstant (C_type type) {
+    CON_Type *constant = (CON_Type *)arenaAlloc(sizeof(CON_Type));
+    constant->const_type = type;
+    return constant;
+}
+
+
+int yylex_init_extra (CompilerContext *extra, yyscan_t *scanner) {
+    Scanner *s = (Scanner *)malloc(sizeof(Scanner));
+
+    *scanner = s;
+    if (s == NULL)
+        return 1;
+    s->extra = extra;
+    s->text = "";
+    s->leng = 0;
+    s->cursor = s->bufferEnd = s->holdPos = NULL;
+    return 0;
+}
+
+
+int yylex_destroy (yyscan_t scanner) {
+    free(scanner);
+    return 0;
+}
+
+
+char *yyget_text (yyscan_t scanner) {
+    return ((Scanner *)scanner)->text;
+}
+
+
+int yyget_leng (yyscan_t scanner) {
+    return ((Scanner *)scanner)->leng;
+}
+
+
+YY_BUFFER_STATE yy_scan_buffer (char *base, size_t size, yyscan_t scanner) {
+    Scanner *s = (Scanner *)scanner;
+
+    if (size < 2 || base[size - 2] != '\0' || base[size - 1] != '\0')
+        return NULL;
+    s->cursor = base;
+    s->bufferEnd = base + size - 2;
+    s->holdPos = NULL;
+    return base;
+}
+
+
+void yy_delete_buffer (YY_BUFFER_STATE buffer, yyscan_t scanner) {
+    Scanner *s = (Scanner *)scanner;
+
+    (void)buffer;
+    if (s->holdPos)
+        *s->holdPos = s->holdChar;
+    s->cursor = s->bufferEnd = s->holdPos = NULL;
+    s->text = "";
+    s->leng = 0;
+}
+
+
+int scanToken (YYSTYPE *tokenValue, yyscan_t yyscanner) {
+    Scanner *s = (Scanner *)yyscanner;
+    char *start;
+    char *end;
+    int token;
+    int isFloat = 0;
+
+    if (s->cursor == NULL)
+        return 0;
+    if (s->holdPos) {
+        *s->holdPos = s->holdChar;
+        s->holdPos = NULL;
+    }
+
+    for (;;) {
+        start = skipBlanks(s, s->cursor);
+        if (start >= s->bufferEnd) {
+            s->cursor = s->bufferEnd;
+            s->text = s->bufferEnd;
+            s->leng = 0;
+            return 0;
+        }
+        if (start[0] == '/' && start[1] == '*' && (end = skipComment(s, start + 2)) != NULL) {
+            s->cursor = end;
+            continue;
+        }
+        break;
+    }
+
+    if (isLetter(*start)) {
+        end = skipIdentifier(s, start + 1);
+        token = keyword(start, end - start);
+        if (token == 0)
+            token = ID;
+    }
+    else if ((isDigit(*start) || *start == '.') && (end = skipNumber(start, &isFloat)) != NULL) {
+        token = CONST;
+    }
+    else if (*start == '"' && (end = skipString(s, start + 1)) != NULL) {
+        token = CONST;
+    }
+    else if (*start == '\0') {
+        // a NUL inside the buffer, flex's '.' matches it too
+        end = start + 1;
+        token = ERROR;
+    }
+    else {
+        token = punctuation(start, &end);
+    }
+
+    s->text = start;
+    s->leng = end - start;
+    s->holdPos = end;
+    s->holdChar = *end;
+    *end = '\0';
+    s->cursor = end;
+
+    if (token == ID) {
+        tokenValue->lexeme = internSlice(s->extra, s->text, s->leng);
+    }
+    else if (token == CONST && *start == '"') {
+        tokenValue->const1 = newConstant(STRINGC);
+        tokenValue->const1->const_u.sc = internSlice(s->extra, s->text, s->leng);
+    }
+    else if (token == CONST && isFloat) {
+        tokenValue->const1 = newConstant(FLOATC);
+        tokenValue->const1->const_u.fval = atof(s->text);
+    }
+    else if (token == CONST) {
+        tokenValue->const1 = newConstant(INTEGERC);
+        tokenValue->const1->const_u.intval = atoi(s->text);
+    }
+    return token;
+}
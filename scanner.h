@@ -0,0 +1,31 @@
+#ifndef __SCANNER_H__
+#define __SCANNER_H__
+
+#include <stddef.h>
+
+#include "header.h"
+
+
+// hand written scanner, a drop-in replacement for the reentrant flex one in
+// lexer3.l (make parser-hand). it has the same tokens, values and lines, and
+// the part of the flex interface main uses
+
+
+typedef void *yyscan_t;
+typedef char *YY_BUFFER_STATE;
+
+// a scanner for one compilation, `extra` is where it counts the lines
+// (tokenLine) and interns the identifiers
+int yylex_init_extra(CompilerContext *extra, yyscan_t *scanner);
+int yylex_destroy(yyscan_t scanner);
+
+// scan `base`, whose last two of `size` bytes are NUL, in place
+YY_BUFFER_STATE yy_scan_buffer(char *base, size_t size, yyscan_t scanner);
+void yy_delete_buffer(YY_BUFFER_STATE buffer, yyscan_t scanner);
+
+// the last token's text and length
+char *yyget_text(yyscan_t scanner);
+int yyget_leng(yyscan_t scanner);
+
+
+#endif // __SCANNER_H__
@@ -3,35 +3,35 @@
 #include <string.h>
 #include "header.h"
 #include "symbolTable.h"
-
-int g_anyErrorOccur = 0;
+#include "compilerContext.h"
 
 DATA_TYPE getBiggerType (DATA_TYPE dataType1, DATA_TYPE dataType2);
-void processProgramNode (AST_NODE *programNode);
-void processDeclarationNode (AST_NODE *declarationNode);
-void declareIdList (AST_NODE *typeNode, SymbolAttributeKind isVariableOrTypeAttribute, int ignoreArrayFirstDimSize);
-void declareFunction (AST_NODE *returnTypeNode);
-void processDeclDimList (AST_NODE *variableDeclDimList, TypeDescriptor *typeDescriptor, int ignoreFirstDimSize);
-void processTypeNode (AST_NODE *typeNode);
-void processBlockNode (AST_NODE *blockNode);
-void processStmtNode (AST_NODE *stmtNode);
-void processGeneralNode (AST_NODE *node);
-void checkAssignOrExpr (AST_NODE *assignOrExprRelatedNode);
-void checkWhileStmt (AST_NODE *whileNode);
-void checkForStmt (AST_NODE *forNode);
-void checkAssignmentStmt (AST_NODE *assignmentNode);
-void checkIfStmt (AST_NODE *ifNode);
-void checkWriteFunction (AST_NODE *functionCallNode);
-void checkFunctionCall (AST_NODE *functionCallNode);
-void processExprRelatedNode (AST_NODE *exprRelatedNode);
-void checkParameterPassing (Parameter *formalParameter, AST_NODE *actualParameter);
-void checkReturnStmt (AST_NODE *returnNode);
-void processExprNode (AST_NODE *exprNode);
-void processVariableLValue (AST_NODE *idNode);
-void processVariableRValue (AST_NODE *idNode);
-void processConstValueNode (AST_NODE *constValueNode);
+DATA_TYPE getBinaryResultType (BINARY_OPERATOR op, DATA_TYPE dataType1, DATA_TYPE dataType2);
+void processProgramNode (CompilerContext *ctx, AST_NODE *programNode);
+void processDeclarationNode (CompilerContext *ctx, AST_NODE *declarationNode);
+void declareIdList (CompilerContext *ctx, AST_NODE *typeNode, SymbolAttributeKind isVariableOrTypeAttribute, int ignoreArrayFirstDimSize);
+void declareFunction (CompilerContext *ctx, AST_NODE *returnTypeNode);
+void processDeclDimList (CompilerContext *ctx, AST_NODE *variableDeclDimList, TypeDescriptor *typeDescriptor, int ignoreFirstDimSize);
+void processTypeNode (CompilerContext *ctx, AST_NODE *typeNode);
+void processBlockNode (CompilerContext *ctx, AST_NODE *blockNode);
+void processStmtNode (CompilerContext *ctx, AST_NODE *stmtNode);
+void processGeneralNode (CompilerContext *ctx, AST_NODE *node);
+void checkAssignOrExpr (CompilerContext *ctx, AST_NODE *assignOrExprRelatedNode);
+void checkWhileStmt (CompilerContext *ctx, AST_NODE *whileNode);
+void checkForStmt (CompilerContext *ctx, AST_NODE *forNode);
+void checkAssignmentStmt (CompilerContext *ctx, AST_NODE *assignmentNode);
+void checkIfStmt (CompilerContext *ctx, AST_NODE *ifNode);
+void checkWriteFunction (CompilerContext *ctx, AST_NODE *functionCallNode);
+void checkFunctionCall (CompilerContext *ctx, AST_NODE *functionCallNode);
+void processExprRelatedNode (CompilerContext *ctx, AST_NODE *exprRelatedNode);
+void checkParameterPassing (CompilerContext *ctx, Parameter *formalParameter, AST_NODE *actualParameter);
+void checkReturnStmt (CompilerContext *ctx, AST_NODE *returnNode);
+void processExprNode (CompilerContext *ctx, AST_NODE *exprNode);
+void processVariableLValue (CompilerContext *ctx, AST_NODE *idNode);
+void processVariableRValue (CompilerContext *ctx, AST_NODE *idNode);
+void processConstValueNode (CompilerContext *ctx, AST_NODE *constValueNode);
 void getExprOrConstValue (AST_NODE *exprOrConstNode, int *iValue, float *fValue);
-void evaluateExprValue (AST_NODE *exprNode);
+void evaluateExprValue (CompilerContext *ctx, AST_NODE *exprNode);
 
 
 typedef enum ErrorMsgKind {
@@ -62,148 +62,150 @@ typedef enum ErrorMsgKind {
 } ErrorMsgKind;
 
 
-void printErrorMsgSpecial (AST_NODE *node1, char *name2, ErrorMsgKind errorMsgKind) {
-    g_anyErrorOccur = 1;
-    printf("Error found in line %d\n", node1->linenumber);
+void printErrorMsgSpecial (CompilerContext *ctx, AST_NODE *node1, char *name2, ErrorMsgKind errorMsgKind) {
+    ctx->anyErrorOccur = 1;
+    ctx->errorCount++;
+    fprintf(ctx->diagnostics, "Error found in line %d\n", node1->linenumber);
     switch (errorMsgKind) {
         case PASS_ARRAY_TO_SCALAR:
-            printf ("Array \'%s\' passed to scalar parameter \'%s\'.\n",
+            fprintf(ctx->diagnostics, "Array \'%s\' passed to scalar parameter \'%s\'.\n",
                 node1->semantic_value.identifierSemanticValue.identifierName,
                 name2);
             break;
 
         case PASS_SCALAR_TO_ARRAY:
-            printf("Scalar \'%s\' passed to array parameter \'%s\'.\n",
+            fprintf(ctx->diagnostics, "Scalar \'%s\' passed to array parameter \'%s\'.\n",
                 node1->semantic_value.identifierSemanticValue.identifierName,
                 name2);
             break;
 
         default:
-            printf("Unhandled case in void printErrorMsg(AST_NODE *node, ERROR_MSG_KIND *errorMsgKind)\n");
+            fprintf(ctx->diagnostics, "Unhandled case in void printErrorMsg(AST_NODE *node, ERROR_MSG_KIND *errorMsgKind)\n");
             break;
     }
 }
 
 
-void printErrorMsg (AST_NODE *node, ErrorMsgKind errorMsgKind) {
-    g_anyErrorOccur = 1;
-    printf("Error found in line %d\n", node->linenumber);
+void printErrorMsg (CompilerContext *ctx, AST_NODE *node, ErrorMsgKind errorMsgKind) {
+    ctx->anyErrorOccur = 1;
+    ctx->errorCount++;
+    fprintf(ctx->diagnostics, "Error found in line %d\n", node->linenumber);
     switch (errorMsgKind) {
         case SYMBOL_IS_NOT_TYPE:
-            printf("ID \'%s\' is not a type name.\n",
+            fprintf(ctx->diagnostics, "ID \'%s\' is not a type name.\n",
                 node->semantic_value.identifierSemanticValue.identifierName);
             break;
 
         case SYMBOL_REDECLARE:
-            printf("ID \'%s\' redeclared.\n",
+            fprintf(ctx->diagnostics, "ID \'%s\' redeclared.\n",
                 node->semantic_value.identifierSemanticValue.identifierName);
             break;
 
         case SYMBOL_UNDECLARED:
-            printf("ID \'%s\' undeclared.\n",
+            fprintf(ctx->diagnostics, "ID \'%s\' undeclared.\n",
                 node->semantic_value.identifierSemanticValue.identifierName);
             break;
 
         case NOT_FUNCTION_NAME:
-            printf("ID \'%s\' is not a function.\n",
+            fprintf(ctx->diagnostics, "ID \'%s\' is not a function.\n",
                 node->semantic_value.identifierSemanticValue.identifierName);
             break;
 
         case TRY_TO_INIT_ARRAY:
-            printf("Cannot initialize array \'%s\'.\n",
+            fprintf(ctx->diagnostics, "Cannot initialize array \'%s\'.\n",
                 node->semantic_value.identifierSemanticValue.identifierName);
             break;
 
         case EXCESSIVE_ARRAY_DIM_DECLARATION:
-            printf("ID \'%s\' array dimension cannot be greater than %d\n",
+            fprintf(ctx->diagnostics, "ID \'%s\' array dimension cannot be greater than %d\n",
                 node->semantic_value.identifierSemanticValue.identifierName,
                 MAX_ARRAY_DIMENSION);
             break;
 
         case RETURN_ARRAY:
-            printf("Function \'%s\' cannot return array.\n",
+            fprintf(ctx->diagnostics, "Function \'%s\' cannot return array.\n",
                 node->rightSibling->semantic_value.identifierSemanticValue.identifierName);
             break;
 
         case VOID_VARIABLE:
-            printf("Type \'%s\' cannot be a variable's type.\n",
+            fprintf(ctx->diagnostics, "Type \'%s\' cannot be a variable's type.\n",
                 node->semantic_value.identifierSemanticValue.identifierName);
             break;
 
         case TYPEDEF_VOID_ARRAY:
-            printf("Declaration of \'%s\' as array of voids.\n",
+            fprintf(ctx->diagnostics, "Declaration of \'%s\' as array of voids.\n",
                 node->semantic_value.identifierSemanticValue.identifierName);
             break;
 
         case PARAMETER_TYPE_UNMATCH:
-            printf("Parameter is incompatible with parameter type.\n");
+            fprintf(ctx->diagnostics, "Parameter is incompatible with parameter type.\n");
             break;
 
         case TOO_FEW_ARGUMENTS:
-            printf("too few arguments to function \'%s\'.\n",
+            fprintf(ctx->diagnostics, "too few arguments to function \'%s\'.\n",
                 node->semantic_value.identifierSemanticValue.identifierName);
             break;
 
         case TOO_MANY_ARGUMENTS:
-            printf("too many arguments to function \'%s\'.\n",
+            fprintf(ctx->diagnostics, "too many arguments to function \'%s\'.\n",
                 node->semantic_value.identifierSemanticValue.identifierName);
             break;
 
         case RETURN_TYPE_UNMATCH:
-            printf("Incompatible return type.\n");
+            fprintf(ctx->diagnostics, "Incompatible return type.\n");
             break;
 
         case INCOMPATIBLE_ARRAY_DIMENSION:
-            printf("Incompatible array dimensions.\n");
+            fprintf(ctx->diagnostics, "Incompatible array dimensions.\n");
             break;
 
         case NOT_ASSIGNABLE:
-            printf("ID \'%s\' is not assignable.\n",
+            fprintf(ctx->diagnostics, "ID \'%s\' is not assignable.\n",
                 node->semantic_value.identifierSemanticValue.identifierName);
             break;
 
         case NOT_ARRAY:
-            printf("ID \'%s\' is not array.\n",
+            fprintf(ctx->diagnostics, "ID \'%s\' is not array.\n",
                 node->semantic_value.identifierSemanticValue.identifierName);
             break;
 
         case IS_TYPE_NOT_VARIABLE:
-            printf("ID \'%s\' is a type, not a variable's name.\n",
+            fprintf(ctx->diagnostics, "ID \'%s\' is a type, not a variable's name.\n",
                 node->semantic_value.identifierSemanticValue.identifierName);
             break;
 
         case IS_FUNCTION_NOT_VARIABLE:
-            printf("ID \'%s\' is a function, not a variable's name.\n",
+            fprintf(ctx->diagnostics, "ID \'%s\' is a function, not a variable's name.\n",
                 node->semantic_value.identifierSemanticValue.identifierName);
             break;
 
         case STRING_OPERATION:
-            printf("String operation is unsupported.\n");
+            fprintf(ctx->diagnostics, "String operation is unsupported.\n");
             break;
 
         case ARRAY_SIZE_NOT_INT:
-            printf("Size of array \'%s\' has non-integer type.\n",
+            fprintf(ctx->diagnostics, "Size of array \'%s\' has non-integer type.\n",
                 node->semantic_value.identifierSemanticValue.identifierName);
             break;
 
         case ARRAY_SIZE_NEGATIVE:
-            printf("Size of array \'%s\' is negative.\n",
+            fprintf(ctx->diagnostics, "Size of array \'%s\' is negative.\n",
                 node->semantic_value.identifierSemanticValue.identifierName);
             break;
 
         case ARRAY_SUBSCRIPT_NOT_INT:
-            printf("Array subscript is not an integer.\n");
+            fprintf(ctx->diagnostics, "Array subscript is not an integer.\n");
             break;
 
         default:
-            printf("Unhandled case in void printErrorMsg(AST_NODE* node, ERROR_MSG_KIND* errorMsgKind)\n");
+            fprintf(ctx->diagnostics, "Unhandled case in void printErrorMsg(AST_NODE* node, ERROR_MSG_KIND* errorMsgKind)\n");
             break;
         }
 }
 
 
-void semanticAnalysis (AST_NODE *root) {
-    processProgramNode(root);
+void semanticAnalysis (CompilerContext *ctx, AST_NODE *root) {
+    processProgramNode(ctx, root);
 }
 
 
@@ -217,15 +219,29 @@ DATA_TYPE getBiggerType (DATA_TYPE dataType1, DATA_TYPE dataType2) {
 }
 
 
-void processProgramNode (AST_NODE *programNode) {
+// comparisons and logical operators give an int whatever they compare,
+// arithmetic gives the bigger type of its operands
+DATA_TYPE getBinaryResultType (BINARY_OPERATOR op, DATA_TYPE dataType1, DATA_TYPE dataType2) {
+    switch (op) {
+        case BINARY_OP_ADD: case BINARY_OP_SUB:
+        case BINARY_OP_MUL: case BINARY_OP_DIV:
+            return getBiggerType(dataType1, dataType2);
+
+        default:
+            return INT_TYPE;
+    }
+}
+
+
+void processProgramNode (CompilerContext *ctx, AST_NODE *programNode) {
     AST_NODE *traverseDeclaration = programNode->child;
     while (traverseDeclaration) {
         if (traverseDeclaration->nodeType == VARIABLE_DECL_LIST_NODE) {
-            processGeneralNode(traverseDeclaration);
+            processGeneralNode(ctx, traverseDeclaration);
         }
         else {
             //function declaration
-            processDeclarationNode(traverseDeclaration);
+            processDeclarationNode(ctx, traverseDeclaration);
         }
 
 
@@ -238,9 +254,9 @@ void processProgramNode (AST_NODE *programNode) {
 }
 
 
-void processDeclarationNode (AST_NODE *declarationNode) {
+void processDeclarationNode (CompilerContext *ctx, AST_NODE *declarationNode) {
     AST_NODE *typeNode = declarationNode->child;
-    processTypeNode(typeNode);
+    processTypeNode(ctx, typeNode);
     if (typeNode->dataType == ERROR_TYPE) {
         declarationNode->dataType = ERROR_TYPE;
         return;
@@ -248,30 +264,30 @@ void processDeclarationNode (AST_NODE *declarationNode) {
 
     switch (declarationNode->semantic_value.declSemanticValue.kind) {
         case VARIABLE_DECL:
-            declareIdList(declarationNode, VARIABLE_ATTRIBUTE, 0);
+            declareIdList(ctx, declarationNode, VARIABLE_ATTRIBUTE, 0);
             break;
 
         case TYPE_DECL:
-            declareIdList(declarationNode, TYPE_ATTRIBUTE, 0);
+            declareIdList(ctx, declarationNode, TYPE_ATTRIBUTE, 0);
             break;
 
         case FUNCTION_DECL:
-            declareFunction(declarationNode);
+            declareFunction(ctx, declarationNode);
             break;
 
         case FUNCTION_PARAMETER_DECL:
-            declareIdList(declarationNode, VARIABLE_ATTRIBUTE, 1);
+            declareIdList(ctx, declarationNode, VARIABLE_ATTRIBUTE, 1);
             break;
 
     }
 }
 
 
-void processTypeNode (AST_NODE *idNodeAsType) {
-    SymbolTableEntry *symbolTableEntry = retrieveSymbol(idNodeAsType->semantic_value.identifierSemanticValue.identifierName);
+void processTypeNode (CompilerContext *ctx, AST_NODE *idNodeAsType) {
+    SymbolTableEntry *symbolTableEntry = retrieveSymbol(ctx, idNodeAsType->semantic_value.identifierSemanticValue.identifierName);
     if ((symbolTableEntry == NULL) ||
         (symbolTableEntry->attribute->attributeKind != TYPE_ATTRIBUTE)) {
-        printErrorMsg(idNodeAsType, SYMBOL_IS_NOT_TYPE);
+        printErrorMsg(ctx, idNodeAsType, SYMBOL_IS_NOT_TYPE);
         idNodeAsType->dataType = ERROR_TYPE;
     }
     else {
@@ -290,7 +306,7 @@ void processTypeNode (AST_NODE *idNodeAsType) {
 }
 
 
-void declareIdList (AST_NODE *declarationNode, SymbolAttributeKind isVariableOrTypeAttribute, int ignoreArrayFirstDimSize) {
+void declareIdList (CompilerContext *ctx, AST_NODE *declarationNode, SymbolAttributeKind isVariableOrTypeAttribute, int ignoreArrayFirstDimSize) {
     AST_NODE *typeNode = declarationNode->child;
     AST_NODE *traverseIDList = typeNode->rightSibling;
     TypeDescriptor *typeDescriptorOfTypeNode = typeNode->semantic_value.identifierSemanticValue.symbolTableEntry->attribute->attr.typeDescriptor;
@@ -298,19 +314,19 @@ void declareIdList (AST_NODE *declarationNode, SymbolAttributeKind isVariableOrT
     if ((isVariableOrTypeAttribute == VARIABLE_ATTRIBUTE) &&
        (typeDescriptorOfTypeNode->kind == SCALAR_TYPE_DESCRIPTOR) &&
        (typeDescriptorOfTypeNode->properties.dataType == VOID_TYPE)) {
-        printErrorMsg(typeNode, VOID_VARIABLE);
+        printErrorMsg(ctx, typeNode, VOID_VARIABLE);
         typeNode->dataType = ERROR_TYPE;
         return;
     }
 
     while (traverseIDList != NULL) {
-        if (declaredLocally(traverseIDList->semantic_value.identifierSemanticValue.identifierName)) {
-            printErrorMsg(traverseIDList, SYMBOL_REDECLARE);
+        if (declaredLocally(ctx, traverseIDList->semantic_value.identifierSemanticValue.identifierName)) {
+            printErrorMsg(ctx, traverseIDList, SYMBOL_REDECLARE);
             traverseIDList->dataType = ERROR_TYPE;
             declarationNode->dataType = ERROR_TYPE;
         }
         else {
-            SymbolAttribute *attribute = (SymbolAttribute *)malloc(sizeof(SymbolAttribute));
+            SymbolAttribute *attribute = (SymbolAttribute *)arenaAlloc(sizeof(SymbolAttribute));
             attribute->attributeKind = isVariableOrTypeAttribute;
             switch (traverseIDList->semantic_value.identifierSemanticValue.kind) {
                 case NORMAL_ID:
@@ -321,17 +337,16 @@ void declareIdList (AST_NODE *declarationNode, SymbolAttributeKind isVariableOrT
                     if((isVariableOrTypeAttribute == TYPE_ATTRIBUTE) &&
                        (typeDescriptorOfTypeNode->kind == SCALAR_TYPE_DESCRIPTOR) &&
                        (typeDescriptorOfTypeNode->properties.dataType == VOID_TYPE)) {
-                        printErrorMsg(traverseIDList, TYPEDEF_VOID_ARRAY);
+                        printErrorMsg(ctx, traverseIDList, TYPEDEF_VOID_ARRAY);
                         traverseIDList->dataType = ERROR_TYPE;
                         declarationNode->dataType = ERROR_TYPE;
                         break;
                     }
 
-                    attribute->attr.typeDescriptor = (TypeDescriptor *)malloc(sizeof(TypeDescriptor));
-                    processDeclDimList(traverseIDList, attribute->attr.typeDescriptor, ignoreArrayFirstDimSize);
+                    attribute->attr.typeDescriptor = (TypeDescriptor *)arenaAlloc(sizeof(TypeDescriptor));
+                    processDeclDimList(ctx, traverseIDList, attribute->attr.typeDescriptor, ignoreArrayFirstDimSize);
 
                     if (traverseIDList->dataType == ERROR_TYPE) {
-                        free(attribute->attr.typeDescriptor);
                         declarationNode->dataType = ERROR_TYPE;
                     }
                     else if (typeNode->semantic_value.identifierSemanticValue.symbolTableEntry->attribute->attr.typeDescriptor->kind == SCALAR_TYPE_DESCRIPTOR) {
@@ -342,8 +357,7 @@ void declareIdList (AST_NODE *declarationNode, SymbolAttributeKind isVariableOrT
                         int typeArrayDimension = typeNode->semantic_value.identifierSemanticValue.symbolTableEntry->attribute->attr.typeDescriptor->properties.arrayProperties.dimension;
                         int idArrayDimension = attribute->attr.typeDescriptor->properties.arrayProperties.dimension;
                         if ((typeArrayDimension + idArrayDimension) > MAX_ARRAY_DIMENSION) {
-                            printErrorMsg(traverseIDList, EXCESSIVE_ARRAY_DIM_DECLARATION);
-                            free(attribute->attr.typeDescriptor);
+                            printErrorMsg(ctx, traverseIDList, EXCESSIVE_ARRAY_DIM_DECLARATION);
                             traverseIDList->dataType = ERROR_TYPE;
                             declarationNode->dataType = ERROR_TYPE;
                         }
@@ -364,7 +378,7 @@ void declareIdList (AST_NODE *declarationNode, SymbolAttributeKind isVariableOrT
 
                 case WITH_INIT_ID:
                     if (typeNode->semantic_value.identifierSemanticValue.symbolTableEntry->attribute->attr.typeDescriptor->kind == ARRAY_TYPE_DESCRIPTOR) {
-                        printErrorMsg(traverseIDList, TRY_TO_INIT_ARRAY);
+                        printErrorMsg(ctx, traverseIDList, TRY_TO_INIT_ARRAY);
                         traverseIDList->dataType = ERROR_TYPE;
                         declarationNode->dataType = ERROR_TYPE;
                     }
@@ -374,18 +388,17 @@ void declareIdList (AST_NODE *declarationNode, SymbolAttributeKind isVariableOrT
                     break;
 
                 default:
-                    printf("Unhandle case in void declareIdList(AST_NODE *typeNode)\n");
+                    fprintf(ctx->diagnostics, "Unhandle case in void declareIdList(AST_NODE *typeNode)\n");
                     traverseIDList->dataType = ERROR_TYPE;
                     declarationNode->dataType = ERROR_TYPE;
                     break;
             }
             if (traverseIDList->dataType == ERROR_TYPE) {
-                free(attribute);
                 declarationNode->dataType = ERROR_TYPE;
             }
             else {
                 traverseIDList->semantic_value.identifierSemanticValue.symbolTableEntry =
-                    enterSymbol(traverseIDList->semantic_value.identifierSemanticValue.identifierName, attribute);
+                    enterSymbol(ctx, traverseIDList->semantic_value.identifierSemanticValue.identifierName, attribute);
             }
         }
         traverseIDList = traverseIDList->rightSibling;
@@ -393,46 +406,46 @@ void declareIdList (AST_NODE *declarationNode, SymbolAttributeKind isVariableOrT
 }
 
 
-void checkAssignOrExpr (AST_NODE *assignOrExprRelatedNode) {
+void checkAssignOrExpr (CompilerContext *ctx, AST_NODE *assignOrExprRelatedNode) {
     if (assignOrExprRelatedNode->nodeType == STMT_NODE) {
         if (assignOrExprRelatedNode->semantic_value.stmtSemanticValue.kind == ASSIGN_STMT) {
-            checkAssignmentStmt(assignOrExprRelatedNode);
+            checkAssignmentStmt(ctx, assignOrExprRelatedNode);
         }
         else if (assignOrExprRelatedNode->semantic_value.stmtSemanticValue.kind == FUNCTION_CALL_STMT) {
-            checkFunctionCall(assignOrExprRelatedNode);
+            checkFunctionCall(ctx, assignOrExprRelatedNode);
         }
     }
     else {
-        processExprRelatedNode(assignOrExprRelatedNode);
+        processExprRelatedNode(ctx, assignOrExprRelatedNode);
     }
 }
 
 
-void checkWhileStmt (AST_NODE *whileNode) {
-    processExprNode(whileNode->child);
-    processBlockNode(whileNode->child->rightSibling);
+void checkWhileStmt (CompilerContext *ctx, AST_NODE *whileNode) {
+    processExprNode(ctx, whileNode->child);
+    processBlockNode(ctx, whileNode->child->rightSibling);
 }
 
 
-void checkForStmt (AST_NODE *forNode) {
+void checkForStmt (CompilerContext *ctx, AST_NODE *forNode) {
     AST_NODE *initExpression      = forNode->child;
     AST_NODE *conditionExpression = forNode->child->rightSibling;
     AST_NODE *loopExpression      = forNode->child->rightSibling->rightSibling;
     AST_NODE *bodyNode            = forNode->child->rightSibling->rightSibling->rightSibling;
 
-    processGeneralNode(initExpression);
-    processGeneralNode(conditionExpression);
-    processGeneralNode(loopExpression);
-    processStmtNode(bodyNode);
+    processGeneralNode(ctx, initExpression);
+    processGeneralNode(ctx, conditionExpression);
+    processGeneralNode(ctx, loopExpression);
+    processStmtNode(ctx, bodyNode);
 }
 
 
-void checkAssignmentStmt (AST_NODE *assignmentNode ) {
+void checkAssignmentStmt (CompilerContext *ctx, AST_NODE *assignmentNode ) {
     AST_NODE *leftOp = assignmentNode->child;
     AST_NODE *rightOp = leftOp->rightSibling;
 
-    processVariableLValue(leftOp);
-    processExprRelatedNode(rightOp);
+    processVariableLValue(ctx, leftOp);
+    processExprRelatedNode(ctx, rightOp);
 
     if (leftOp->dataType == ERROR_TYPE ||
         rightOp->dataType == ERROR_TYPE) {
@@ -441,11 +454,11 @@ void checkAssignmentStmt (AST_NODE *assignmentNode ) {
 
     if (rightOp->dataType == INT_PTR_TYPE ||
         rightOp->dataType == FLOAT_PTR_TYPE) {
-        printErrorMsg(rightOp, INCOMPATIBLE_ARRAY_DIMENSION);
+        printErrorMsg(ctx, rightOp, INCOMPATIBLE_ARRAY_DIMENSION);
         assignmentNode->dataType = ERROR_TYPE;
     }
     else if (rightOp->dataType == CONST_STRING_TYPE) {
-        printErrorMsg(rightOp, STRING_OPERATION);
+        printErrorMsg(ctx, rightOp, STRING_OPERATION);
         assignmentNode->dataType = ERROR_TYPE;
     }
     else {
@@ -454,19 +467,19 @@ void checkAssignmentStmt (AST_NODE *assignmentNode ) {
 }
 
 
-void checkIfStmt (AST_NODE *ifNode) {
-    checkAssignOrExpr(ifNode->child);
-    processStmtNode(ifNode->child->rightSibling);
-    processStmtNode(ifNode->child->rightSibling->rightSibling);
+void checkIfStmt (CompilerContext *ctx, AST_NODE *ifNode) {
+    checkAssignOrExpr(ctx, ifNode->child);
+    processStmtNode(ctx, ifNode->child->rightSibling);
+    processStmtNode(ctx, ifNode->child->rightSibling->rightSibling);
 }
 
 
-void checkWriteFunction (AST_NODE *functionCallNode) {
+void checkWriteFunction (CompilerContext *ctx, AST_NODE *functionCallNode) {
     AST_NODE *functionIDNode      = functionCallNode->child;
     AST_NODE *actualParameterList = functionCallNode->child->rightSibling;
     AST_NODE *actualParameter     = functionCallNode->child->rightSibling->child;
 
-    processGeneralNode(actualParameterList);
+    processGeneralNode(ctx, actualParameterList);
 
 
     int actualParameterNumber = 0;
@@ -478,18 +491,18 @@ void checkWriteFunction (AST_NODE *functionCallNode) {
         else if (actualParameter->dataType != INT_TYPE &&
                  actualParameter->dataType != FLOAT_TYPE &&
                  actualParameter->dataType != CONST_STRING_TYPE) {
-            printErrorMsg(actualParameter, PARAMETER_TYPE_UNMATCH);
+            printErrorMsg(ctx, actualParameter, PARAMETER_TYPE_UNMATCH);
             functionCallNode->dataType = ERROR_TYPE;
         }
         actualParameter = actualParameter->rightSibling;
     }
 
     if (actualParameterNumber > 1) {
-        printErrorMsg(functionIDNode, TOO_MANY_ARGUMENTS);
+        printErrorMsg(ctx, functionIDNode, TOO_MANY_ARGUMENTS);
         functionCallNode->dataType = ERROR_TYPE;
     }
     else if (actualParameterNumber < 1) {
-        printErrorMsg(functionIDNode, TOO_FEW_ARGUMENTS);
+        printErrorMsg(ctx, functionIDNode, TOO_FEW_ARGUMENTS);
         functionCallNode->dataType = ERROR_TYPE;
     }
     else {
@@ -498,33 +511,33 @@ void checkWriteFunction (AST_NODE *functionCallNode) {
 }
 
 
-void checkFunctionCall (AST_NODE *functionCallNode) {
+void checkFunctionCall (CompilerContext *ctx, AST_NODE *functionCallNode) {
     AST_NODE *functionIDNode = functionCallNode->child;
 
     //special case
-    if (strcmp(functionIDNode->semantic_value.identifierSemanticValue.identifierName, "write") == 0) {
-        checkWriteFunction(functionCallNode);
+    if (functionIDNode->semantic_value.identifierSemanticValue.identifierName == ctx->internedWrite) {
+        checkWriteFunction(ctx, functionCallNode);
         return;
     }
 
-    SymbolTableEntry *symbolTableEntry = retrieveSymbol(functionIDNode->semantic_value.identifierSemanticValue.identifierName);
+    SymbolTableEntry *symbolTableEntry = retrieveSymbol(ctx, functionIDNode->semantic_value.identifierSemanticValue.identifierName);
     functionIDNode->semantic_value.identifierSemanticValue.symbolTableEntry = symbolTableEntry;
 
     if (symbolTableEntry == NULL) {
-        printErrorMsg(functionIDNode, SYMBOL_UNDECLARED);
+        printErrorMsg(ctx, functionIDNode, SYMBOL_UNDECLARED);
         functionIDNode->dataType = ERROR_TYPE;
         functionCallNode->dataType = ERROR_TYPE;
         return;
     }
     else if (symbolTableEntry->attribute->attributeKind != FUNCTION_SIGNATURE) {
-        printErrorMsg(functionIDNode, NOT_FUNCTION_NAME);
+        printErrorMsg(ctx, functionIDNode, NOT_FUNCTION_NAME);
         functionIDNode->dataType = ERROR_TYPE;
         functionCallNode->dataType = ERROR_TYPE;
         return;
     }
 
     AST_NODE *actualParameterList = functionIDNode->rightSibling;
-    processGeneralNode(actualParameterList);
+    processGeneralNode(ctx, actualParameterList);
 
     AST_NODE *actualParameter = actualParameterList->child;
     Parameter *formalParameter = symbolTableEntry->attribute->attr.functionSignature->parameterList;
@@ -535,7 +548,7 @@ void checkFunctionCall (AST_NODE *functionCallNode) {
             parameterPassingError = 1;
         }
         else {
-            checkParameterPassing(formalParameter, actualParameter);
+            checkParameterPassing(ctx, formalParameter, actualParameter);
             if (actualParameter->dataType == ERROR_TYPE) {
                 parameterPassingError = 1;
             }
@@ -548,11 +561,11 @@ void checkFunctionCall (AST_NODE *functionCallNode) {
         functionCallNode->dataType = ERROR_TYPE;
     }
     if (actualParameter != NULL) {
-        printErrorMsg(functionIDNode, TOO_MANY_ARGUMENTS);
+        printErrorMsg(ctx, functionIDNode, TOO_MANY_ARGUMENTS);
         functionCallNode->dataType = ERROR_TYPE;
     }
     else if (formalParameter != NULL) {
-        printErrorMsg(functionIDNode, TOO_FEW_ARGUMENTS);
+        printErrorMsg(ctx, functionIDNode, TOO_FEW_ARGUMENTS);
         functionCallNode->dataType = ERROR_TYPE;
     }
     else {
@@ -561,48 +574,48 @@ void checkFunctionCall (AST_NODE *functionCallNode) {
 }
 
 
-void checkParameterPassing (Parameter *formalParameter, AST_NODE *actualParameter) {
+void checkParameterPassing (CompilerContext *ctx, Parameter *formalParameter, AST_NODE *actualParameter) {
     int actualParameterIsPtr = 0;
     if (actualParameter->dataType == INT_PTR_TYPE || actualParameter->dataType == FLOAT_PTR_TYPE) {
         actualParameterIsPtr = 1;
     }
 
     if (formalParameter->type->kind == SCALAR_TYPE_DESCRIPTOR && actualParameterIsPtr) {
-        printErrorMsgSpecial(actualParameter, formalParameter->parameterName, PASS_ARRAY_TO_SCALAR);
+        printErrorMsgSpecial(ctx, actualParameter, formalParameter->parameterName, PASS_ARRAY_TO_SCALAR);
         actualParameter->dataType = ERROR_TYPE;
     }
     else if (formalParameter->type->kind == ARRAY_TYPE_DESCRIPTOR && !actualParameterIsPtr) {
-        printErrorMsgSpecial(actualParameter, formalParameter->parameterName, PASS_SCALAR_TO_ARRAY);
+        printErrorMsgSpecial(ctx, actualParameter, formalParameter->parameterName, PASS_SCALAR_TO_ARRAY);
         actualParameter->dataType = ERROR_TYPE;
     }
     else if (actualParameter->dataType == CONST_STRING_TYPE) {
-        printErrorMsg(actualParameter, PARAMETER_TYPE_UNMATCH);
+        printErrorMsg(ctx, actualParameter, PARAMETER_TYPE_UNMATCH);
         actualParameter->dataType = ERROR_TYPE;
     }
 
 }
 
 
-void processExprRelatedNode (AST_NODE *exprRelatedNode) {
+void processExprRelatedNode (CompilerContext *ctx, AST_NODE *exprRelatedNode) {
     switch (exprRelatedNode->nodeType) {
         case EXPR_NODE:
-            processExprNode(exprRelatedNode);
+            processExprNode(ctx, exprRelatedNode);
             break;
 
         case STMT_NODE:
-            checkFunctionCall(exprRelatedNode);
+            checkFunctionCall(ctx, exprRelatedNode);
             break;
 
         case IDENTIFIER_NODE:
-            processVariableRValue(exprRelatedNode);
+            processVariableRValue(ctx, exprRelatedNode);
             break;
 
         case CONST_VALUE_NODE:
-            processConstValueNode(exprRelatedNode);
+            processConstValueNode(ctx, exprRelatedNode);
             break;
 
         default:
-            printf("Unhandle case in void processExprRelatedNode(AST_NODE *exprRelatedNode)\n");
+            fprintf(ctx->diagnostics, "Unhandle case in void processExprRelatedNode(AST_NODE *exprRelatedNode)\n");
             exprRelatedNode->dataType = ERROR_TYPE;
             break;
     }
@@ -638,7 +651,7 @@ void getExprOrConstValue (AST_NODE *exprOrConstNode, int *iValue, float *fValue)
 }
 
 
-void evaluateExprValue (AST_NODE *exprNode) {
+void evaluateExprValue (CompilerContext *ctx, AST_NODE *exprNode) {
     if (exprNode->semantic_value.exprSemanticValue.kind == BINARY_OPERATION) {
         AST_NODE *leftOp = exprNode->child;
         AST_NODE *rightOp = leftOp->rightSibling;
@@ -699,7 +712,7 @@ void evaluateExprValue (AST_NODE *exprNode) {
                     break;
 
                 default:
-                    printf("Unhandled case in void evaluateExprValue(AST_NODE* exprNode)\n");
+                    fprintf(ctx->diagnostics, "Unhandled case in void evaluateExprValue(AST_NODE* exprNode)\n");
                     break;
             }
 
@@ -710,7 +723,8 @@ void evaluateExprValue (AST_NODE *exprNode) {
             float rightValue = 0;
             getExprOrConstValue(leftOp, NULL, &leftValue);
             getExprOrConstValue(rightOp, NULL, &rightValue);
-            exprNode->dataType = FLOAT_TYPE;
+            exprNode->dataType = getBinaryResultType(exprNode->semantic_value.exprSemanticValue.op.binaryOp,
+                                                     leftOp->dataType, rightOp->dataType);
             switch (exprNode->semantic_value.exprSemanticValue.op.binaryOp) {
                 case BINARY_OP_ADD:
                     exprNode->semantic_value.exprSemanticValue.constEvalValue.fValue = leftValue + rightValue;
@@ -729,39 +743,39 @@ void evaluateExprValue (AST_NODE *exprNode) {
                     break;
 
                 case BINARY_OP_EQ:
-                    exprNode->semantic_value.exprSemanticValue.constEvalValue.fValue = leftValue == rightValue;
+                    exprNode->semantic_value.exprSemanticValue.constEvalValue.iValue = leftValue == rightValue;
                     break;
 
                 case BINARY_OP_GE:
-                    exprNode->semantic_value.exprSemanticValue.constEvalValue.fValue = leftValue >= rightValue;
+                    exprNode->semantic_value.exprSemanticValue.constEvalValue.iValue = leftValue >= rightValue;
                     break;
 
                 case BINARY_OP_LE:
-                    exprNode->semantic_value.exprSemanticValue.constEvalValue.fValue = leftValue <= rightValue;
+                    exprNode->semantic_value.exprSemanticValue.constEvalValue.iValue = leftValue <= rightValue;
                     break;
 
                 case BINARY_OP_NE:
-                    exprNode->semantic_value.exprSemanticValue.constEvalValue.fValue = leftValue != rightValue;
+                    exprNode->semantic_value.exprSemanticValue.constEvalValue.iValue = leftValue != rightValue;
                     break;
 
                 case BINARY_OP_GT:
-                    exprNode->semantic_value.exprSemanticValue.constEvalValue.fValue = leftValue > rightValue;
+                    exprNode->semantic_value.exprSemanticValue.constEvalValue.iValue = leftValue > rightValue;
                     break;
 
                 case BINARY_OP_LT:
-                    exprNode->semantic_value.exprSemanticValue.constEvalValue.fValue = leftValue < rightValue;
+                    exprNode->semantic_value.exprSemanticValue.constEvalValue.iValue = leftValue < rightValue;
                     break;
 
                 case BINARY_OP_AND:
-                    exprNode->semantic_value.exprSemanticValue.constEvalValue.fValue = leftValue && rightValue;
+                    exprNode->semantic_value.exprSemanticValue.constEvalValue.iValue = leftValue && rightValue;
                     break;
 
                 case BINARY_OP_OR:
-                    exprNode->semantic_value.exprSemanticValue.constEvalValue.fValue = leftValue || rightValue;
+                    exprNode->semantic_value.exprSemanticValue.constEvalValue.iValue = leftValue || rightValue;
                     break;
 
                 default:
-                    printf("Unhandled case in void evaluateExprValue(AST_NODE* exprNode)\n");
+                    fprintf(ctx->diagnostics, "Unhandled case in void evaluateExprValue(AST_NODE* exprNode)\n");
                     break;
                 }
         }
@@ -786,7 +800,7 @@ void evaluateExprValue (AST_NODE *exprNode) {
                         break;
 
                     default:
-                        printf("Unhandled case in void evaluateExprValue(AST_NODE* exprNode)\n");
+                        fprintf(ctx->diagnostics, "Unhandled case in void evaluateExprValue(AST_NODE* exprNode)\n");
                         break;
                 }
         }
@@ -808,7 +822,7 @@ void evaluateExprValue (AST_NODE *exprNode) {
                     break;
 
                 default:
-                    printf("Unhandled case in void evaluateExprValue(AST_NODE* exprNode)\n");
+                    fprintf(ctx->diagnostics, "Unhandled case in void evaluateExprValue(AST_NODE* exprNode)\n");
                     break;
             }
         }
@@ -816,23 +830,23 @@ void evaluateExprValue (AST_NODE *exprNode) {
 }
 
 
-void processExprNode (AST_NODE *exprNode) {
+void processExprNode (CompilerContext *ctx, AST_NODE *exprNode) {
     if (exprNode->semantic_value.exprSemanticValue.kind == BINARY_OPERATION) {
         AST_NODE *leftOp = exprNode->child;
         AST_NODE *rightOp = leftOp->rightSibling;
-        processExprRelatedNode(leftOp);
-        processExprRelatedNode(rightOp);
+        processExprRelatedNode(ctx, leftOp);
+        processExprRelatedNode(ctx, rightOp);
         //special case
         if (leftOp->dataType == INT_PTR_TYPE || leftOp->dataType == FLOAT_PTR_TYPE) {
-            printErrorMsg(leftOp, INCOMPATIBLE_ARRAY_DIMENSION);
+            printErrorMsg(ctx, leftOp, INCOMPATIBLE_ARRAY_DIMENSION);
             exprNode->dataType = ERROR_TYPE;
         }
         if (rightOp->dataType == INT_PTR_TYPE || rightOp->dataType == FLOAT_PTR_TYPE) {
-            printErrorMsg(leftOp, INCOMPATIBLE_ARRAY_DIMENSION);
+            printErrorMsg(ctx, leftOp, INCOMPATIBLE_ARRAY_DIMENSION);
             exprNode->dataType = ERROR_TYPE;
         }
         if (leftOp->dataType == CONST_STRING_TYPE || rightOp->dataType == CONST_STRING_TYPE) {
-            printErrorMsg(exprNode, STRING_OPERATION);
+            printErrorMsg(ctx, exprNode, STRING_OPERATION);
             exprNode->dataType = ERROR_TYPE;
         }
         //
@@ -841,26 +855,27 @@ void processExprNode (AST_NODE *exprNode) {
         }
 
         if (exprNode->dataType != ERROR_TYPE) {
-            exprNode->dataType = getBiggerType(leftOp->dataType, rightOp->dataType);
+            exprNode->dataType = getBinaryResultType(exprNode->semantic_value.exprSemanticValue.op.binaryOp,
+                                                     leftOp->dataType, rightOp->dataType);
         }
 
         if ((exprNode->dataType != ERROR_TYPE) &&
             (leftOp->nodeType == CONST_VALUE_NODE || (leftOp->nodeType == EXPR_NODE && leftOp->semantic_value.exprSemanticValue.isConstEval)) &&
             (rightOp->nodeType == CONST_VALUE_NODE || (rightOp->nodeType == EXPR_NODE && rightOp->semantic_value.exprSemanticValue.isConstEval))) {
-            evaluateExprValue(exprNode);
+            evaluateExprValue(ctx, exprNode);
             exprNode->semantic_value.exprSemanticValue.isConstEval = 1;
         }
     }
     else {
         AST_NODE *operand = exprNode->child;
-        processExprRelatedNode(operand);
+        processExprRelatedNode(ctx, operand);
         //special case
         if (operand->dataType == INT_PTR_TYPE || operand->dataType == FLOAT_PTR_TYPE) {
-            printErrorMsg(operand, INCOMPATIBLE_ARRAY_DIMENSION);
+            printErrorMsg(ctx, operand, INCOMPATIBLE_ARRAY_DIMENSION);
             exprNode->dataType = ERROR_TYPE;
         }
         else if (operand->dataType == CONST_STRING_TYPE) {
-            printErrorMsg(exprNode, STRING_OPERATION);
+            printErrorMsg(ctx, exprNode, STRING_OPERATION);
             exprNode->dataType = ERROR_TYPE;
         }
         else if (operand->dataType == ERROR_TYPE) {
@@ -873,7 +888,7 @@ void processExprNode (AST_NODE *exprNode) {
 
         if ((exprNode->dataType != ERROR_TYPE) &&
             (operand->nodeType == CONST_VALUE_NODE || (operand->nodeType == EXPR_NODE && operand->semantic_value.exprSemanticValue.isConstEval))) {
-            evaluateExprValue(exprNode);
+            evaluateExprValue(ctx, exprNode);
             exprNode->semantic_value.exprSemanticValue.isConstEval = 1;
         }
 
@@ -881,22 +896,22 @@ void processExprNode (AST_NODE *exprNode) {
 }
 
 
-void processVariableLValue (AST_NODE *idNode) {
-    SymbolTableEntry *symbolTableEntry = retrieveSymbol(idNode->semantic_value.identifierSemanticValue.identifierName);
+void processVariableLValue (CompilerContext *ctx, AST_NODE *idNode) {
+    SymbolTableEntry *symbolTableEntry = retrieveSymbol(ctx, idNode->semantic_value.identifierSemanticValue.identifierName);
     if (!symbolTableEntry) {
-        printErrorMsg(idNode, SYMBOL_UNDECLARED);
+        printErrorMsg(ctx, idNode, SYMBOL_UNDECLARED);
         idNode->dataType = ERROR_TYPE;
         return;
     }
     idNode->semantic_value.identifierSemanticValue.symbolTableEntry = symbolTableEntry;
 
     if (symbolTableEntry->attribute->attributeKind == TYPE_ATTRIBUTE) {
-        printErrorMsg(idNode, IS_TYPE_NOT_VARIABLE);
+        printErrorMsg(ctx, idNode, IS_TYPE_NOT_VARIABLE);
         idNode->dataType = ERROR_TYPE;
         return;
     }
     else if (symbolTableEntry->attribute->attributeKind == FUNCTION_SIGNATURE) {
-        printErrorMsg(idNode, IS_FUNCTION_NOT_VARIABLE);
+        printErrorMsg(ctx, idNode, IS_FUNCTION_NOT_VARIABLE);
         idNode->dataType = ERROR_TYPE;
         return;
     }
@@ -905,8 +920,8 @@ void processVariableLValue (AST_NODE *idNode) {
 
     if (idNode->semantic_value.identifierSemanticValue.kind == NORMAL_ID) {
         if (typeDescriptor->kind == ARRAY_TYPE_DESCRIPTOR) {
-            //printErrorMsg(idNode, NOT_ASSIGNABLE);
-            printErrorMsg(idNode, INCOMPATIBLE_ARRAY_DIMENSION);
+            //printErrorMsg(ctx, idNode, NOT_ASSIGNABLE);
+            printErrorMsg(ctx, idNode, INCOMPATIBLE_ARRAY_DIMENSION);
             idNode->dataType = ERROR_TYPE;
         }
         else {
@@ -918,18 +933,18 @@ void processVariableLValue (AST_NODE *idNode) {
         AST_NODE *traverseDimList = idNode->child;
         while (traverseDimList) {
             ++dimension;
-            processExprRelatedNode(traverseDimList);
+            processExprRelatedNode(ctx, traverseDimList);
             if (traverseDimList->dataType == ERROR_TYPE) {
                 idNode->dataType = ERROR_TYPE;
             }
             else if (traverseDimList->dataType == FLOAT_TYPE) {
-                printErrorMsg(idNode, ARRAY_SUBSCRIPT_NOT_INT);
+                printErrorMsg(ctx, idNode, ARRAY_SUBSCRIPT_NOT_INT);
                 idNode->dataType = ERROR_TYPE;
             }
             traverseDimList = traverseDimList->rightSibling;
         }
         if (typeDescriptor->kind == SCALAR_TYPE_DESCRIPTOR) {
-            printErrorMsg(idNode, NOT_ARRAY);
+            printErrorMsg(ctx, idNode, NOT_ARRAY);
             idNode->dataType = ERROR_TYPE;
         }
         else {
@@ -937,25 +952,25 @@ void processVariableLValue (AST_NODE *idNode) {
                 idNode->dataType = typeDescriptor->properties.arrayProperties.elementType;
             }
             else {
-                printErrorMsg(idNode, INCOMPATIBLE_ARRAY_DIMENSION);
+                printErrorMsg(ctx, idNode, INCOMPATIBLE_ARRAY_DIMENSION);
                 idNode->dataType = ERROR_TYPE;
             }
         }
     }
 }
 
-void processVariableRValue (AST_NODE *idNode) {
-    SymbolTableEntry *symbolTableEntry = retrieveSymbol(idNode->semantic_value.identifierSemanticValue.identifierName);
+void processVariableRValue (CompilerContext *ctx, AST_NODE *idNode) {
+    SymbolTableEntry *symbolTableEntry = retrieveSymbol(ctx, idNode->semantic_value.identifierSemanticValue.identifierName);
 
     idNode->semantic_value.identifierSemanticValue.symbolTableEntry = symbolTableEntry;
     if (!symbolTableEntry) {
-        printErrorMsg(idNode, SYMBOL_UNDECLARED);
+        printErrorMsg(ctx, idNode, SYMBOL_UNDECLARED);
         idNode->dataType = ERROR_TYPE;
         return;
     }
 
     if (symbolTableEntry->attribute->attributeKind == TYPE_ATTRIBUTE) {
-        printErrorMsg(idNode, IS_TYPE_NOT_VARIABLE);
+        printErrorMsg(ctx, idNode, IS_TYPE_NOT_VARIABLE);
         idNode->dataType = ERROR_TYPE;
         return;
     }
@@ -977,7 +992,7 @@ void processVariableRValue (AST_NODE *idNode) {
     }
     else if (idNode->semantic_value.identifierSemanticValue.kind == ARRAY_ID) {
         if (typeDescriptor->kind == SCALAR_TYPE_DESCRIPTOR) {
-            printErrorMsg(idNode, NOT_ARRAY);
+            printErrorMsg(ctx, idNode, NOT_ARRAY);
             idNode->dataType = ERROR_TYPE;
         }
         else {
@@ -985,12 +1000,12 @@ void processVariableRValue (AST_NODE *idNode) {
             AST_NODE *traverseDimList = idNode->child;
             while (traverseDimList) {
                 ++dimension;
-                processExprRelatedNode(traverseDimList);
+                processExprRelatedNode(ctx, traverseDimList);
                 if (traverseDimList->dataType == ERROR_TYPE) {
                     idNode->dataType = ERROR_TYPE;
                 }
                 else if (traverseDimList->dataType == FLOAT_TYPE) {
-                    printErrorMsg(idNode, ARRAY_SUBSCRIPT_NOT_INT);
+                    printErrorMsg(ctx, idNode, ARRAY_SUBSCRIPT_NOT_INT);
                     idNode->dataType = ERROR_TYPE;
                 }
                 traverseDimList = traverseDimList->rightSibling;
@@ -1000,7 +1015,7 @@ void processVariableRValue (AST_NODE *idNode) {
                     idNode->dataType = typeDescriptor->properties.arrayProperties.elementType;
                 }
                 else if (dimension > typeDescriptor->properties.arrayProperties.dimension) {
-                    printErrorMsg(idNode, INCOMPATIBLE_ARRAY_DIMENSION);
+                    printErrorMsg(ctx, idNode, INCOMPATIBLE_ARRAY_DIMENSION);
                     idNode->dataType = ERROR_TYPE;
                 }
                 else if (typeDescriptor->properties.arrayProperties.elementType == INT_TYPE) {
@@ -1015,7 +1030,7 @@ void processVariableRValue (AST_NODE *idNode) {
 }
 
 
-void processConstValueNode (AST_NODE *constValueNode) {
+void processConstValueNode (CompilerContext *ctx, AST_NODE *constValueNode) {
     switch (constValueNode->semantic_value.const1->const_type) {
         case INTEGERC:
             constValueNode->dataType = INT_TYPE;
@@ -1034,14 +1049,14 @@ void processConstValueNode (AST_NODE *constValueNode) {
             break;
 
         default:
-            printf("Unhandle case in void processConstValueNode(AST_NODE* constValueNode)\n");
+            fprintf(ctx->diagnostics, "Unhandle case in void processConstValueNode(AST_NODE* constValueNode)\n");
             constValueNode->dataType = ERROR_TYPE;
             break;
     }
 }
 
 
-void checkReturnStmt (AST_NODE *returnNode) {
+void checkReturnStmt (CompilerContext *ctx, AST_NODE *returnNode) {
     AST_NODE *parentNode = returnNode->parent;
     DATA_TYPE returnType = NONE_TYPE;
     while (parentNode) {
@@ -1063,7 +1078,7 @@ void checkReturnStmt (AST_NODE *returnNode) {
         }
     }
     else {
-        processExprRelatedNode(returnNode->child);
+        processExprRelatedNode(ctx, returnNode->child);
         if (returnType != returnNode->child->dataType) {
             if (!((returnType == FLOAT_TYPE && returnNode->child->dataType == INT_TYPE) || (returnType == INT_TYPE && returnNode->child->dataType == FLOAT_TYPE))) {
                 errorOccur = 1;
@@ -1072,7 +1087,7 @@ void checkReturnStmt (AST_NODE *returnNode) {
     }
 
     if (errorOccur) {
-        printErrorMsg(returnNode, RETURN_TYPE_UNMATCH);
+        printErrorMsg(ctx, returnNode, RETURN_TYPE_UNMATCH);
         returnNode->dataType = ERROR_TYPE;
     }
     else {
@@ -1081,54 +1096,54 @@ void checkReturnStmt (AST_NODE *returnNode) {
 }
 
 
-void processBlockNode (AST_NODE *blockNode) {
-    openScope();
+void processBlockNode (CompilerContext *ctx, AST_NODE *blockNode) {
+    openScope(ctx);
 
     AST_NODE *traverseListNode = blockNode->child;
     while (traverseListNode) {
-        processGeneralNode(traverseListNode);
+        processGeneralNode(ctx, traverseListNode);
         traverseListNode = traverseListNode->rightSibling;
     }
 
-    closeScope();
+    closeScope(ctx);
 }
 
 
-void processStmtNode (AST_NODE *stmtNode) {
+void processStmtNode (CompilerContext *ctx, AST_NODE *stmtNode) {
     if (stmtNode->nodeType == NUL_NODE) {
         return;
     }
     else if (stmtNode->nodeType == BLOCK_NODE) {
-        processBlockNode(stmtNode);
+        processBlockNode(ctx, stmtNode);
     }
     else {
         switch (stmtNode->semantic_value.stmtSemanticValue.kind) {
             case WHILE_STMT:
-                checkWhileStmt(stmtNode);
+                checkWhileStmt(ctx, stmtNode);
                 break;
 
             case FOR_STMT:
-                checkForStmt(stmtNode);
+                checkForStmt(ctx, stmtNode);
                 break;
 
             case ASSIGN_STMT:
-                checkAssignmentStmt(stmtNode);
+                checkAssignmentStmt(ctx, stmtNode);
                 break;
 
             case IF_STMT:
-                checkIfStmt(stmtNode);
+                checkIfStmt(ctx, stmtNode);
                 break;
 
             case FUNCTION_CALL_STMT:
-                checkFunctionCall(stmtNode);
+                checkFunctionCall(ctx, stmtNode);
                 break;
 
             case RETURN_STMT:
-                checkReturnStmt(stmtNode);
+                checkReturnStmt(ctx, stmtNode);
                 break;
 
             default:
-                printf("Unhandle case in void processStmtNode(AST_NODE* stmtNode)\n");
+                fprintf(ctx->diagnostics, "Unhandle case in void processStmtNode(AST_NODE* stmtNode)\n");
                 stmtNode->dataType = ERROR_TYPE;
                 break;
         }
@@ -1136,12 +1151,12 @@ void processStmtNode (AST_NODE *stmtNode) {
 }
 
 
-void processGeneralNode (AST_NODE *node) {
+void processGeneralNode (CompilerContext *ctx, AST_NODE *node) {
     AST_NODE *traverseChildren = node->child;
     switch (node->nodeType) {
         case VARIABLE_DECL_LIST_NODE:
             while (traverseChildren) {
-                processDeclarationNode(traverseChildren);
+                processDeclarationNode(ctx, traverseChildren);
                 if (traverseChildren->dataType == ERROR_TYPE) {
                     node->dataType = ERROR_TYPE;
                 }
@@ -1151,7 +1166,7 @@ void processGeneralNode (AST_NODE *node) {
 
         case STMT_LIST_NODE:
             while (traverseChildren) {
-                processStmtNode(traverseChildren);
+                processStmtNode(ctx, traverseChildren);
                 if (traverseChildren->dataType == ERROR_TYPE) {
                     node->dataType = ERROR_TYPE;
                 }
@@ -1161,7 +1176,7 @@ void processGeneralNode (AST_NODE *node) {
 
         case NONEMPTY_ASSIGN_EXPR_LIST_NODE:
             while (traverseChildren) {
-                checkAssignOrExpr(traverseChildren);
+                checkAssignOrExpr(ctx, traverseChildren);
                 if (traverseChildren->dataType == ERROR_TYPE) {
                     node->dataType = ERROR_TYPE;
                 }
@@ -1171,7 +1186,7 @@ void processGeneralNode (AST_NODE *node) {
 
         case NONEMPTY_RELOP_EXPR_LIST_NODE:
             while (traverseChildren) {
-                processExprRelatedNode(traverseChildren);
+                processExprRelatedNode(ctx, traverseChildren);
                 if (traverseChildren->dataType == ERROR_TYPE) {
                     node->dataType = ERROR_TYPE;
                 }
@@ -1183,14 +1198,14 @@ void processGeneralNode (AST_NODE *node) {
             break;
 
         default:
-            printf("Unhandle case in void processGeneralNode(AST_NODE *node)\n");
+            fprintf(ctx->diagnostics, "Unhandle case in void processGeneralNode(AST_NODE *node)\n");
             node->dataType = ERROR_TYPE;
             break;
     }
 }
 
 
-void processDeclDimList (AST_NODE *idNode, TypeDescriptor *typeDescriptor, int ignoreFirstDimSize) {
+void processDeclDimList (CompilerContext *ctx, AST_NODE *idNode, TypeDescriptor *typeDescriptor, int ignoreFirstDimSize) {
     AST_NODE *variableDeclDimList = idNode->child;
     typeDescriptor->kind = ARRAY_TYPE_DESCRIPTOR;
     AST_NODE *traverseDim = variableDeclDimList;
@@ -1202,22 +1217,22 @@ void processDeclDimList (AST_NODE *idNode, TypeDescriptor *typeDescriptor, int i
     }
     while (traverseDim) {
         if (dimension >= MAX_ARRAY_DIMENSION) {
-            printErrorMsg(variableDeclDimList->parent, EXCESSIVE_ARRAY_DIM_DECLARATION);
+            printErrorMsg(ctx, variableDeclDimList->parent, EXCESSIVE_ARRAY_DIM_DECLARATION);
             idNode->dataType = ERROR_TYPE;
             break;
         }
 
-        processExprRelatedNode(traverseDim);
+        processExprRelatedNode(ctx, traverseDim);
         if (traverseDim->dataType == ERROR_TYPE) {
             idNode->dataType = ERROR_TYPE;
         }
         else if (traverseDim->dataType == FLOAT_TYPE) {
-            printErrorMsg(traverseDim->parent, ARRAY_SIZE_NOT_INT);
+            printErrorMsg(ctx, traverseDim->parent, ARRAY_SIZE_NOT_INT);
             idNode->dataType = ERROR_TYPE;
         }
         else if (traverseDim->semantic_value.exprSemanticValue.isConstEval &&
                  traverseDim->semantic_value.exprSemanticValue.constEvalValue.iValue < 0) {
-            printErrorMsg(traverseDim->parent, ARRAY_SIZE_NEGATIVE);
+            printErrorMsg(ctx, traverseDim->parent, ARRAY_SIZE_NEGATIVE);
             idNode->dataType = ERROR_TYPE;
         }
         else {
@@ -1233,50 +1248,50 @@ void processDeclDimList (AST_NODE *idNode, TypeDescriptor *typeDescriptor, int i
 }
 
 
-void declareFunction (AST_NODE *declarationNode) {
+void declareFunction (CompilerContext *ctx, AST_NODE *declarationNode) {
     AST_NODE *returnTypeNode = declarationNode->child;
 
     int errorOccur = 0;
     if (returnTypeNode->semantic_value.identifierSemanticValue.symbolTableEntry->attribute->attr.typeDescriptor->kind == ARRAY_TYPE_DESCRIPTOR) {
-        printErrorMsg(returnTypeNode, RETURN_ARRAY);
+        printErrorMsg(ctx, returnTypeNode, RETURN_ARRAY);
         returnTypeNode->dataType = ERROR_TYPE;
         errorOccur = 1;
     }
 
     AST_NODE *functionNameID = returnTypeNode->rightSibling;
-    if (declaredLocally(functionNameID->semantic_value.identifierSemanticValue.identifierName)) {
-        printErrorMsg(functionNameID, SYMBOL_REDECLARE);
+    if (declaredLocally(ctx, functionNameID->semantic_value.identifierSemanticValue.identifierName)) {
+        printErrorMsg(ctx, functionNameID, SYMBOL_REDECLARE);
         functionNameID->dataType = ERROR_TYPE;
         errorOccur = 1;
     }
 
     SymbolAttribute *attribute = NULL;
-    attribute = (SymbolAttribute *)malloc(sizeof(SymbolAttribute));
+    attribute = (SymbolAttribute *)arenaAlloc(sizeof(SymbolAttribute));
     attribute->attributeKind = FUNCTION_SIGNATURE;
-    attribute->attr.functionSignature = (FunctionSignature *)malloc(sizeof(FunctionSignature));
+    attribute->attr.functionSignature = (FunctionSignature *)arenaAlloc(sizeof(FunctionSignature));
     attribute->attr.functionSignature->returnType = returnTypeNode->dataType;
     attribute->attr.functionSignature->parameterList = NULL;
 
     int enterFunctionNameToSymbolTable = 0;
     if (!errorOccur) {
-        functionNameID->semantic_value.identifierSemanticValue.symbolTableEntry = enterSymbol(functionNameID->semantic_value.identifierSemanticValue.identifierName, attribute);
+        functionNameID->semantic_value.identifierSemanticValue.symbolTableEntry = enterSymbol(ctx, functionNameID->semantic_value.identifierSemanticValue.identifierName, attribute);
         enterFunctionNameToSymbolTable = 1;
     }
 
-    openScope();
+    openScope(ctx);
 
     AST_NODE *parameterListNode = functionNameID->rightSibling;
     AST_NODE *traverseParameter = parameterListNode->child;
     int parametersCount = 0;
     if (traverseParameter) {
         ++parametersCount;
-        processDeclarationNode(traverseParameter);
+        processDeclarationNode(ctx, traverseParameter);
         AST_NODE *parameterID = traverseParameter->child->rightSibling;
         if (traverseParameter->dataType == ERROR_TYPE) {
             errorOccur = 1;
         }
         else if (!errorOccur) {
-            Parameter *parameter = (Parameter *)malloc(sizeof(Parameter));
+            Parameter *parameter = (Parameter *)arenaAlloc(sizeof(Parameter));
             parameter->next = NULL;
             parameter->parameterName = parameterID->semantic_value.identifierSemanticValue.identifierName;
             parameter->type = parameterID->semantic_value.identifierSemanticValue.symbolTableEntry->attribute->attr.typeDescriptor;
@@ -1289,13 +1304,13 @@ void declareFunction (AST_NODE *declarationNode) {
 
     while (traverseParameter) {
         ++parametersCount;
-        processDeclarationNode(traverseParameter);
+        processDeclarationNode(ctx, traverseParameter);
         AST_NODE *parameterID = traverseParameter->child->rightSibling;
         if (traverseParameter->dataType == ERROR_TYPE) {
             errorOccur = 1;
         }
         else if (!errorOccur) {
-            Parameter *parameter = (Parameter *)malloc(sizeof(Parameter));
+            Parameter *parameter = (Parameter *)arenaAlloc(sizeof(Parameter));
             parameter->next = NULL;
             parameter->parameterName = parameterID->semantic_value.identifierSemanticValue.identifierName;
             parameter->type = parameterID->semantic_value.identifierSemanticValue.symbolTableEntry->attribute->attr.typeDescriptor;
@@ -1306,33 +1321,21 @@ void declareFunction (AST_NODE *declarationNode) {
     }
     attribute->attr.functionSignature->parametersCount = parametersCount;
 
-    if (errorOccur && (attribute != NULL)) {
-        Parameter *traverseParameter = attribute->attr.functionSignature->parameterList;
-        Parameter *next = NULL;
-        while (traverseParameter) {
-            next = traverseParameter->next;
-            free(traverseParameter);
-            traverseParameter = next;
-        }
-        free(attribute->attr.functionSignature);
-        free(attribute);
-    }
-
     if (!errorOccur) {
         AST_NODE *blockNode = parameterListNode->rightSibling;
         AST_NODE *traverseListNode = blockNode->child;
         while (traverseListNode) {
-            processGeneralNode(traverseListNode);
+            processGeneralNode(ctx, traverseListNode);
             traverseListNode = traverseListNode->rightSibling;
         }
     }
 
-    closeScope();
+    closeScope(ctx);
 
     if (errorOccur && enterFunctionNameToSymbolTable) {
         declarationNode->dataType = ERROR_TYPE;
         if (enterFunctionNameToSymbolTable) {
-            removeSymbol(functionNameID->semantic_value.identifierSemanticValue.identifierName);
+            removeSymbol(ctx, functionNameID->semantic_value.identifierSemanticValue.identifierName);
         }
     }
 }
@@ -0,0 +1,232 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "header.h"
+#include "libcmm.h"
+#include "server.h"
+
+
+// the protocol is in server.h. a request is compiled with cmm_compile() and
+// reuseMemory, so a connection's thread keeps its arena chunks from one
+// request to the next and frees everything else; memory stays flat however
+// many requests come. a header that can't be read ends the connection, as
+// there is no telling where the next request would start
+
+// larger sources are refused
+#define MAX_SOURCE_LENGTH (1 << 30)
+
+
+typedef struct Connection {
+    FILE *in;
+    FILE *out;
+    const cmm_options *defaults;
+} Connection;
+
+
+static void reply (FILE *out, const char *status, const char *assembly, size_t assemblyLength,
+                   const char *diagnostics, size_t diagnosticsLength, int errorCount) {
+    fprintf(out, "%s %zu %zu %d\n", status, assemblyLength, diagnosticsLength, errorCount);
+    fwrite(assembly, 1, assemblyLength, out);
+    fwrite(diagnostics, 1, diagnosticsLength, out);
+    fflush(out);
+}
+
+
+static void refuse (FILE *out, const char *why) {
+    reply(out, "error", "", 0, why, strlen(why), 1);
+}
+
+
+// read past a source that isn't compiled, 0 if the input ends first
+static int skipSource (FILE *in, unsigned long long length) {
+    char buffer[4096];
+
+    while (length > 0) {
+        size_t chunk = length < sizeof(buffer) ? (size_t)length : sizeof(buffer);
+        if (fread(buffer, 1, chunk, in) != chunk)
+            return 0;
+        length -= chunk;
+    }
+    return 1;
+}
+
+
+// the options after the length on top of the server's, 0 if there is one it
+// doesn't know
+static int parseOptions (char *words, const cmm_options *defaults, cmm_options *options) {
+    char *rest = NULL;
+    char *word;
+
+    *options = *defaults;
+    options->reuseMemory = 1;
+    for (word = strtok_r(words, " \t\r\n", &rest); word; word = strtok_r(NULL, " \t\r\n", &rest)) {
+        if (strcmp(word, "--buffered-io") == 0)
+            options->bufferedIO = 1;
+        else if (strcmp(word, "--batched-input") == 0)
+            options->batchedInput = 1;
+        else if (strcmp(word, "--descent-parser") == 0)
+            options->descentParser = 1;
+        else if (strcmp(word, "--threaded-lexer") == 0)
+            options->threadedLexer = 1;
+        else
+            return 0;
+    }
+    return 1;
+}
+
+
+static void serve (FILE *in, FILE *out, const cmm_options *defaults) {
+    char *header = NULL;
+    size_t headerCapacity = 0;
+    char *source = NULL;
+    size_t sourceCapacity = 0;
+
+    while (getline(&header, &headerCapacity, in) > 0) {
+        cmm_options options;
+        cmm_diagnostics diagnostics;
+        char *assembly;
+        size_t assemblyLength;
+        char *end;
+        unsigned long long length = strtoull(header, &end, 10);
+        int status;
+
+        if (end == header || length > MAX_SOURCE_LENGTH) {
+            refuse(out, "bad request header\n");
+            break;
+        }
+        if (length >= sourceCapacity) {
+            free(source);
+            sourceCapacity = length + 1;
+            source = (char *)malloc(sourceCapacity);
+            if (!source) {
+                // this request is refused, smaller ones can still be served
+                sourceCapacity = 0;
+                if (!skipSource(in, length)) {
+                    refuse(out, "source shorter than its length\n");
+                    break;
+                }
+                refuse(out, "out of memory\n");
+                continue;
+            }
+        }
+        if (fread(source, 1, length, in) != length) {
+            refuse(out, "source shorter than its length\n");
+            break;
+        }
+        // the source is read in any case, so the next request is found
+        if (!parseOptions(end, defaults, &options)) {
+            refuse(out, "unknown option\n");
+            continue;
+        }
+
+        status = cmm_compile(source, length, &options, &assembly, &assemblyLength, &diagnostics);
+        reply(out, status == 0 ? "ok" : "error", assembly ? assembly : "", assemblyLength,
+              diagnostics.text, diagnostics.length, diagnostics.errorCount);
+        free(assembly);
+        free(diagnostics.text);
+    }
+
+    arenaRelease();
+    free(header);
+    free(source);
+}
+
+
+static void *serveConnection (void *arg) {
+    Connection *connection = (Connection *)arg;
+
+    serve(connection->in, connection->out, connection->defaults);
+    fclose(connection->in);
+    fclose(connection->out);
+    free(connection);
+    return NULL;
+}
+
+
+// a stale socket from an earlier server is replaced, anything else at
+// `path` is left alone
+static int listenOn (const char *path) {
+    struct sockaddr_un address;
+    struct stat status;
+    int fd;
+
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        printf("socket path too long: %s\n", path);
+        return -1;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+
+    if (lstat(path, &status) == 0 && S_ISSOCK(status.st_mode))
+        unlink(path);
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(fd, 16) != 0) {
+        printf("cannot listen on %s\n", path);
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+
+int runServer (const char *socketPath, const cmm_options *defaults) {
+    int listener;
+
+    // a client that goes away shouldn't take the server with it
+    signal(SIGPIPE, SIG_IGN);
+
+    if (socketPath == NULL) {
+        serve(stdin, stdout, defaults);
+        return 0;
+    }
+
+    listener = listenOn(socketPath);
+    if (listener < 0)
+        return 1;
+    for (;;) {
+        Connection *connection;
+        pthread_t thread;
+        int fd = accept(listener, NULL, NULL);
+        int copy;
+
+        if (fd < 0)
+            continue;
+        // a connection that can't be set up is dropped, the others and the
+        // server go on
+        connection = (Connection *)calloc(1, sizeof(Connection));
+        copy = dup(fd);
+        if (!connection || copy < 0 ||
+            (connection->in = fdopen(fd, "r")) == NULL ||
+            (connection->out = fdopen(copy, "w")) == NULL) {
+            fprintf(stderr, "server: cannot set up a connection, dropped\n");
+            if (connection && connection->in)
+                fclose(connection->in);
+            else
+                close(fd);
+            if (copy >= 0)
+                close(copy);
+            free(connection);
+            continue;
+        }
+        connection->defaults = defaults;
+        if (pthread_create(&thread, NULL, serveConnection, connection) != 0) {
+            fprintf(stderr, "server: cannot start a connection thread, dropped\n");
+            fclose(connection->in);
+            fclose(connection->out);
+            free(connection);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef __SERVER_H__
+#define __SERVER_H__
+
+#include "libcmm.h"
+
+
+// --server: compile request after request until stdin ends, or with
+// `socketPath` accept connections on that Unix domain socket and serve each
+// on a thread of its own. the options of every request are added to
+// `defaults` (--cache), and every request is
+//
+//     <source length> [--buffered-io] [--batched-input] [--descent-parser] [--threaded-lexer]\n
+//     <the source>
+//
+// and gets the answer
+//
+//     ok|error <assembly length> <diagnostics length> <error count>\n
+//     <the assembly><the diagnostics>
+//
+// returns the exit status, 1 if the socket can't be set up
+int runServer (const char *socketPath, const cmm_options *defaults);
+
+
+#endif // __SERVER_H__
@@ -0,0 +1,101 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "sourceBuffer.h"
+
+
+// the scanner works in place on this buffer, it writes a NUL after every
+// lexeme and puts the character back afterwards, so the mapping is private
+// and writable. the bytes after the end of the file up to the end of its
+// last page read as zero, which gives the two NULs for free unless the
+// file ends at or within two bytes of a page boundary; such files, and files
+// that can't be mapped (pipes, empty files), are read into memory instead
+
+
+static char *readSource (int fd, size_t *size) {
+    size_t capacity = 1 << 16;
+    size_t length = 0;
+    char *text = (char *)malloc(capacity);
+
+    while (text) {
+        if (capacity - length < 2) {
+            char *bigger = (char *)realloc(text, capacity * 2);
+            if (!bigger) {
+                free(text);
+                return NULL;
+            }
+            text = bigger;
+            capacity *= 2;
+        }
+        ssize_t n = read(fd, text + length, capacity - length - 2);
+        if (n < 0) {
+            free(text);
+            return NULL;
+        }
+        if (n == 0)
+            break;
+        length += n;
+    }
+    if (!text)
+        return NULL;
+
+    text[length] = '\0';
+    text[length + 1] = '\0';
+    *size = length + 2;
+    return text;
+}
+
+
+char *copySource (const char *source, size_t length, size_t *size) {
+    char *text = (char *)malloc(length + 2);
+
+    if (!text)
+        return NULL;
+    memcpy(text, source, length);
+    text[length] = '\0';
+    text[length + 1] = '\0';
+    *size = length + 2;
+    return text;
+}
+
+
+char *loadSource (const char *path, size_t *size, int *mapped) {
+    struct stat info;
+    char *text;
+    long pageSize = sysconf(_SC_PAGESIZE);
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+        return NULL;
+
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && pageSize > 0 &&
+        info.st_size % pageSize != 0 && info.st_size % pageSize <= pageSize - 2) {
+        void *mapping = mmap(NULL, info.st_size + 2, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            close(fd);
+            *size = info.st_size + 2;
+            *mapped = 1;
+            return (char *)mapping;
+        }
+    }
+
+    text = readSource(fd, size);
+    *mapped = 0;
+    close(fd);
+    return text;
+}
+
+
+void releaseSource (char *text, size_t size, int mapped) {
+    if (mapped)
+        munmap(text, size);
+    else
+        free(text);
+}
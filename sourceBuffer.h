@@ -0,0 +1,21 @@
+#ifndef __SOURCE_BUFFER_H__
+#define __SOURCE_BUFFER_H__
+
+#include <stddef.h>
+
+
+// the whole source file in memory followed by the two NUL bytes that
+// yy_scan_buffer() wants, `*size` counts them. the file is mapped, not read,
+// when that is possible, `*mapped` tells which. NULL if the file can't be
+// opened
+char *loadSource (const char *path, size_t *size, int *mapped);
+
+// the same for `length` bytes in memory, always a copy (`mapped` 0)
+char *copySource (const char *source, size_t length, size_t *size);
+
+// unmap or free what loadSource() or copySource() returned, the lexemes
+// pointing into it have to be interned or copied by then
+void releaseSource (char *text, size_t size, int mapped);
+
+
+#endif // __SOURCE_BUFFER_H__
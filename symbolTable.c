@@ -1,23 +1,143 @@
 #include "symbolTable.h"
+#include "compilerContext.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 
-int HASH (char *str) {
-	int idx = 0;
-	while (*str) {
-		idx = idx << 1;
-		idx += *str;
-		str++;
-	}
-	return (idx & (HASH_TABLE_SIZE-1));
+// FNV-1a over the characters, then the murmur3 finalizer so that names
+// differing only in their last characters (var_0001, var_0002, ...) spread
+// over the low bits the tables index with
+static unsigned int hashName (const char *str, size_t length) {
+    unsigned int hash = 2166136261u;
+    while (length--) {
+        hash ^= (unsigned char)*str;
+        hash *= 16777619u;
+        str++;
+    }
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+unsigned int HASH (char *str) {
+    return hashName(str, strlen(str));
+}
+
+
+// identifier interning
+//
+// every distinct identifier is stored once, in the arena, right after its
+// hash. the lexer interns the IDs it reads, so the symbol table never
+// hashes a name again and compares names by pointer
+
+typedef struct InternedName {
+    struct InternedName *next;
+    unsigned int hash;
+    char name[];
+} InternedName;
+
+static void growInternTable (CompilerContext *ctx) {
+    int newSize = ctx->internTableSize ? ctx->internTableSize * 2 : 1024;
+    InternedName **newTable = (InternedName **)calloc(newSize, sizeof(InternedName *));
+    int index;
+
+    if (!newTable) {
+        // a full table still works, its chains just get longer
+        if (ctx->internTable)
+            return;
+        compileFailed(ctx, "out of memory");
+    }
+    for (index = 0; index < ctx->internTableSize; ++index) {
+        InternedName *entry = ctx->internTable[index];
+        while (entry) {
+            InternedName *next = entry->next;
+            entry->next = newTable[entry->hash & (newSize - 1)];
+            newTable[entry->hash & (newSize - 1)] = entry;
+            entry = next;
+        }
+    }
+    free(ctx->internTable);
+    ctx->internTable = newTable;
+    ctx->internTableSize = newSize;
+}
+
+
+void initializeInternTable (CompilerContext *ctx) {
+    if (ctx->internTable) {
+        return;
+    }
+    growInternTable(ctx);
+    ctx->internedInt = internName(ctx, SYMBOL_TABLE_INT_NAME);
+    ctx->internedFloat = internName(ctx, SYMBOL_TABLE_FLOAT_NAME);
+    ctx->internedVoid = internName(ctx, SYMBOL_TABLE_VOID_NAME);
+    ctx->internedRead = internName(ctx, SYMBOL_TABLE_SYS_LIB_READ);
+    ctx->internedFread = internName(ctx, SYMBOL_TABLE_SYS_LIB_FREAD);
+    ctx->internedWrite = internName(ctx, SYMBOL_TABLE_SYS_LIB_WRITE);
+    ctx->internedMain = internName(ctx, SYMBOL_TABLE_MAIN_NAME);
+}
+
+
+// `name` doesn't have to end after `length` characters, the lexer hands in
+// slices of the source buffer
+char *internSlice (CompilerContext *ctx, const char *name, size_t length) {
+    unsigned int hash;
+    InternedName *entry;
+
+    if (ctx->internTable == NULL) {
+        initializeInternTable(ctx);
+    }
+
+    hash = hashName(name, length);
+    for (entry = ctx->internTable[hash & (ctx->internTableSize - 1)]; entry; entry = entry->next) {
+        if (entry->hash == hash && memcmp(entry->name, name, length) == 0 && entry->name[length] == '\0') {
+            return entry->name;
+        }
+    }
+
+    if (ctx->internedCount >= ctx->internTableSize) {
+        growInternTable(ctx);
+    }
+    entry = (InternedName *)arenaAlloc(sizeof(InternedName) + length + 1);
+    entry->hash = hash;
+    memcpy(entry->name, name, length);
+    entry->name[length] = '\0';
+    entry->next = ctx->internTable[hash & (ctx->internTableSize - 1)];
+    ctx->internTable[hash & (ctx->internTableSize - 1)] = entry;
+    ++ctx->internedCount;
+    return entry->name;
 }
 
-int ARoffset = -4;
-SymbolTable symbolTable;
+
+char *internName (CompilerContext *ctx, const char *name) {
+    return internSlice(ctx, name, strlen(name));
+}
+
+
+unsigned int internedHash (const char *name) {
+    return ((const InternedName *)(name - offsetof(InternedName, name)))->hash;
+}
+
+
+// the names live in the arena, which is released after the compilation
+static void internTableEnd (CompilerContext *ctx) {
+    free(ctx->internTable);
+    ctx->internTable = NULL;
+    ctx->internTableSize = 0;
+    ctx->internedCount = 0;
+    ctx->internedInt = ctx->internedFloat = ctx->internedVoid = NULL;
+    ctx->internedRead = ctx->internedFread = ctx->internedWrite = ctx->internedMain = NULL;
+}
+
+
+static int bucketOf (CompilerContext *ctx, const char *name) {
+    return internedHash(name) & (ctx->symbolTable.hashTableSize - 1);
+}
 
 SymbolTableEntry *newSymbolTableEntry (int nestingLevel) {
-    SymbolTableEntry *symbolTableEntry = (SymbolTableEntry *)malloc(sizeof(SymbolTableEntry));
+    SymbolTableEntry *symbolTableEntry = (SymbolTableEntry *)arenaAlloc(sizeof(SymbolTableEntry));
     symbolTableEntry->nextInHashChain = NULL;
     symbolTableEntry->prevInHashChain = NULL;
     symbolTableEntry->nextInSameLevel = NULL;
@@ -28,12 +148,12 @@ SymbolTableEntry *newSymbolTableEntry (int nestingLevel) {
     return symbolTableEntry;
 }
 
-void removeFromHashTrain (int hashIndex, SymbolTableEntry *entry) {
+void removeFromHashTrain (CompilerContext *ctx, int hashIndex, SymbolTableEntry *entry) {
     if (entry->prevInHashChain) {
         entry->prevInHashChain->nextInHashChain = entry->nextInHashChain;
     }
     else {
-        symbolTable.hashTable[hashIndex] = entry->nextInHashChain;
+        ctx->symbolTable.hashTable[hashIndex] = entry->nextInHashChain;
     }
 
 
@@ -43,79 +163,124 @@ void removeFromHashTrain (int hashIndex, SymbolTableEntry *entry) {
 
     entry->nextInHashChain = NULL;
     entry->prevInHashChain = NULL;
+    --ctx->symbolTable.hashEntryCount;
 }
 
-void enterIntoHashTrain (int hashIndex, SymbolTableEntry *entry) {
-    SymbolTableEntry *chainHead = symbolTable.hashTable[hashIndex];
+void enterIntoHashTrain (CompilerContext *ctx, int hashIndex, SymbolTableEntry *entry) {
+    SymbolTableEntry *chainHead = ctx->symbolTable.hashTable[hashIndex];
     if (chainHead) {
         chainHead->prevInHashChain = entry;
         entry->nextInHashChain = chainHead;
     }
-    symbolTable.hashTable[hashIndex] = entry;
+    ctx->symbolTable.hashTable[hashIndex] = entry;
+    ++ctx->symbolTable.hashEntryCount;
 }
 
-void initializeSymbolTable (void) {
-    symbolTable.currentLevel = 0;
-    symbolTable.scopeDisplayElementCount = 10;
-    symbolTable.scopeDisplay = (SymbolTableEntry **)malloc(symbolTable.scopeDisplayElementCount * sizeof(SymbolTableEntry *));
+
+static SymbolTableEntry **newHashTable (int size) {
+    return (SymbolTableEntry **)calloc(size, sizeof(SymbolTableEntry *));
+}
+
+
+// only the visible names are in the chains, the ones they shadow hang off
+// sameNameInOuterLevel and move with them
+static void growHashTable (CompilerContext *ctx) {
+    SymbolTableEntry **oldHashTable = ctx->symbolTable.hashTable;
+    int oldSize = ctx->symbolTable.hashTableSize;
+    SymbolTableEntry **hashTable = newHashTable(oldSize * 2);
     int index = 0;
-    for (index = 0; index != symbolTable.scopeDisplayElementCount; ++index) {
-        symbolTable.scopeDisplay[index] = NULL;
+
+    // without memory the table stays as it is, with longer chains
+    if (!hashTable)
+        return;
+    ctx->symbolTable.hashTableSize = oldSize * 2;
+    ctx->symbolTable.hashTable = hashTable;
+    ctx->symbolTable.hashEntryCount = 0;
+    for (index = 0; index != oldSize; ++index) {
+        SymbolTableEntry *entry = oldHashTable[index];
+        while (entry) {
+            SymbolTableEntry *next = entry->nextInHashChain;
+            entry->nextInHashChain = NULL;
+            entry->prevInHashChain = NULL;
+            enterIntoHashTrain(ctx, bucketOf(ctx, entry->name), entry);
+            entry = next;
+        }
     }
-    for (index = 0; index != HASH_TABLE_SIZE; ++index) {
-        symbolTable.hashTable[index] = NULL;
+    free(oldHashTable);
+}
+
+void initializeSymbolTable (CompilerContext *ctx) {
+    ctx->symbolTable.currentLevel = 0;
+    ctx->symbolTable.scopeDisplayElementCount = 10;
+    ctx->symbolTable.scopeDisplay = (SymbolTableEntry **)malloc(ctx->symbolTable.scopeDisplayElementCount * sizeof(SymbolTableEntry *));
+    if (!ctx->symbolTable.scopeDisplay)
+        compileFailed(ctx, "out of memory");
+    int index = 0;
+    for (index = 0; index != ctx->symbolTable.scopeDisplayElementCount; ++index) {
+        ctx->symbolTable.scopeDisplay[index] = NULL;
     }
+    ctx->symbolTable.hashTableSize = HASH_TABLE_INITIAL_SIZE;
+    ctx->symbolTable.hashTable = newHashTable(ctx->symbolTable.hashTableSize);
+    ctx->symbolTable.hashEntryCount = 0;
+    if (!ctx->symbolTable.hashTable)
+        compileFailed(ctx, "out of memory");
 
-    SymbolAttribute *intAttribute = (SymbolAttribute *)malloc(sizeof(SymbolAttribute));
+    SymbolAttribute *intAttribute = (SymbolAttribute *)arenaAlloc(sizeof(SymbolAttribute));
     intAttribute->attributeKind = TYPE_ATTRIBUTE;
-    intAttribute->attr.typeDescriptor = (TypeDescriptor *)malloc(sizeof(TypeDescriptor));
+    intAttribute->attr.typeDescriptor = (TypeDescriptor *)arenaAlloc(sizeof(TypeDescriptor));
     intAttribute->attr.typeDescriptor->kind = SCALAR_TYPE_DESCRIPTOR;
     intAttribute->attr.typeDescriptor->properties.dataType = INT_TYPE;
-    enterSymbol(SYMBOL_TABLE_INT_NAME, intAttribute);
+    enterSymbol(ctx, internName(ctx, SYMBOL_TABLE_INT_NAME), intAttribute);
 
-    SymbolAttribute *floatAttribute = (SymbolAttribute *)malloc(sizeof(SymbolAttribute));
+    SymbolAttribute *floatAttribute = (SymbolAttribute *)arenaAlloc(sizeof(SymbolAttribute));
     floatAttribute->attributeKind = TYPE_ATTRIBUTE;
-    floatAttribute->attr.typeDescriptor = (TypeDescriptor *)malloc(sizeof(TypeDescriptor));
+    floatAttribute->attr.typeDescriptor = (TypeDescriptor *)arenaAlloc(sizeof(TypeDescriptor));
     floatAttribute->attr.typeDescriptor->kind = SCALAR_TYPE_DESCRIPTOR;
     floatAttribute->attr.typeDescriptor->properties.dataType = FLOAT_TYPE;
-    enterSymbol(SYMBOL_TABLE_FLOAT_NAME, floatAttribute);
+    enterSymbol(ctx, internName(ctx, SYMBOL_TABLE_FLOAT_NAME), floatAttribute);
 
-    SymbolAttribute *voidAttribute = (SymbolAttribute *)malloc(sizeof(SymbolAttribute));
+    SymbolAttribute *voidAttribute = (SymbolAttribute *)arenaAlloc(sizeof(SymbolAttribute));
     voidAttribute->attributeKind = TYPE_ATTRIBUTE;
-    voidAttribute->attr.typeDescriptor = (TypeDescriptor *)malloc(sizeof(TypeDescriptor));
+    voidAttribute->attr.typeDescriptor = (TypeDescriptor *)arenaAlloc(sizeof(TypeDescriptor));
     voidAttribute->attr.typeDescriptor->kind = SCALAR_TYPE_DESCRIPTOR;
     voidAttribute->attr.typeDescriptor->properties.dataType = VOID_TYPE;
-    enterSymbol(SYMBOL_TABLE_VOID_NAME, voidAttribute);
+    enterSymbol(ctx, internName(ctx, SYMBOL_TABLE_VOID_NAME), voidAttribute);
 
     SymbolAttribute *readAttribute = NULL;
-    readAttribute = (SymbolAttribute *)malloc(sizeof(SymbolAttribute));
+    readAttribute = (SymbolAttribute *)arenaAlloc(sizeof(SymbolAttribute));
     readAttribute->attributeKind = FUNCTION_SIGNATURE;
-    readAttribute->attr.functionSignature = (FunctionSignature *)malloc(sizeof(FunctionSignature));
+    readAttribute->attr.functionSignature = (FunctionSignature *)arenaAlloc(sizeof(FunctionSignature));
     readAttribute->attr.functionSignature->returnType = INT_TYPE;
     readAttribute->attr.functionSignature->parameterList = NULL;
     readAttribute->attr.functionSignature->parametersCount = 0;
-    enterSymbol(SYMBOL_TABLE_SYS_LIB_READ, readAttribute);
+    enterSymbol(ctx, internName(ctx, SYMBOL_TABLE_SYS_LIB_READ), readAttribute);
 
     SymbolAttribute *freadAttribute = NULL;
-    freadAttribute = (SymbolAttribute *)malloc(sizeof(SymbolAttribute));
+    freadAttribute = (SymbolAttribute *)arenaAlloc(sizeof(SymbolAttribute));
     freadAttribute->attributeKind = FUNCTION_SIGNATURE;
-    freadAttribute->attr.functionSignature = (FunctionSignature *)malloc(sizeof(FunctionSignature));
+    freadAttribute->attr.functionSignature = (FunctionSignature *)arenaAlloc(sizeof(FunctionSignature));
     freadAttribute->attr.functionSignature->returnType = FLOAT_TYPE;
     freadAttribute->attr.functionSignature->parameterList = NULL;
     freadAttribute->attr.functionSignature->parametersCount = 0;
-    enterSymbol(SYMBOL_TABLE_SYS_LIB_FREAD, freadAttribute);
+    enterSymbol(ctx, internName(ctx, SYMBOL_TABLE_SYS_LIB_FREAD), freadAttribute);
 }
 
-void symbolTableEnd (void) {
-    // clean up
-    // xatier: clean up what?
+void symbolTableEnd (CompilerContext *ctx) {
+    // the entries and attributes are in the arena
+    free(ctx->symbolTable.scopeDisplay);
+    ctx->symbolTable.scopeDisplay = NULL;
+    ctx->symbolTable.scopeDisplayElementCount = 0;
+    free(ctx->symbolTable.hashTable);
+    ctx->symbolTable.hashTable = NULL;
+    ctx->symbolTable.hashTableSize = 0;
+    internTableEnd(ctx);
 }
 
-SymbolTableEntry *retrieveSymbol (char *symbolName) {
-    int hashIndex = HASH(symbolName);
-    SymbolTableEntry *hashChain = symbolTable.hashTable[hashIndex];
+SymbolTableEntry *retrieveSymbol (CompilerContext *ctx, char *symbolName) {
+    int hashIndex = bucketOf(ctx, symbolName);
+    SymbolTableEntry *hashChain = ctx->symbolTable.hashTable[hashIndex];
     while (hashChain) {
-        if (strcmp(hashChain->name, symbolName) == 0) {
+        if (hashChain->name == symbolName) {
             return hashChain;
         }
         else {
@@ -125,22 +290,24 @@ SymbolTableEntry *retrieveSymbol (char *symbolName) {
     return NULL;
 }
 
-SymbolTableEntry *enterSymbol (char *symbolName, SymbolAttribute *attribute) {
-    int hashIndex = HASH(symbolName);
-    SymbolTableEntry *hashChain = symbolTable.hashTable[hashIndex];
-    SymbolTableEntry *newEntry = newSymbolTableEntry(symbolTable.currentLevel);
+SymbolTableEntry *enterSymbol (CompilerContext *ctx, char *symbolName, SymbolAttribute *attribute) {
+    if (ctx->symbolTable.hashEntryCount >= ctx->symbolTable.hashTableSize / 4 * 3) {
+        growHashTable(ctx);
+    }
+    int hashIndex = bucketOf(ctx, symbolName);
+    SymbolTableEntry *hashChain = ctx->symbolTable.hashTable[hashIndex];
+    SymbolTableEntry *newEntry = newSymbolTableEntry(ctx->symbolTable.currentLevel);
     newEntry->attribute = attribute;
     newEntry->name = symbolName;
 
     while (hashChain) {
-        if (strcmp(hashChain->name, symbolName) == 0) {
-            if (hashChain->nestingLevel == symbolTable.currentLevel) {
-                printf("void enterSymbol(...): ID \'%s\' is redeclared(at the same level#%d).\n", symbolName, symbolTable.currentLevel);
-                free(newEntry);
+        if (hashChain->name == symbolName) {
+            if (hashChain->nestingLevel == ctx->symbolTable.currentLevel) {
+                fprintf(ctx->diagnostics, "void enterSymbol(...): ID \'%s\' is redeclared(at the same level#%d).\n", symbolName, ctx->symbolTable.currentLevel);
                 return NULL;
             }
             else {
-                removeFromHashTrain(hashIndex, hashChain);
+                removeFromHashTrain(ctx, hashIndex, hashChain);
                 newEntry->sameNameInOuterLevel = hashChain;
                 break;
             }
@@ -149,27 +316,27 @@ SymbolTableEntry *enterSymbol (char *symbolName, SymbolAttribute *attribute) {
             hashChain = hashChain->nextInHashChain;
         }
     }
-    enterIntoHashTrain(hashIndex, newEntry);
-    newEntry->nextInSameLevel = symbolTable.scopeDisplay[symbolTable.currentLevel];
-    symbolTable.scopeDisplay[symbolTable.currentLevel] = newEntry;
+    enterIntoHashTrain(ctx, hashIndex, newEntry);
+    newEntry->nextInSameLevel = ctx->symbolTable.scopeDisplay[ctx->symbolTable.currentLevel];
+    ctx->symbolTable.scopeDisplay[ctx->symbolTable.currentLevel] = newEntry;
 
     return newEntry;
 }
 
 //remove the symbol from the current scope
-void removeSymbol (char *symbolName) {
-    int hashIndex = HASH(symbolName);
-    SymbolTableEntry *hashChain = symbolTable.hashTable[hashIndex];
+void removeSymbol (CompilerContext *ctx, char *symbolName) {
+    int hashIndex = bucketOf(ctx, symbolName);
+    SymbolTableEntry *hashChain = ctx->symbolTable.hashTable[hashIndex];
     while (hashChain) {
-        if (strcmp(hashChain->name, symbolName) == 0) {
-            if (hashChain->nestingLevel != symbolTable.currentLevel) {
-                printf("void removeSymbol(...) Error: try to removed ID \'%s\' from the scope other than currentScope.\n", symbolName);
+        if (hashChain->name == symbolName) {
+            if (hashChain->nestingLevel != ctx->symbolTable.currentLevel) {
+                fprintf(ctx->diagnostics, "void removeSymbol(...) Error: try to removed ID \'%s\' from the scope other than currentScope.\n", symbolName);
                 return;
             }
             else {
-                removeFromHashTrain(hashIndex, hashChain);
+                removeFromHashTrain(ctx, hashIndex, hashChain);
                 if (hashChain->sameNameInOuterLevel) {
-                    enterIntoHashTrain(hashIndex, hashChain->sameNameInOuterLevel);
+                    enterIntoHashTrain(ctx, hashIndex, hashChain->sameNameInOuterLevel);
                 }
                 break;
             }
@@ -180,21 +347,20 @@ void removeSymbol (char *symbolName) {
     }
 
     if (!hashChain) {
-        printf("void removeSymbol(...) Error: try to removed ID \'%s\' not in the symbol table.\n", symbolName);
+        fprintf(ctx->diagnostics, "void removeSymbol(...) Error: try to removed ID \'%s\' not in the symbol table.\n", symbolName);
         return;
     }
 
     SymbolTableEntry *tmpPrev = NULL;
-    SymbolTableEntry *scopeChain = symbolTable.scopeDisplay[symbolTable.currentLevel];
+    SymbolTableEntry *scopeChain = ctx->symbolTable.scopeDisplay[ctx->symbolTable.currentLevel];
     while (scopeChain) {
-        if (strcmp(scopeChain->name, symbolName) == 0) {
+        if (scopeChain->name == symbolName) {
             if (tmpPrev) {
                 tmpPrev->nextInSameLevel = scopeChain->nextInSameLevel;
             }
             else {
-                symbolTable.scopeDisplay[symbolTable.currentLevel] = scopeChain->nextInSameLevel;
+                ctx->symbolTable.scopeDisplay[ctx->symbolTable.currentLevel] = scopeChain->nextInSameLevel;
             }
-            free(scopeChain);
             break;
         }
         else {
@@ -204,12 +370,12 @@ void removeSymbol (char *symbolName) {
     }
 }
 
-int declaredLocally (char *symbolName) {
-    int hashIndex = HASH(symbolName);
-    SymbolTableEntry *hashChain = symbolTable.hashTable[hashIndex];
+int declaredLocally (CompilerContext *ctx, char *symbolName) {
+    int hashIndex = bucketOf(ctx, symbolName);
+    SymbolTableEntry *hashChain = ctx->symbolTable.hashTable[hashIndex];
     while (hashChain) {
-        if (strcmp(hashChain->name, symbolName) == 0) {
-            if (hashChain->nestingLevel == symbolTable.currentLevel) {
+        if (hashChain->name == symbolName) {
+            if (hashChain->nestingLevel == ctx->symbolTable.currentLevel) {
                 return 1;
             }
             else {
@@ -223,42 +389,47 @@ int declaredLocally (char *symbolName) {
     return 0;
 }
 
-void openScope (void) {
-    ++symbolTable.currentLevel;
-    if (symbolTable.currentLevel == symbolTable.scopeDisplayElementCount) {
-        SymbolTableEntry **oldScopeDisplay = symbolTable.scopeDisplay;
-        symbolTable.scopeDisplay = (SymbolTableEntry **)malloc(symbolTable.scopeDisplayElementCount * 2 * sizeof(SymbolTableEntry*));
-        memcpy(symbolTable.scopeDisplay, oldScopeDisplay, symbolTable.scopeDisplayElementCount * sizeof(SymbolTableEntry*));
+void openScope (CompilerContext *ctx) {
+    ++ctx->symbolTable.currentLevel;
+    if (ctx->symbolTable.currentLevel == ctx->symbolTable.scopeDisplayElementCount) {
+        SymbolTableEntry **oldScopeDisplay = ctx->symbolTable.scopeDisplay;
+        ctx->symbolTable.scopeDisplay = (SymbolTableEntry **)malloc(ctx->symbolTable.scopeDisplayElementCount * 2 * sizeof(SymbolTableEntry*));
+        if (!ctx->symbolTable.scopeDisplay) {
+            ctx->symbolTable.scopeDisplay = oldScopeDisplay;
+            --ctx->symbolTable.currentLevel;
+            compileFailed(ctx, "out of memory");
+        }
+        memcpy(ctx->symbolTable.scopeDisplay, oldScopeDisplay, ctx->symbolTable.scopeDisplayElementCount * sizeof(SymbolTableEntry*));
         int index = 0;
-        for (index = symbolTable.scopeDisplayElementCount; index != symbolTable.scopeDisplayElementCount * 2; ++index) {
-            symbolTable.scopeDisplay[index] = NULL;
+        for (index = ctx->symbolTable.scopeDisplayElementCount; index != ctx->symbolTable.scopeDisplayElementCount * 2; ++index) {
+            ctx->symbolTable.scopeDisplay[index] = NULL;
         }
-        symbolTable.scopeDisplayElementCount = 2 * symbolTable.scopeDisplayElementCount;
+        ctx->symbolTable.scopeDisplayElementCount = 2 * ctx->symbolTable.scopeDisplayElementCount;
         free(oldScopeDisplay);
     }
     //
-    symbolTable.scopeDisplay[symbolTable.currentLevel] = NULL;
+    ctx->symbolTable.scopeDisplay[ctx->symbolTable.currentLevel] = NULL;
     //
 }
 
-void closeScope (void) {
-    if (symbolTable.currentLevel < 0) {
-        printf("void closeScope(): Error: current level < 0. No scope can be close.\n");
+void closeScope (CompilerContext *ctx) {
+    if (ctx->symbolTable.currentLevel < 0) {
+        fprintf(ctx->diagnostics, "void closeScope(): Error: current level < 0. No scope can be close.\n");
         return;
     }
-    SymbolTableEntry *scopeChain = symbolTable.scopeDisplay[symbolTable.currentLevel];
+    SymbolTableEntry *scopeChain = ctx->symbolTable.scopeDisplay[ctx->symbolTable.currentLevel];
     SymbolTableEntry *nextScopeChain = NULL;
     while (scopeChain) {
-        int hashIndex = HASH(scopeChain->name);
-        removeFromHashTrain(hashIndex, scopeChain);
+        int hashIndex = bucketOf(ctx, scopeChain->name);
+        removeFromHashTrain(ctx, hashIndex, scopeChain);
         if (scopeChain->sameNameInOuterLevel) {
-            enterIntoHashTrain(hashIndex, scopeChain->sameNameInOuterLevel);
+            enterIntoHashTrain(ctx, hashIndex, scopeChain->sameNameInOuterLevel);
         }
         nextScopeChain = scopeChain->nextInSameLevel;
         scopeChain = nextScopeChain;
     }
     //
-    symbolTable.scopeDisplay[symbolTable.currentLevel] = NULL;
+    ctx->symbolTable.scopeDisplay[ctx->symbolTable.currentLevel] = NULL;
     //
-    --symbolTable.currentLevel;
+    --ctx->symbolTable.currentLevel;
 }
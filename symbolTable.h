@@ -10,7 +10,9 @@
 #define SYMBOL_TABLE_VOID_NAME     "void"
 #define SYMBOL_TABLE_SYS_LIB_READ  "read"
 #define SYMBOL_TABLE_SYS_LIB_FREAD "fread"
-#define HASH_TABLE_SIZE 256
+#define SYMBOL_TABLE_SYS_LIB_WRITE "write"
+#define SYMBOL_TABLE_MAIN_NAME     "main"
+#define HASH_TABLE_INITIAL_SIZE 256
 
 
 typedef enum SymbolAttributeKind {
@@ -84,20 +86,39 @@ typedef struct SymbolTableEntry {
 } SymbolTableEntry;
 
 typedef struct SymbolTable {
-    SymbolTableEntry *hashTable[HASH_TABLE_SIZE];
+    // chained, the size is a power of two and doubles when the visible
+    // names pass 3/4 of it
+    SymbolTableEntry **hashTable;
+    int hashTableSize;
+    int hashEntryCount;
     SymbolTableEntry **scopeDisplay;
     int currentLevel;
     int scopeDisplayElementCount;
 } SymbolTable;
 
 
-void initializeSymbolTable(void);
-void symbolTableEnd(void);
-SymbolTableEntry *retrieveSymbol(char *symbolName);
-SymbolTableEntry *enterSymbol(char *symbolName, SymbolAttribute *attribute);
-void removeSymbol(char *symbolName);
-int declaredLocally(char *symbolName);
-void openScope(void);
-void closeScope(void);
+// the one copy of `name` in `ctx`, the names given to the functions below
+// have to come from here, they are compared by pointer
+char *internName(CompilerContext *ctx, const char *name);
+// the same for the `length` characters at `name`
+char *internSlice(CompilerContext *ctx, const char *name, size_t length);
+// the hash of an interned name, computed once
+unsigned int internedHash(const char *name);
+// the builtin names (ctx->internedInt, ...), interned before anything else,
+// by the first internName() or explicitly. the parser uses them while the
+// lexer thread may be interning
+void initializeInternTable(CompilerContext *ctx);
+
+// the hash the symbol table and the intern table use
+unsigned int HASH(char *str);
+void initializeSymbolTable(CompilerContext *ctx);
+// also drops the intern table
+void symbolTableEnd(CompilerContext *ctx);
+SymbolTableEntry *retrieveSymbol(CompilerContext *ctx, char *symbolName);
+SymbolTableEntry *enterSymbol(CompilerContext *ctx, char *symbolName, SymbolAttribute *attribute);
+void removeSymbol(CompilerContext *ctx, char *symbolName);
+int declaredLocally(CompilerContext *ctx, char *symbolName);
+void openScope(CompilerContext *ctx);
+void closeScope(CompilerContext *ctx);
 
 #endif
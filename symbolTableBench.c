@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "symbolTable.h"
+#include "compilerContext.h"
+
+
+// microbenchmark of the symbol table: interning, inserts, lookups that hit
+// and miss, and shadowing a whole scope and closing it, with generated
+// names like the ones machine generated sources use (var_000001, ...)
+//
+// usage: symbolTableBench [symbols]
+
+
+static CompilerContext context;
+static CompilerContext *ctx = &context;
+static char **names;
+static char **missing;
+static int symbolCount = 200000;
+static SymbolAttribute attribute;
+static double phaseStart;
+
+
+static double wallClock (void) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+
+static void startPhase (void) {
+    phaseStart = wallClock();
+}
+
+
+static void endPhase (const char *name, long long operations) {
+    double seconds = wallClock() - phaseStart;
+    printf("%-24s %10lld %10.1f\n", name, operations, seconds * 1e9 / operations);
+}
+
+
+static void check (int ok, const char *what) {
+    if (!ok) {
+        fprintf(stderr, "symbolTableBench: %s\n", what);
+        exit(1);
+    }
+}
+
+
+int main (int argc, char *argv[]) {
+    char buf[32];
+    int i, round;
+
+    if (argc > 1)
+        symbolCount = atoi(argv[1]);
+    if (symbolCount <= 0) {
+        fprintf(stderr, "usage: symbolTableBench [symbols]\n");
+        return 2;
+    }
+
+    names = (char **)malloc(symbolCount * sizeof(char *));
+    missing = (char **)malloc(symbolCount * sizeof(char *));
+    check(names && missing, "out of memory");
+    attribute.attributeKind = VARIABLE_ATTRIBUTE;
+
+    initializeContext(ctx);
+    printf("%-24s %10s %10s\n", "phase", "ops", "ns/op");
+
+    startPhase();
+    for (i = 0; i < symbolCount; ++i) {
+        snprintf(buf, sizeof(buf), "var_%06d", i);
+        names[i] = internName(ctx, buf);
+    }
+    endPhase("intern", symbolCount);
+
+    for (i = 0; i < symbolCount; ++i) {
+        snprintf(buf, sizeof(buf), "tmp_%06d", i);
+        missing[i] = internName(ctx, buf);
+    }
+
+    initializeSymbolTable(ctx);
+
+    startPhase();
+    for (i = 0; i < symbolCount; ++i)
+        enterSymbol(ctx, names[i], &attribute);
+    endPhase("insert", symbolCount);
+
+    startPhase();
+    for (round = 0; round < 10; ++round) {
+        for (i = 0; i < symbolCount; ++i)
+            check(retrieveSymbol(ctx, names[i]) != NULL, "lookup missed");
+    }
+    endPhase("lookup hit", 10LL * symbolCount);
+
+    startPhase();
+    for (i = 0; i < symbolCount; ++i)
+        check(retrieveSymbol(ctx, missing[i]) == NULL, "lookup of an undeclared name hit");
+    endPhase("lookup miss", symbolCount);
+
+    // shadow every global in one scope
+    openScope(ctx);
+    startPhase();
+    for (i = 0; i < symbolCount; ++i)
+        enterSymbol(ctx, names[i], &attribute);
+    endPhase("insert shadowing", symbolCount);
+
+    startPhase();
+    for (i = 0; i < symbolCount; ++i)
+        check(declaredLocally(ctx, names[i]), "shadowing name not local");
+    endPhase("declaredLocally", symbolCount);
+
+    startPhase();
+    closeScope(ctx);
+    endPhase("closeScope", symbolCount);
+
+    for (i = 0; i < symbolCount; ++i)
+        check(retrieveSymbol(ctx, names[i])->nestingLevel == 0, "closeScope left a local behind");
+
+    // many small scopes, like function bodies and blocks
+    startPhase();
+    for (round = 0; round < symbolCount / 10; ++round) {
+        openScope(ctx);
+        for (i = 0; i < 10; ++i)
+            enterSymbol(ctx, missing[round * 10 + i], &attribute);
+        closeScope(ctx);
+    }
+    endPhase("small scopes", symbolCount / 10 * 10);
+
+    printf("%-24s %10d\n", "buckets", ctx->symbolTable.hashTableSize);
+
+    symbolTableEnd(ctx);
+    arenaRelease();
+    free(names);
+    free(missing);
+    return 0;
+}
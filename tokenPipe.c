@@ -0,0 +1,194 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "header.h"
+#include "parser.tab.h"
+#include "tokenPipe.h"
+#include "compilerContext.h"
+
+
+// the lexer thread writes tokens at `head`, the parser reads them at
+// `tail`; both only ever grow and are taken modulo the ring size. each side
+// keeps a copy of the other one's counter and only reloads it when the ring
+// looks full or empty, and the lexer publishes `head` every PUBLISH_TOKENS
+// tokens, so the two cores don't trade the counters' cache lines per token
+
+
+#define TOKEN_RING_SIZE 4096
+#define PUBLISH_TOKENS 64
+// busy polls before giving the core away
+#define SPIN_LIMIT 256
+#define CACHE_LINE 64
+
+
+typedef struct PipedToken {
+    int kind;
+    int line;
+    YYSTYPE value;
+    const char *text;
+    int length;
+} PipedToken;
+
+
+// one per context, made by startLexerThread(). the counters shared by the
+// threads and the ones only either side uses are on cache lines of their own
+typedef struct TokenPipe {
+    PipedToken ring[TOKEN_RING_SIZE];
+    _Alignas(CACHE_LINE) atomic_size_t head;
+    _Alignas(CACHE_LINE) atomic_size_t tail;
+    _Alignas(CACHE_LINE) atomic_int stopping;
+
+    // the lexer thread's own
+    _Alignas(CACHE_LINE) size_t writeIndex;
+    size_t knownTail;
+    void *lexerChunks;
+
+    // the parser's own
+    _Alignas(CACHE_LINE) size_t readIndex;
+    size_t knownHead;
+    int endSeen;
+    const char *text;
+    int length;
+
+    CompilerContext *ctx;
+    pthread_t lexerThread;
+} TokenPipe;
+
+
+// from the scanner, lexer3.l's or scanner.c's
+char *yyget_text(void *scanner);
+int yyget_leng(void *scanner);
+
+
+static void waitABit (int *spins) {
+    if (++*spins < SPIN_LIMIT) {
+        return;
+    }
+    *spins = 0;
+    sched_yield();
+}
+
+
+static void *runLexer (void *argument) {
+    TokenPipe *tokenPipe = (TokenPipe *)argument;
+    CompilerContext *ctx = tokenPipe->ctx;
+    int kind;
+
+    do {
+        PipedToken *slot;
+        YYSTYPE value;
+        int spins = 0;
+
+        kind = scanToken(&value, ctx->scanner);
+
+        if (tokenPipe->writeIndex - tokenPipe->knownTail == TOKEN_RING_SIZE) {
+            // full, let the parser see everything before waiting on it
+            atomic_store_explicit(&tokenPipe->head, tokenPipe->writeIndex, memory_order_release);
+            while ((tokenPipe->knownTail = atomic_load_explicit(&tokenPipe->tail, memory_order_acquire)) + TOKEN_RING_SIZE == tokenPipe->writeIndex) {
+                if (atomic_load_explicit(&tokenPipe->stopping, memory_order_relaxed)) {
+                    goto done;
+                }
+                waitABit(&spins);
+            }
+        }
+
+        slot = &tokenPipe->ring[tokenPipe->writeIndex & (TOKEN_RING_SIZE - 1)];
+        slot->kind = kind;
+        slot->line = ctx->tokenLine;
+        slot->value = value;
+        slot->text = yyget_text(ctx->scanner);
+        slot->length = yyget_leng(ctx->scanner);
+        ++tokenPipe->writeIndex;
+
+        if (kind == 0 || tokenPipe->writeIndex % PUBLISH_TOKENS == 0) {
+            atomic_store_explicit(&tokenPipe->head, tokenPipe->writeIndex, memory_order_release);
+        }
+    } while (kind != 0);
+
+done:
+    tokenPipe->lexerChunks = arenaDetach();
+    return NULL;
+}
+
+
+void startLexerThread (CompilerContext *ctx) {
+    TokenPipe *tokenPipe = (TokenPipe *)aligned_alloc(CACHE_LINE, sizeof(TokenPipe));
+
+    // without a lexer thread the parser just scans on this one
+    if (tokenPipe == NULL) {
+        ctx->threadedLexer = 0;
+        return;
+    }
+    atomic_init(&tokenPipe->head, 0);
+    atomic_init(&tokenPipe->tail, 0);
+    atomic_init(&tokenPipe->stopping, 0);
+    tokenPipe->writeIndex = tokenPipe->knownTail = 0;
+    tokenPipe->readIndex = tokenPipe->knownHead = 0;
+    tokenPipe->endSeen = 0;
+    tokenPipe->lexerChunks = NULL;
+    tokenPipe->text = "";
+    tokenPipe->length = 0;
+    tokenPipe->ctx = ctx;
+    ctx->tokenPipe = tokenPipe;
+
+    if (pthread_create(&tokenPipe->lexerThread, NULL, runLexer, tokenPipe) != 0) {
+        free(tokenPipe);
+        ctx->tokenPipe = NULL;
+        ctx->threadedLexer = 0;
+    }
+}
+
+
+int nextPipedToken (CompilerContext *ctx, YYSTYPE *value) {
+    TokenPipe *tokenPipe = ctx->tokenPipe;
+    PipedToken *slot;
+    int kind;
+    int spins = 0;
+
+    if (tokenPipe->endSeen) {
+        return 0;
+    }
+
+    while (tokenPipe->readIndex == tokenPipe->knownHead) {
+        tokenPipe->knownHead = atomic_load_explicit(&tokenPipe->head, memory_order_acquire);
+        if (tokenPipe->readIndex == tokenPipe->knownHead) {
+            waitABit(&spins);
+        }
+    }
+
+    slot = &tokenPipe->ring[tokenPipe->readIndex & (TOKEN_RING_SIZE - 1)];
+    kind = slot->kind;
+    *value = slot->value;
+    ctx->linenumber = slot->line;
+    tokenPipe->text = slot->text;
+    tokenPipe->length = slot->length;
+    tokenPipe->endSeen = kind == 0;
+    ++tokenPipe->readIndex;
+
+    // the slot may be overwritten from here on. the lexer only looks at
+    // this when the ring is full
+    atomic_store_explicit(&tokenPipe->tail, tokenPipe->readIndex, memory_order_release);
+    return kind;
+}
+
+
+const char *pipedText (CompilerContext *ctx, int *length) {
+    *length = ctx->tokenPipe->length;
+    return ctx->tokenPipe->text;
+}
+
+
+void joinLexerThread (CompilerContext *ctx) {
+    TokenPipe *tokenPipe = ctx->tokenPipe;
+
+    atomic_store(&tokenPipe->stopping, 1);
+    pthread_join(tokenPipe->lexerThread, NULL);
+    arenaAttach(tokenPipe->lexerChunks);
+    free(tokenPipe);
+    ctx->tokenPipe = NULL;
+}
@@ -0,0 +1,30 @@
+#ifndef __TOKEN_PIPE_H__
+#define __TOKEN_PIPE_H__
+
+
+// between the scanner and the parser. the scanner (lexer3.l or scanner.c)
+// returns every token from scanToken(), with its value in *tokenValue, and
+// leaves the line it got to in its context's tokenLine; yylex() hands them
+// to the parser. YYSTYPE comes from parser.tab.h, include that first
+int scanToken(YYSTYPE *tokenValue, void *scanner);
+
+
+// --threaded-lexer (ctx->threadedLexer): scanToken() runs on a thread of
+// its own and passes the tokens through a single producer, single consumer
+// ring, so scanning overlaps with parsing
+
+// the lexer thread scans the buffer yy_scan_buffer() gave ctx->scanner up
+// to the end of the input. if it can't be started, ctx->threadedLexer is
+// cleared and the parser scans on its own thread
+void startLexerThread(CompilerContext *ctx);
+// the next token from the ring, with its value in *value and its line in
+// ctx->linenumber. the end of the input is returned again and again
+int nextPipedToken(CompilerContext *ctx, YYSTYPE *value);
+// the text of the last token nextPipedToken() returned, not NUL-terminated
+const char *pipedText(CompilerContext *ctx, int *length);
+// waits for the lexer thread, and gives the memory it allocated to this
+// thread's arena
+void joinLexerThread(CompilerContext *ctx);
+
+
+#endif // __TOKEN_PIPE_H__